@@ -0,0 +1,97 @@
+//
+// Runs many scripts in one process, each on its own interpreter, on a fixed size pool of workers.
+//
+
+#include "Batch.h"
+#include "../Concurrency/Thread_Pool.h"
+#include "../Program/Compiled_Program.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+namespace batch {
+    namespace {
+        Result runOne(const std::filesystem::path& path, std::size_t capacity, bool relaxed) {
+            Result result;
+            result.path = path;
+            auto start = std::chrono::steady_clock::now();
+            // the script prints here instead of std::cout so that the outputs of the batch do not interleave
+            std::ostringstream out;
+            try{
+                std::ifstream file(path);
+                if(!file)
+                    throw std::runtime_error("Unable to read file!");
+                std::stringstream ss;
+                ss << file.rdbuf();
+
+                program::CompiledProgram compiled(ss.str());
+                result.tokens = compiled.tokens();
+                compiled.run({}, out, capacity, relaxed);
+            }catch(const std::exception& e){
+                result.status = 1;
+                result.error = e.what();
+            }
+            result.output = out.str();
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return result;
+        }
+    }
+
+    std::vector<std::filesystem::path> scripts(const std::filesystem::path& source) {
+        std::vector<std::filesystem::path> paths;
+        if(std::filesystem::is_directory(source)){
+            for(const auto& entry : std::filesystem::recursive_directory_iterator(source)){
+                auto extension = entry.path().extension();
+                if(entry.is_regular_file() && (extension == ".tlng" || extension == ".tl2ng"))
+                    paths.emplace_back(entry.path());
+            }
+            std::sort(paths.begin(), paths.end());
+            return paths;
+        }
+        std::ifstream list(source);
+        if(!list)
+            throw std::runtime_error("Unable to read " + source.string() + "!");
+        std::string line;
+        while(std::getline(list, line)){
+            if(!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if(!line.empty())
+                paths.emplace_back(line);
+        }
+        return paths;
+    }
+
+    void run(const std::vector<std::filesystem::path>& scripts, unsigned int workers, std::size_t capacity, bool relaxed,
+             const std::function<void(const Result&)>& done) {
+        std::vector<Result> results(scripts.size());
+        std::vector<bool> finished(scripts.size(), false);
+        std::mutex lock;
+        std::condition_variable ready;
+        {
+            concurrency::ThreadPool pool(workers);
+            for(std::size_t i = 0; i < scripts.size(); ++i){
+                pool.submit([&, i](){
+                    auto result = runOne(scripts[i], capacity, relaxed);
+                    std::lock_guard<std::mutex> guard(lock);
+                    results[i] = std::move(result);
+                    finished[i] = true;
+                    ready.notify_all();
+                });
+            }
+            // Hand the results over in order while the later scripts are still running
+            for(std::size_t i = 0; i < scripts.size(); ++i){
+                Result result;
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    ready.wait(guard, [&finished, i](){ return finished[i]; });
+                    result = std::move(results[i]);
+                }
+                done(result);
+            }
+        }
+    }
+}
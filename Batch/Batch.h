@@ -0,0 +1,39 @@
+//
+// Runs many scripts in one process, each on its own interpreter, on a fixed size pool of workers.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_BATCH_H
+#define TEALANG_COMPILER_CPP20_BATCH_H
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace batch {
+    // How a script of the batch went
+    class Result {
+    public:
+        std::filesystem::path path;
+        // what the script printed, and the error that stopped it (empty if it ran to the end)
+        std::string output;
+        std::string error;
+        // 0 when the script ran to the end, 1 when it was stopped by an error
+        int status = 0;
+        std::size_t tokens = 0;
+        // wall time from reading the script to the end of its run
+        double seconds = 0;
+    };
+
+    // The scripts of a directory (every .tlng and .tl2ng file under it, ordered by path)
+    // or of a list file (a path on every line, blank lines are skipped)
+    std::vector<std::filesystem::path> scripts(const std::filesystem::path& source);
+
+    // Lex, parse, check and interpret every script on a pool of workers (0 for one per hardware thread)
+    // done is called on the calling thread with the result of every script in the order of scripts, as soon as it and those before it are over
+    void run(const std::vector<std::filesystem::path>& scripts, unsigned int workers, std::size_t capacity, bool relaxed,
+             const std::function<void(const Result&)>& done);
+}
+
+#endif //TEALANG_COMPILER_CPP20_BATCH_H
@@ -0,0 +1,123 @@
+//
+// Tasks written as C++20 coroutines, resumed on the work-stealing thread pool.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_TASK_H
+#define TEALANG_COMPILER_CPP20_TASK_H
+
+#include "Thread_Pool.h"
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace concurrency {
+    // Awaiting it moves the coroutine over to a worker of the pool, what comes after runs there
+    class Schedule {
+    public:
+        explicit Schedule(ThreadPool& pool) :
+                pool(pool)
+        {};
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            pool.submit([handle](){ handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+
+    private:
+        ThreadPool& pool;
+    };
+
+    inline Schedule schedule(ThreadPool& pool = ThreadPool::shared()) {
+        return Schedule(pool);
+    }
+
+    // The result of a coroutine that starts on the calling thread and is over once it returns (or throws).
+    // Waiting for it runs queued tasks of the pool in the meantime, like TaskGroup::wait, so tasks may
+    // wait for the tasks they started without deadlocking however few workers there are.
+    // The coroutine frame is kept until the task is destroyed, which waits for it first.
+    template <typename T>
+    class Task {
+    public:
+        class promise_type {
+        public:
+            Task get_return_object() {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            auto final_suspend() noexcept {
+                // done is only set once the coroutine is suspended for good, after that nothing touches the frame
+                class Final {
+                public:
+                    [[nodiscard]] bool await_ready() const noexcept { return false; }
+                    void await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                        handle.promise().done.store(true, std::memory_order_release);
+                    }
+                    void await_resume() const noexcept {}
+                };
+                return Final();
+            }
+            void return_value(T v) { value = std::move(v); }
+            void unhandled_exception() { error = std::current_exception(); }
+
+            std::optional<T> value;
+            std::exception_ptr error;
+            std::atomic<bool> done = false;
+        };
+
+        Task() = default;
+        Task(Task&& other) noexcept :
+                handle(std::exchange(other.handle, nullptr))
+        {};
+        Task& operator=(Task&& other) noexcept {
+            if(this != &other){
+                release();
+                handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+        ~Task() { release(); }
+
+        Task(Task const &) = delete;
+        Task& operator=(Task const &) = delete;
+
+        [[nodiscard]] bool ready() const {
+            return handle == nullptr || handle.promise().done.load(std::memory_order_acquire);
+        }
+
+        // Blocks until the coroutine is over, running tasks of pool in the meantime
+        void wait(ThreadPool& pool = ThreadPool::shared()) const {
+            while(!ready())
+                if(!pool.tryRun())
+                    std::this_thread::yield();
+        }
+
+        // What the coroutine returned, rethrows what it threw
+        const T& get(ThreadPool& pool = ThreadPool::shared()) const {
+            wait(pool);
+            if(handle.promise().error)
+                std::rethrow_exception(handle.promise().error);
+            return *handle.promise().value;
+        }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> handle) :
+                handle(handle)
+        {};
+
+        void release() {
+            if(handle == nullptr)
+                return;
+            wait();
+            handle.destroy();
+            handle = nullptr;
+        }
+
+        std::coroutine_handle<promise_type> handle = nullptr;
+    };
+}
+
+#endif //TEALANG_COMPILER_CPP20_TASK_H
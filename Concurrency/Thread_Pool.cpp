@@ -0,0 +1,150 @@
+//
+// Work-stealing thread pool shared by the semantic analyser and interpreter.
+//
+
+#include "Thread_Pool.h"
+
+namespace concurrency {
+    // index of the worker owned by the current thread, -1 outside of any pool
+    static thread_local int workerIndex = -1;
+    static thread_local ThreadPool* workerPool = nullptr;
+
+    ThreadPool::ThreadPool(unsigned int workers) :
+            queued(0),
+            next(0),
+            stopping(false)
+    {
+        if(workers == 0)
+            workers = std::max(1u, std::thread::hardware_concurrency());
+        for(unsigned int i = 0; i < workers; ++i)
+            queues.emplace_back(std::make_unique<Worker>());
+        for(unsigned int i = 0; i < workers; ++i)
+            threads.emplace_back(&ThreadPool::work, this, i);
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for(auto &thread : threads)
+            thread.join();
+    }
+
+    ThreadPool& ThreadPool::shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    void ThreadPool::submit(std::function<void()> task) {
+        // Workers push onto their own deque, everyone else is spread round robin
+        std::size_t index = (workerPool == this) ? workerIndex : next++ % queues.size();
+        {
+            // counted before it is pushed so that a worker taking it right away never brings the count below 0
+            // taking the lock orders the increment with a thread checking the predicate
+            std::lock_guard<std::mutex> guard(sleepLock);
+            ++queued;
+        }
+        {
+            std::lock_guard<std::mutex> guard(queues.at(index)->lock);
+            queues.at(index)->tasks.emplace_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    bool ThreadPool::pop(unsigned int index, std::function<void()>& task) {
+        // Own deque first (newest task)
+        if(index < queues.size()){
+            auto &own = *queues.at(index);
+            std::lock_guard<std::mutex> guard(own.lock);
+            if(!own.tasks.empty()){
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                --queued;
+                return true;
+            }
+        }
+        // Steal the oldest task from the others
+        for(std::size_t i = 1; i <= queues.size(); ++i){
+            auto &victim = *queues.at((index + i) % queues.size());
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if(!victim.tasks.empty()){
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                --queued;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool ThreadPool::tryRun() {
+        std::function<void()> task;
+        unsigned int index = (workerPool == this) ? workerIndex : queues.size();
+        if(!pop(index, task))
+            return false;
+        task();
+        return true;
+    }
+
+    void ThreadPool::idle(const std::function<bool()>& done) {
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait(guard, [this, &done](){ return done() || queued > 0 || stopping; });
+    }
+
+    void ThreadPool::notify() {
+        {
+            // a thread in idle has either not checked done yet or is already waiting
+            std::lock_guard<std::mutex> guard(sleepLock);
+        }
+        wake.notify_all();
+    }
+
+    void ThreadPool::work(unsigned int index) {
+        workerIndex = (int) index;
+        workerPool = this;
+        std::function<void()> task;
+        while(true){
+            if(pop(index, task)){
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(sleepLock);
+            wake.wait(guard, [this](){ return stopping || queued > 0; });
+            if(stopping && queued == 0)
+                return;
+        }
+    }
+
+    void TaskGroup::run(std::function<void()> task) {
+        ++pending;
+        pool.submit([this, task = std::move(task)](){
+            try{
+                task();
+            }catch(...){
+                std::lock_guard<std::mutex> guard(errorLock);
+                if(!error) error = std::current_exception();
+            }
+            // the group may be gone as soon as the last task is counted out
+            auto& p = pool;
+            if(--pending == 0)
+                p.notify();
+        });
+    }
+
+    void TaskGroup::wait() {
+        // Help out instead of sleeping, the tasks we run may belong to other groups
+        // once there is nothing left to help with sleep until the tasks taken by others are over (or more are queued)
+        while(pending > 0){
+            if(!pool.tryRun())
+                pool.idle([this](){ return pending == 0; });
+        }
+        if(error){
+            auto rethrow = error;
+            error = nullptr;
+            std::rethrow_exception(rethrow);
+        }
+    }
+}
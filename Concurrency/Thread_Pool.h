@@ -0,0 +1,112 @@
+//
+// Work-stealing thread pool shared by the semantic analyser and interpreter.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_THREAD_POOL_H
+#define TEALANG_COMPILER_CPP20_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace concurrency {
+    // Fixed size pool where every worker owns a deque of tasks.
+    // A worker pops its own tasks from the back (LIFO, cache friendly) and when
+    // it runs out it steals from the front of the other workers' deques (FIFO).
+    class ThreadPool {
+    public:
+        // 0 workers means one per hardware thread
+        explicit ThreadPool(unsigned int workers = 0);
+        ~ThreadPool();
+
+        ThreadPool(ThreadPool const &) = delete;
+        ThreadPool& operator=(ThreadPool const &) = delete;
+
+        // Queue a task, tasks submitted from a worker go to that worker's deque
+        void submit(std::function<void()> task);
+        // Run one queued task on the calling thread (if any), used by waiting threads to help
+        bool tryRun();
+        // Block the calling thread until done holds, a task is queued or the pool stops
+        void idle(const std::function<bool()>& done);
+        // Wake the threads in idle once what their done checks may have changed
+        void notify();
+        [[nodiscard]] unsigned int size() const { return threads.size(); }
+
+        // Process wide pool
+        static ThreadPool& shared();
+
+    private:
+        struct Worker {
+            std::deque<std::function<void()>> tasks;
+            std::mutex lock;
+        };
+
+        std::vector<std::unique_ptr<Worker>> queues;
+        std::vector<std::thread> threads;
+        // number of tasks sitting in the queues
+        std::atomic<std::size_t> queued;
+        // round robin target for tasks submitted from outside the pool
+        std::atomic<std::size_t> next;
+        std::mutex sleepLock;
+        std::condition_variable wake;
+        bool stopping;
+
+        void work(unsigned int index);
+        bool pop(unsigned int index, std::function<void()>& task);
+    };
+
+    // Group of tasks that can be waited on together.
+    // The waiting thread executes queued tasks instead of blocking which
+    // makes nested groups (tasks that spawn and wait on tasks) deadlock free.
+    // It only blocks while no task is queued, any task queued wakes it up to help again.
+    class TaskGroup {
+    public:
+        explicit TaskGroup(ThreadPool& pool = ThreadPool::shared()) :
+                pool(pool),
+                pending(0)
+        {};
+        ~TaskGroup() = default;
+
+        void run(std::function<void()> task);
+        // Blocks until every task in the group has finished, rethrows the first exception raised by a task
+        void wait();
+
+    private:
+        ThreadPool& pool;
+        std::atomic<std::size_t> pending;
+        std::mutex errorLock;
+        std::exception_ptr error;
+    };
+
+    // Calls f(i) for every i in [begin, end) splitting the range into chunks of grain iterations
+    template <typename F>
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t grain, F f, ThreadPool& pool = ThreadPool::shared()) {
+        if(begin >= end) return;
+        if(grain == 0) grain = 1;
+        // Not worth going through the pool
+        if(pool.size() <= 1 || end - begin <= grain){
+            for(std::size_t i = begin; i < end; ++i)
+                f(i);
+            return;
+        }
+        TaskGroup group(pool);
+        for(std::size_t from = begin; from < end; from += grain){
+            std::size_t to = std::min(end, from + grain);
+            group.run([from, to, &f](){
+                for(std::size_t i = from; i < to; ++i)
+                    f(i);
+            });
+        }
+        group.wait();
+    }
+}
+
+#endif //TEALANG_COMPILER_CPP20_THREAD_POOL_H
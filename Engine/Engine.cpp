@@ -0,0 +1,38 @@
+//
+// The interpreter embedded in a C++ program: TeaLang functions called with C++ values, no process or stdout in between.
+//
+
+#include "Engine.h"
+
+namespace engine {
+    Engine::Engine(const std::string &source, const std::map<std::string, interpreter::Value> &globals, std::ostream &out,
+                   std::size_t capacity, bool relaxed) :
+            Engine(std::make_shared<const program::CompiledProgram>(source), globals, out, capacity, relaxed)
+    {}
+
+    Engine::Engine(std::shared_ptr<const program::CompiledProgram> program, const std::map<std::string, interpreter::Value> &globals,
+                   std::ostream &out, std::size_t capacity, bool relaxed) :
+            compiled(std::move(program)),
+            interpreter(std::make_unique<visitor::Interpreter>(capacity, relaxed, out))
+    {
+        compiled -> run(*interpreter, globals);
+    }
+
+    parser::ASTFunctionDeclarationNode* Engine::declaration(const std::string &name, const std::vector<std::string> &paramTypes) {
+        auto callee = interpreter -> declaration(name, paramTypes);
+        if(callee == nullptr){
+            std::string signature;
+            for(const auto& type : paramTypes)
+                signature += (signature.empty() ? "" : ", ") + type;
+            throw std::runtime_error("Function with identifier " + name + "(" + signature + ") has not been declared.");
+        }
+        return callee;
+    }
+
+    const interpreter::Value& Engine::value(const std::string &name) const {
+        auto value = interpreter -> global(name);
+        if(value == nullptr)
+            throw std::runtime_error("Variable with identifier " + name + " has not been declared.");
+        return *value;
+    }
+}
@@ -0,0 +1,157 @@
+//
+// The interpreter embedded in a C++ program: TeaLang functions called with C++ values, no process or stdout in between.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_ENGINE_H
+#define TEALANG_COMPILER_CPP20_ENGINE_H
+
+#include "../Program/Compiled_Program.h"
+#include "../Visitor/Interpreter_Visitor.h"
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace engine {
+    // How a C++ value crosses over to TeaLang and back
+    // int, float, bool, char and std::string are the TeaLang types of the same name, std::vector<T> an array of T
+    // interpreter::Value goes through as it is (tlstruct instances, task handles)
+    template <typename T>
+    class Convert {
+    public:
+        // The TeaLang type of a T (of its elements for arrays), functions are told apart by the types of their parameters
+        static std::string type() {
+            if constexpr (std::is_same_v<T, int>) return "int";
+            else if constexpr (std::is_same_v<T, float>) return "float";
+            else if constexpr (std::is_same_v<T, bool>) return "bool";
+            else if constexpr (std::is_same_v<T, char>) return "char";
+            else if constexpr (std::is_same_v<T, std::string>) return "string";
+            else{
+                static_assert(array, "Only int, float, bool, char, string and arrays of them have a type of their own.");
+                return Convert<typename T::value_type>::type();
+            }
+        }
+
+        static interpreter::Value to(T value) {
+            if constexpr (array)
+                return interpreter::Array<typename T::value_type>(std::move(value));
+            else
+                return interpreter::Value(std::move(value));
+        }
+
+        // Throws std::runtime_error if value does not hold a T
+        static T from(interpreter::Value value) {
+            if constexpr (std::is_same_v<T, interpreter::Value>){
+                return value;
+            }else{
+                if constexpr (array){
+                    if(auto elements = std::get_if<interpreter::Array<typename T::value_type>>(&value))
+                        return elements -> read();
+                }else{
+                    if(auto scalar = std::get_if<T>(&value))
+                        return std::move(*scalar);
+                }
+                throw std::runtime_error("Value of type " + value.type() + (value.isArray() ? "[]" : "") + " is not of type "
+                                         + type() + (array ? "[]." : "."));
+            }
+        }
+
+    private:
+        static constexpr bool array = !std::is_same_v<T, std::string> && requires { typename T::value_type; };
+    };
+
+    // String literals are passed as strings
+    template <typename T>
+    using Host = std::conditional_t<std::is_convertible_v<T, std::string> && !std::is_same_v<std::decay_t<T>, interpreter::Value>,
+                                    std::string, std::decay_t<T>>;
+
+    template <typename Signature>
+    class Function;
+
+    // A global function found once and called any number of times, it is only valid as long as the engine it came from
+    template <typename R, typename... Args>
+    class Function<R(Args...)> {
+    public:
+        R operator()(Args... args) const {
+            std::array<interpreter::Value, sizeof...(Args)> arguments{Convert<Args>::to(std::move(args))...};
+            return Convert<R>::from(interpreter -> invoke(callee, arguments.data(), arguments.size()));
+        }
+
+    private:
+        friend class Engine;
+        static std::vector<std::string> types() {
+            return {Convert<Args>::type()...};
+        }
+
+        Function(visitor::Interpreter* interpreter, parser::ASTFunctionDeclarationNode* callee) :
+                interpreter(interpreter),
+                callee(callee)
+        {};
+
+        visitor::Interpreter* interpreter;
+        parser::ASTFunctionDeclarationNode* callee;
+    };
+
+    // A program run once (its top level declares the globals, functions and structs) whose functions are then called from C++.
+    // An engine is one interpreter, it is used by one thread at a time. Threads that need their own engine share the
+    // compiled program instead, it is lexed, parsed and checked once.
+    class Engine {
+    public:
+        // Throws std::runtime_error with the first lexical, syntax, semantic or runtime error of the program
+        // globals are given in place of what the top level let of the same name would give (see CompiledProgram::run)
+        explicit Engine(const std::string& source, const std::map<std::string, interpreter::Value>& globals = {},
+                        std::ostream& out = std::cout, std::size_t capacity = visitor::Interpreter::defaultCapacity, bool relaxed = false);
+        explicit Engine(std::shared_ptr<const program::CompiledProgram> program, const std::map<std::string, interpreter::Value>& globals = {},
+                        std::ostream& out = std::cout, std::size_t capacity = visitor::Interpreter::defaultCapacity, bool relaxed = false);
+        ~Engine() = default;
+
+        Engine(Engine const &) = delete;
+        Engine& operator=(Engine const &) = delete;
+        Engine(Engine&&) = default;
+        Engine& operator=(Engine&&) = default;
+
+        // The global function name taking Args, throws std::runtime_error if there is none
+        template <typename Signature>
+        Function<Signature> function(const std::string& name) {
+            return Function<Signature>(interpreter.get(), declaration(name, Function<Signature>::types()));
+        }
+
+        // Call the global function name taking arguments of the types of args, the function is looked up on every call
+        template <typename R, typename... Args>
+        R call(const std::string& name, Args&&... args) {
+            std::array<interpreter::Value, sizeof...(Args)> arguments{Convert<Host<Args>>::to(Host<Args>(std::forward<Args>(args)))...};
+            std::vector<std::string> paramTypes;
+            paramTypes.reserve(arguments.size());
+            for(const auto& argument : arguments)
+                paramTypes.emplace_back(argument.type());
+            auto callee = declaration(name, paramTypes);
+            return Convert<R>::from(interpreter -> invoke(callee, arguments.data(), arguments.size()));
+        }
+
+        // The value of the global variable name, throws std::runtime_error if there is none or it does not hold a T
+        template <typename T>
+        T global(const std::string& name) const {
+            return Convert<T>::from(value(name));
+        }
+
+        [[nodiscard]] const std::shared_ptr<const program::CompiledProgram>& program() const { return compiled; }
+
+    private:
+        // Throws std::runtime_error if there is no such function
+        parser::ASTFunctionDeclarationNode* declaration(const std::string& name, const std::vector<std::string>& paramTypes);
+        [[nodiscard]] const interpreter::Value& value(const std::string& name) const;
+
+        std::shared_ptr<const program::CompiledProgram> compiled;
+        // kept apart so that the functions found stay valid when the engine is moved
+        std::unique_ptr<visitor::Interpreter> interpreter;
+    };
+}
+
+#endif //TEALANG_COMPILER_CPP20_ENGINE_H
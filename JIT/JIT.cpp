@@ -0,0 +1,132 @@
+//
+// Baseline JIT of the interpreter, hot numeric functions run as stencils stitched into executable memory.
+//
+
+#include "JIT.h"
+#include "../Visitor/JIT_Visitor.h"
+#include "../Visitor/Interpreter_Visitor.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define TEALANG_JIT 1
+#else
+#define TEALANG_JIT 0
+#endif
+
+namespace jit {
+    Code::Code(const std::vector<std::uint8_t> &bytes) :
+            memory(nullptr),
+            size(bytes.size())
+    {
+#if TEALANG_JIT
+        // written while it is not executable, then made executable while it is not writable
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(memory == MAP_FAILED)
+            throw std::runtime_error("Unable to map memory for the JIT.");
+        std::memcpy(memory, bytes.data(), size);
+        if(mprotect(memory, size, PROT_READ | PROT_EXEC) != 0){
+            munmap(memory, size);
+            throw std::runtime_error("Unable to make the code of the JIT executable.");
+        }
+#else
+        throw std::runtime_error("The JIT only runs on x86-64 Linux.");
+#endif
+    }
+
+    Code::~Code() {
+#if TEALANG_JIT
+        munmap(memory, size);
+#endif
+    }
+
+    bool Cache::run(parser::ASTFunctionDeclarationNode *function, const std::deque<interpreter::Value> &frames, std::size_t frame,
+                    std::size_t level, interpreter::Value &result) {
+#if TEALANG_JIT
+        auto& compiled = functions[function];
+        if(compiled.bailed != 0 && level >= compiled.bailed)
+            return false;
+        if(compiled.state == Function::COLD){
+            if(++compiled.calls < threshold && !visitor::JIT::loops(function->functionBlock.get()))
+                return false;
+            for(auto i = frame; i < frames.size(); ++i)
+                compiled.shape.emplace_back(frames[i].tag());
+            compile(function, compiled);
+        }
+        if(compiled.state != Function::COMPILED || frames.size() - frame != compiled.shape.size())
+            return false;
+
+        // The arguments into their slots, the code is only run for the tags it was compiled for
+        std::uint64_t slots[Cache::slots];
+        int next = 0;
+        for(std::size_t i = 0; i < compiled.shape.size(); ++i){
+            const auto& argument = frames[frame + i];
+            if(argument.tag() != compiled.shape[i])
+                return false;
+            switch (argument.tag()) {
+                case interpreter::Value::INT:
+                    slots[next++] = (std::uint32_t) std::get<int>(argument);
+                    break;
+                case interpreter::Value::FLOAT:
+                    slots[next++] = std::bit_cast<std::uint32_t>(std::get<float>(argument));
+                    break;
+                case interpreter::Value::BOOL:
+                    slots[next++] = std::get<bool>(argument) ? 1 : 0;
+                    break;
+                case interpreter::Value::INT_ARRAY: {
+                    const auto& elements = std::get<interpreter::Array<int>>(argument).read();
+                    slots[next++] = (std::uint64_t) elements.data();
+                    slots[next++] = elements.size();
+                    break;
+                }
+                case interpreter::Value::FLOAT_ARRAY: {
+                    const auto& elements = std::get<interpreter::Array<float>>(argument).read();
+                    slots[next++] = (std::uint64_t) elements.data();
+                    slots[next++] = elements.size();
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        // the calls nested by the code also have to fit on the native stack left
+        // each takes its slots, the saved registers, the return address and the pushed operands
+        std::uint64_t bytes = compiled.frame * sizeof(std::uint64_t) + 256;
+        auto r = compiled.code->entry()(slots, std::min<std::uint64_t>(depth, interpreter::available() / bytes));
+        if(r.status != 0){
+            compiled.bailed = level;
+            suspended.emplace_back(&compiled);
+            return false;
+        }
+        auto value = (std::uint32_t) r.value;
+        if(compiled.type == "int")
+            result = (int) value;
+        else if(compiled.type == "float")
+            result = std::bit_cast<float>(value);
+        else
+            result = value != 0;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void Cache::compile(parser::ASTFunctionDeclarationNode *declaration, Function &function) {
+        try{
+            visitor::JIT jit(function.shape);
+            declaration->accept(&jit);
+            function.code = std::make_unique<Code>(jit.code);
+            function.type = jit.type;
+            function.frame = jit.frame;
+            function.state = Function::COMPILED;
+        }catch(const UnsupportedException&){
+            function.state = Function::UNSUPPORTED;
+        }catch(const std::runtime_error&){
+            // no executable memory, the interpreter keeps running it
+            function.state = Function::UNSUPPORTED;
+        }
+    }
+}
@@ -0,0 +1,119 @@
+//
+// Baseline JIT of the interpreter, hot numeric functions run as stencils stitched into executable memory.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_JIT_H
+#define TEALANG_COMPILER_CPP20_JIT_H
+
+#include "Stencils.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace parser {
+    class ASTFunctionDeclarationNode;
+}
+
+namespace interpreter {
+    class Value;
+}
+
+namespace jit {
+    // Thrown while stitching a function that uses anything the stencils do not cover
+    class UnsupportedException : public std::exception {
+        [[nodiscard]] const char *what() const noexcept override {
+            return "Function Not Supported By The JIT Design Exception";
+        }
+    };
+
+    // {status, value}, status is 0 when the function returned and 1 when it bailed out
+    class Result {
+    public:
+        std::uint64_t status;
+        std::uint64_t value;
+    };
+    typedef Result (*Entry)(std::uint64_t* slots, std::uint64_t depth);
+
+    // Executable copy of stitched stencils
+    class Code {
+    public:
+        explicit Code(const std::vector<std::uint8_t>& bytes);
+        Code(const Code&) = delete;
+        Code& operator=(const Code&) = delete;
+        ~Code();
+
+        [[nodiscard]] Entry entry() const { return (Entry) memory; }
+
+    private:
+        void* memory;
+        std::size_t size;
+    };
+
+    // A global function as seen by the JIT, compiled for the tags of the arguments of the call that made it hot
+    // Functions only read their parameters and write their own locals so a function that bails out
+    // (an index out of bounds, a division by zero, calls nested too deep) is simply run again by the interpreter
+    class Function {
+    public:
+        enum STATE {COLD, COMPILED, UNSUPPORTED};
+
+        Function() :
+                calls(0),
+                state(COLD),
+                frame(0),
+                bailed(0)
+        {};
+
+        unsigned int calls;
+        STATE state;
+        // the tags of the arguments the code was compiled for
+        std::vector<int> shape;
+        // return type and number of slots
+        std::string type;
+        int frame;
+        std::unique_ptr<Code> code;
+        // the depth of the interpreter call the code last bailed out of, 0 once the interpreter left it
+        std::size_t bailed;
+    };
+
+    class Cache {
+    public:
+        // Calls before a function is compiled, a function with a loop is hot on its first call
+        static constexpr unsigned int threshold = 2;
+        // Calls the compiled code may nest before it bails out
+        static constexpr std::uint64_t depth = 1 << 12;
+        // Slots a compiled call may use
+        static constexpr int slots = 256;
+
+        // Run the call of function with the arguments from frames[frame], true if result was set
+        // false if the interpreter has to run it (as its call at level, the depth it would be run at)
+        // Once the code bailed out it is not run again for calls at that level or deeper until the interpreter left the call
+        // that bailed out, otherwise every call nested in it would run the code up to the depth limit and bail out again
+        bool run(parser::ASTFunctionDeclarationNode* function, const std::deque<interpreter::Value>& frames, std::size_t frame,
+                 std::size_t level, interpreter::Value& result);
+
+        // The interpreter left its call at level (returned or unwound past it)
+        void leave(std::size_t level) {
+            while(!suspended.empty() && suspended.back()->bailed >= level){
+                suspended.back()->bailed = 0;
+                suspended.pop_back();
+            }
+        }
+
+    private:
+        // The functions that bailed out of calls the interpreter is still in, deepest last
+        std::vector<Function*> suspended;
+
+        // Python equivalent of:
+        // functions = {functionDeclarationNode: Function}
+        std::unordered_map<parser::ASTFunctionDeclarationNode*, Function> functions;
+
+        static void compile(parser::ASTFunctionDeclarationNode* declaration, Function& function);
+    };
+}
+
+#endif //TEALANG_COMPILER_CPP20_JIT_H
@@ -0,0 +1,121 @@
+//
+// Precompiled x86-64 machine code for each operation of the JIT, copied after each other and patched.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_STENCILS_H
+#define TEALANG_COMPILER_CPP20_STENCILS_H
+
+#include <cstdint>
+
+namespace jit {
+    // The registers every stencil agrees on:
+    // rdi points at the slots of the running call (8 bytes each, int/float/bool in the low 4 bytes)
+    // rsi is the number of calls that may still be made, eax holds the value of the last expression
+    // ecx is the right operand of a binary operation, the left operand is pushed while the right one is evaluated
+    // rbp is the stack pointer on entry so that bailing out from anywhere leaves the call cleanly
+    //
+    // A compiled function returns {status, value} in rax:rdx, status is 0 when it returned and 1 when it bailed out
+    class Stencil {
+    public:
+        std::uint8_t bytes[24];
+        std::uint8_t size;
+        // offset of the 32 bit operand patched in when the stencil is copied, -1 if it has none
+        // the operand of a jump is relative to the end of the stencil so jumps always end with it
+        std::int8_t hole;
+    };
+
+    namespace stencil {
+        // push rbp; mov rbp, rsp; test rsi, rsi; je BAIL
+        inline constexpr Stencil ENTER = {{0x55, 0x48, 0x89, 0xE5, 0x48, 0x85, 0xF6, 0x0F, 0x84, 0, 0, 0, 0}, 13, 9};
+        // dec rsi
+        inline constexpr Stencil DEPTH = {{0x48, 0xFF, 0xCE}, 3, -1};
+        // mov edx, eax; xor eax, eax; mov rsp, rbp; pop rbp; ret
+        inline constexpr Stencil RETURN = {{0x89, 0xC2, 0x31, 0xC0, 0x48, 0x89, 0xEC, 0x5D, 0xC3}, 9, -1};
+        // mov eax, 1; mov rsp, rbp; pop rbp; ret
+        inline constexpr Stencil BAIL = {{0xB8, 0x01, 0x00, 0x00, 0x00, 0x48, 0x89, 0xEC, 0x5D, 0xC3}, 10, -1};
+
+        // mov eax, [rdi + SLOT]
+        inline constexpr Stencil LOAD = {{0x8B, 0x87, 0, 0, 0, 0}, 6, 2};
+        // mov [rdi + SLOT], eax
+        inline constexpr Stencil STORE = {{0x89, 0x87, 0, 0, 0, 0}, 6, 2};
+        // mov eax, VALUE
+        inline constexpr Stencil CONSTANT = {{0xB8, 0, 0, 0, 0}, 5, 1};
+        // push rax
+        inline constexpr Stencil PUSH = {{0x50}, 1, -1};
+        // mov ecx, eax; pop rax
+        inline constexpr Stencil OPERANDS = {{0x89, 0xC1, 0x58}, 3, -1};
+
+        // Arrays are passed as the address of their first element followed by their size
+        // movd xmm0, eax; cvttss2si eax, xmm0
+        inline constexpr Stencil TO_INDEX = {{0x66, 0x0F, 0x6E, 0xC0, 0xF3, 0x0F, 0x2C, 0xC0}, 8, -1};
+        // movsxd rax, eax; cmp rax, [rdi + SIZE_SLOT]; jae BAIL (negative indices are too large unsigned)
+        inline constexpr Stencil BOUNDS = {{0x48, 0x63, 0xC0, 0x48, 0x3B, 0x87, 0, 0, 0, 0}, 10, 6};
+        inline constexpr Stencil JUMP_IF_ABOVE_EQUAL = {{0x0F, 0x83, 0, 0, 0, 0}, 6, 2};
+        // mov rcx, [rdi + DATA_SLOT]; mov eax, [rcx + rax * 4]
+        inline constexpr Stencil ELEMENT = {{0x48, 0x8B, 0x8F, 0, 0, 0, 0, 0x8B, 0x04, 0x81}, 10, 3};
+
+        // add/sub/imul eax, ecx
+        inline constexpr Stencil ADD_INT = {{0x01, 0xC8}, 2, -1};
+        inline constexpr Stencil SUB_INT = {{0x29, 0xC8}, 2, -1};
+        inline constexpr Stencil MUL_INT = {{0x0F, 0xAF, 0xC1}, 3, -1};
+        // test ecx, ecx; je BAIL (the interpreter is left to fail on a division by zero)
+        inline constexpr Stencil DIVISOR = {{0x85, 0xC9, 0x0F, 0x84, 0, 0, 0, 0}, 8, 4};
+        // cdq; idiv ecx
+        inline constexpr Stencil DIV_INT = {{0x99, 0xF7, 0xF9}, 3, -1};
+        // cmp eax, ecx; setCC al; movzx eax, al
+        inline constexpr Stencil LT_INT = {{0x39, 0xC8, 0x0F, 0x9C, 0xC0, 0x0F, 0xB6, 0xC0}, 8, -1};
+        inline constexpr Stencil GT_INT = {{0x39, 0xC8, 0x0F, 0x9F, 0xC0, 0x0F, 0xB6, 0xC0}, 8, -1};
+        inline constexpr Stencil LE_INT = {{0x39, 0xC8, 0x0F, 0x9E, 0xC0, 0x0F, 0xB6, 0xC0}, 8, -1};
+        inline constexpr Stencil GE_INT = {{0x39, 0xC8, 0x0F, 0x9D, 0xC0, 0x0F, 0xB6, 0xC0}, 8, -1};
+        inline constexpr Stencil EQ_INT = {{0x39, 0xC8, 0x0F, 0x94, 0xC0, 0x0F, 0xB6, 0xC0}, 8, -1};
+        inline constexpr Stencil NE_INT = {{0x39, 0xC8, 0x0F, 0x95, 0xC0, 0x0F, 0xB6, 0xC0}, 8, -1};
+        // neg eax
+        inline constexpr Stencil NEG_INT = {{0xF7, 0xD8}, 2, -1};
+
+        // movd xmm0, eax; movd xmm1, ecx; OPss xmm0, xmm1; movd eax, xmm0
+        inline constexpr Stencil ADD_FLOAT = {{0x66, 0x0F, 0x6E, 0xC0, 0x66, 0x0F, 0x6E, 0xC9, 0xF3, 0x0F, 0x58, 0xC1, 0x66, 0x0F, 0x7E, 0xC0}, 16, -1};
+        inline constexpr Stencil SUB_FLOAT = {{0x66, 0x0F, 0x6E, 0xC0, 0x66, 0x0F, 0x6E, 0xC9, 0xF3, 0x0F, 0x5C, 0xC1, 0x66, 0x0F, 0x7E, 0xC0}, 16, -1};
+        inline constexpr Stencil MUL_FLOAT = {{0x66, 0x0F, 0x6E, 0xC0, 0x66, 0x0F, 0x6E, 0xC9, 0xF3, 0x0F, 0x59, 0xC1, 0x66, 0x0F, 0x7E, 0xC0}, 16, -1};
+        inline constexpr Stencil DIV_FLOAT = {{0x66, 0x0F, 0x6E, 0xC0, 0x66, 0x0F, 0x6E, 0xC9, 0xF3, 0x0F, 0x5E, 0xC1, 0x66, 0x0F, 0x7E, 0xC0}, 16, -1};
+        // movd xmm0, eax; movd xmm1, ecx; ucomiss; setCC al; movzx eax, al
+        // the comparisons are ordered so that they are false when an operand is NaN
+        inline constexpr Stencil LT_FLOAT = {{0x66, 0x0F, 0x6E, 0xC0, 0x66, 0x0F, 0x6E, 0xC9, 0x0F, 0x2E, 0xC8, 0x0F, 0x97, 0xC0, 0x0F, 0xB6, 0xC0}, 17, -1};
+        inline constexpr Stencil LE_FLOAT = {{0x66, 0x0F, 0x6E, 0xC0, 0x66, 0x0F, 0x6E, 0xC9, 0x0F, 0x2E, 0xC8, 0x0F, 0x93, 0xC0, 0x0F, 0xB6, 0xC0}, 17, -1};
+        inline constexpr Stencil GT_FLOAT = {{0x66, 0x0F, 0x6E, 0xC0, 0x66, 0x0F, 0x6E, 0xC9, 0x0F, 0x2E, 0xC1, 0x0F, 0x97, 0xC0, 0x0F, 0xB6, 0xC0}, 17, -1};
+        inline constexpr Stencil GE_FLOAT = {{0x66, 0x0F, 0x6E, 0xC0, 0x66, 0x0F, 0x6E, 0xC9, 0x0F, 0x2E, 0xC1, 0x0F, 0x93, 0xC0, 0x0F, 0xB6, 0xC0}, 17, -1};
+        // sete al; setnp cl; and al, cl (setne al; setp cl; or al, cl)
+        inline constexpr Stencil EQ_FLOAT = {{0x66, 0x0F, 0x6E, 0xC0, 0x66, 0x0F, 0x6E, 0xC9, 0x0F, 0x2E, 0xC1, 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8, 0x0F, 0xB6, 0xC0}, 22, -1};
+        inline constexpr Stencil NE_FLOAT = {{0x66, 0x0F, 0x6E, 0xC0, 0x66, 0x0F, 0x6E, 0xC9, 0x0F, 0x2E, 0xC1, 0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8, 0x0F, 0xB6, 0xC0}, 22, -1};
+        // xor eax, 0x80000000
+        inline constexpr Stencil NEG_FLOAT = {{0x35, 0x00, 0x00, 0x00, 0x80}, 5, -1};
+
+        // and/or eax, ecx (both operands are evaluated like the interpreter does)
+        inline constexpr Stencil AND = {{0x21, 0xC8}, 2, -1};
+        inline constexpr Stencil OR = {{0x09, 0xC8}, 2, -1};
+        // xor eax, 1
+        inline constexpr Stencil NOT = {{0x83, 0xF0, 0x01}, 3, -1};
+
+        // jmp TARGET
+        inline constexpr Stencil JUMP = {{0xE9, 0, 0, 0, 0}, 5, 1};
+        // test eax, eax; je TARGET
+        inline constexpr Stencil JUMP_IF_FALSE = {{0x85, 0xC0, 0x0F, 0x84, 0, 0, 0, 0}, 8, 4};
+
+        // A call to the function itself, the arguments are pushed in order
+        // push rdi; push rsi; sub rsp, FRAME
+        inline constexpr Stencil SAVE = {{0x57, 0x56, 0x48, 0x81, 0xEC, 0, 0, 0, 0}, 9, 5};
+        // mov rax, [rsp + OFFSET]; mov [rsp + OFFSET], rax
+        inline constexpr Stencil ARGUMENT = {{0x48, 0x8B, 0x84, 0x24, 0, 0, 0, 0}, 8, 4};
+        inline constexpr Stencil PARAMETER = {{0x48, 0x89, 0x84, 0x24, 0, 0, 0, 0}, 8, 4};
+        // mov rdi, rsp; call ENTRY
+        inline constexpr Stencil CALL = {{0x48, 0x89, 0xE7, 0xE8, 0, 0, 0, 0}, 8, 4};
+        // add rsp, FRAME; pop rsi; pop rdi; add rsp, ARGUMENTS
+        inline constexpr Stencil RESTORE = {{0x48, 0x81, 0xC4, 0, 0, 0, 0, 0x5E, 0x5F}, 9, 3};
+        inline constexpr Stencil DROP = {{0x48, 0x81, 0xC4, 0, 0, 0, 0}, 7, 3};
+        // test eax, eax; jne BAIL (the callee bailed out)
+        inline constexpr Stencil JUMP_IF_BAILED = {{0x85, 0xC0, 0x0F, 0x85, 0, 0, 0, 0}, 8, 4};
+        // mov eax, edx
+        inline constexpr Stencil RESULT = {{0x89, 0xD0}, 2, -1};
+    }
+}
+
+#endif //TEALANG_COMPILER_CPP20_STENCILS_H
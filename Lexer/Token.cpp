@@ -95,6 +95,14 @@ namespace lexer {
         return s == "while";
     }
 
+    bool isSpawn(const std::string &s) {
+        return s == "spawn";
+    }
+
+    bool isAwait(const std::string &s) {
+        return s == "await";
+    }
+
     bool isString(const std::string &s) {
         return (std::regex_match(s, string));
     }
@@ -210,6 +218,7 @@ namespace lexer {
     TOKEN_TYPE determineOperatorType(const std::string& op){
         // Multiplicative
         if(isAnd(op)) return TOK_AND;
+        if(isOr(op)) return TOK_OR;
         if (isAsterisk(op)) return TOK_ASTERISK;
         if (isDivide(op)) return TOK_DIVIDE;
         // Additive
@@ -227,6 +236,29 @@ namespace lexer {
         return TOK_INVALID;
     }
 
+    OPERATOR determineOperator(const std::string& op){
+        switch (determineOperatorType(op)) {
+            case TOK_PLUS: return OP_ADD;
+            case TOK_MINUS: return OP_SUB;
+            case TOK_ASTERISK: return OP_MUL;
+            case TOK_DIVIDE: return OP_DIV;
+            case TOK_LESS_THAN: return OP_LT;
+            case TOK_MORE_THAN: return OP_GT;
+            case TOK_LESS_THAN_EQUAL_TO: return OP_LE;
+            case TOK_MORE_THAN_EQUAL_TO: return OP_GE;
+            case TOK_EQAUL_TO: return OP_EQ;
+            case TOK_NOT_EQAUL_TO: return OP_NE;
+            case TOK_AND: return OP_AND;
+            case TOK_OR: return OP_OR;
+            default: return OP_INVALID;
+        }
+    }
+
+    std::string operatorSymbol(OPERATOR op){
+        static const char* symbols[] = {"+", "-", "*", "/", "<", ">", "<=", ">=", "==", "!=", "and", "or", "-", "?"};
+        return symbols[op];
+    }
+
     bool isStruct(const std::string& type){
         return !(isFloatType(type) || isIntType(type) || isBoolType(type) || isStringType(type) || isCharType(type) || isAutoType(type));
     }
@@ -252,6 +284,8 @@ namespace lexer {
         if (isElse(s)) return TOK_ELSE;
         if (isFor(s)) return TOK_FOR;
         if (isWhile(s)) return TOK_WHILE;
+        if (isSpawn(s)) return TOK_SPAWN;
+        if (isAwait(s)) return TOK_AWAIT;
         // OPENING SQUARE
         if (isOpeningSquare(s)) return TOK_OPENING_SQUARE;
         // Identifier
@@ -120,7 +120,20 @@ namespace lexer {
         TOK_OPENING_SQUARE      = 45,
         TOK_CLOSING_SQUARE      = 46,
         TOK_STRUCT_TYPE         = 47,
-        TOK_FULLSTOP            = 48
+        TOK_FULLSTOP            = 48,
+        TOK_SPAWN               = 49,
+        TOK_AWAIT               = 50
+    };
+
+    // Operators of the expressions, resolved once per AST node so that evaluating one indexes the operator
+    // kernels of the interpreter (see interpreter::kernels) instead of comparing strings
+    // OP_NEGATE is the unary operator (- for int and float, not for bool)
+    enum OPERATOR {
+        OP_ADD, OP_SUB, OP_MUL, OP_DIV,
+        OP_LT, OP_GT, OP_LE, OP_GE, OP_EQ, OP_NE,
+        OP_AND, OP_OR,
+        OP_NEGATE,
+        OP_INVALID
     };
 
     /* regex statements that defines:
@@ -157,6 +170,8 @@ namespace lexer {
     bool isElse(const std::string& s);
     bool isFor(const std::string& s);
     bool isWhile(const std::string& s);
+    bool isSpawn(const std::string& s);
+    bool isAwait(const std::string& s);
     bool isString(const std::string& s);
     bool isInt(const std::string& s);
     bool isFloat(const std::string& s);
@@ -188,6 +203,10 @@ namespace lexer {
 
     // determines the token for an operator
     TOKEN_TYPE determineOperatorType(const std::string& op);
+    // determines the operator of a binary expression
+    OPERATOR determineOperator(const std::string& op);
+    // the symbol of an operator, for errors
+    std::string operatorSymbol(OPERATOR op);
     // checks whether a type is a struct or not
     bool isStruct(const std::string& type);
     // TOKEN_TYPE functions that provide possible token type building avenues from a particular state
@@ -63,6 +63,14 @@ namespace parser {
         v->visit(this);
     }
 
+    void ASTSpawnNode::accept(visitor::Visitor *v) {
+        v->visit(this);
+    }
+
+    void ASTAwaitNode::accept(visitor::Visitor *v) {
+        v->visit(this);
+    }
+
 // Expression
 
 // Statement
@@ -5,11 +5,13 @@
 #ifndef TEALANG_COMPILER_CPP20_AST_H
 #define TEALANG_COMPILER_CPP20_AST_H
 
+#include <atomic>
 #include <string>
 #include <utility>
 #include <vector>
 #include <memory>
 #include "../Visitor/Visitor.h"
+#include "../Lexer/Token.h"
 
 namespace parser {
     // Abstract Nodes
@@ -57,11 +59,13 @@ namespace parser {
     public:
         ASTBinaryNode(std::string op, std::shared_ptr<ASTExprNode> left, std::shared_ptr<ASTExprNode> right, unsigned int lineNumber) :
                 op(std::move(op)),
+                kind(lexer::determineOperator(this->op)),
                 left(std::move(left)),
                 right(std::move(right)),
                 lineNumber(lineNumber)
         {};
         std::string op;
+        lexer::OPERATOR kind;
         std::shared_ptr<ASTExprNode> left;
         std::shared_ptr<ASTExprNode> right;
         unsigned int lineNumber;
@@ -73,13 +77,22 @@ namespace parser {
         ASTFunctionCallNode(std::shared_ptr<ASTIdentifierNode> identifier, std::vector<std::shared_ptr<ASTExprNode>> parameters, unsigned int lineNumber) :
                 identifier(std::move(identifier)),
                 parameters(std::move(parameters)),
-                lineNumber(lineNumber)
+                lineNumber(lineNumber),
+                callee(nullptr),
+                method(nullptr)
         {};
         ~ASTFunctionCallNode() = default;
 
         std::shared_ptr<ASTIdentifierNode> identifier;
         std::vector<std::shared_ptr<ASTExprNode>> parameters;
         unsigned int lineNumber;
+        // The called global function, resolved by the semantic pass (null for struct methods)
+        // the program owns the declaration
+        ASTFunctionDeclarationNode* callee;
+        // Inline cache of the interpreter for struct methods, the method the last receiver dispatched to
+        // (its owner is the struct of that receiver). It only depends on the program, so every execution
+        // of the program shares it, it is one word for executions on other threads to read and write
+        std::atomic<ASTFunctionDeclarationNode*> method;
         void accept(visitor::Visitor* v) override;
     };
 
@@ -91,14 +104,18 @@ namespace parser {
                 identifier(std::move(identifier)),
                 child(std::move(child)),
                 ilocExprNode(std::move(ilocExprNode)),
-                lineNumber(lineNumber)
+                lineNumber(lineNumber),
+                slot(-1),
+                offset(-1)
         {};
 
         explicit ASTIdentifierNode(const std::shared_ptr<ASTIdentifierNode>& identifier) :
                 identifier(identifier->identifier),
                 child(identifier->child),
                 ilocExprNode(identifier->ilocExprNode),
-                lineNumber(identifier->lineNumber)
+                lineNumber(identifier->lineNumber),
+                slot(identifier->slot),
+                offset(identifier->offset)
         {};
 
         ~ASTIdentifierNode() = default;
@@ -106,6 +123,12 @@ namespace parser {
         std::shared_ptr<ASTExprNode> ilocExprNode;
         std::string identifier;
         unsigned int lineNumber;
+        // Index of the parameter in the call frame of the enclosing function, resolved by the semantic pass
+        // -1 when the identifier is not a parameter
+        int slot;
+        // Index of the field in the instance of its tlstruct, resolved by the semantic pass
+        // -1 when the identifier is not a member (or was not resolved)
+        int offset;
 
         std::string getID(){
             if(child != nullptr)
@@ -131,11 +154,39 @@ namespace parser {
         explicit ASTUnaryNode(std::shared_ptr<ASTExprNode> exprNode, std::string op, unsigned int lineNumber) :
             exprNode(std::move(exprNode)),
             op(std::move(op)),
+            kind(lexer::OP_NEGATE),
             lineNumber(lineNumber)
         {};
         ~ASTUnaryNode() = default;
         std::shared_ptr<ASTExprNode> exprNode;
         std::string op;
+        lexer::OPERATOR kind;
+        unsigned int lineNumber;
+        void accept(visitor::Visitor* v) override;
+    };
+
+    // spawn f(args), the call runs as a task of its own and the expression is a handle on its result
+    class ASTSpawnNode : public ASTExprNode {
+    public:
+        ASTSpawnNode(std::shared_ptr<ASTFunctionCallNode> call, unsigned int lineNumber) :
+            call(std::move(call)),
+            lineNumber(lineNumber)
+        {};
+        ~ASTSpawnNode() = default;
+        std::shared_ptr<ASTFunctionCallNode> call;
+        unsigned int lineNumber;
+        void accept(visitor::Visitor* v) override;
+    };
+
+    // await h, the result of the task h is a handle on once it is over
+    class ASTAwaitNode : public ASTExprNode {
+    public:
+        ASTAwaitNode(std::shared_ptr<ASTExprNode> exprNode, unsigned int lineNumber) :
+            exprNode(std::move(exprNode)),
+            lineNumber(lineNumber)
+        {};
+        ~ASTAwaitNode() = default;
+        std::shared_ptr<ASTExprNode> exprNode;
         unsigned int lineNumber;
         void accept(visitor::Visitor* v) override;
     };
@@ -155,8 +206,9 @@ namespace parser {
                 statements(std::move(statements))
         {};
 
+        // Shares the statements of programNode, which is left as it was
         explicit ASTProgramNode(const std::shared_ptr<ASTProgramNode>& programNode) :
-                statements(std::move(programNode->statements))
+                statements(programNode->statements)
         {};
 
         ~ASTProgramNode() = default;
@@ -171,13 +223,17 @@ namespace parser {
         ASTSFunctionCallNode(std::shared_ptr<ASTIdentifierNode> identifier, std::vector<std::shared_ptr<ASTExprNode>> parameters, unsigned int lineNumber) :
                 identifier(std::move(identifier)),
                 parameters(std::move(parameters)),
-                lineNumber(lineNumber)
+                lineNumber(lineNumber),
+                callee(nullptr),
+                method(nullptr)
         {};
 
         explicit ASTSFunctionCallNode(const std::shared_ptr<ASTFunctionCallNode>& exprNode) :
                 identifier(exprNode->identifier),
                 parameters(exprNode->parameters),
-                lineNumber(exprNode->lineNumber)
+                lineNumber(exprNode->lineNumber),
+                callee(exprNode->callee),
+                method(exprNode->method.load())
         {};
 
         ~ASTSFunctionCallNode() = default;
@@ -185,6 +241,8 @@ namespace parser {
         std::shared_ptr<ASTIdentifierNode> identifier;
         std::vector<std::shared_ptr<ASTExprNode>> parameters;
         unsigned int lineNumber;
+        ASTFunctionDeclarationNode* callee;
+        std::atomic<ASTFunctionDeclarationNode*> method;
         void accept(visitor::Visitor* v) override;
     };
 
@@ -312,7 +370,9 @@ namespace parser {
                 identifier(std::move(identifier)),
                 parameters(std::move(parameters)),
                 functionBlock(std::move(functionBlock)),
-                lineNumber(lineNumber)
+                lineNumber(lineNumber),
+                resolved(false),
+                owner(nullptr)
         {};
         ~ASTFunctionDeclarationNode() = default;
 
@@ -322,6 +382,11 @@ namespace parser {
         std::vector<std::pair<std::string, std::string>> parameters;
         std::shared_ptr<ASTBlockNode> functionBlock;
         unsigned int lineNumber;
+        // Set by the semantic pass once the parameters used in the block refer to their slot
+        // a declaration that was not checked (reused by an incremental check) binds its parameters by name
+        bool resolved;
+        // The block of the tlstruct a method is declared in, null for a global function
+        ASTBlockNode* owner;
         void accept(visitor::Visitor* v) override;
     };
 
@@ -162,6 +162,17 @@ namespace parser {
                 moveTokenWindow();
                 // return an ASTUnaryNode
                 return std::make_shared<ASTUnaryNode>(parseExpression(), op, currentToken.lineNumber);
+            case lexer::TOK_SPAWN:
+                // Move over spawn, only a call can be spawned
+                moveTokenWindow();
+                if (currentToken.type != lexer::TOK_IDENTIFIER || nextToken.type != lexer::TOK_OPENING_CURVY)
+                    throw std::runtime_error("Expected a function call after spawn on line "
+                                             + std::to_string(lineNumber) + ".");
+                return std::make_shared<ASTSpawnNode>(parseFunctionCall(), lineNumber);
+            case lexer::TOK_AWAIT:
+                // Move over await, it binds to the factor after it
+                moveTokenWindow();
+                return std::make_shared<ASTAwaitNode>(parseFactor(), lineNumber);
             default:
                 throw std::runtime_error("Expected expression on line "
                                          + std::to_string(currentToken.lineNumber) + ".");
@@ -759,6 +770,10 @@ namespace parser {
                                      + std::to_string(currentToken.lineNumber) + ".");
         // Get block after {
         auto structBlock = parseBlock();
+        // The methods belong to the struct
+        for(auto &statement : structBlock -> statements)
+            if(auto functionDeclarationNode = std::dynamic_pointer_cast<ASTFunctionDeclarationNode>(statement))
+                functionDeclarationNode -> owner = structBlock.get();
         // Create ASTStructNode to return
         return std::make_shared<ASTStructNode>(identifier, structBlock, lineNumber);
     }
@@ -0,0 +1,32 @@
+//
+// A program lexed, parsed and checked once that can be run any number of times.
+//
+
+#include "Compiled_Program.h"
+#include "../Lexer/Lexer.h"
+#include "../Parser/Parser.h"
+#include "../Visitor/Semantic_Visitor.h"
+
+namespace program {
+    CompiledProgram::CompiledProgram(const std::string &source) {
+        lexer::Lexer lexer;
+        lexer.extractLexemes(source);
+        tokenCount = lexer.tokens.size();
+
+        parser::Parser parser(lexer.tokens);
+        programNode = std::shared_ptr<parser::ASTProgramNode>(parser.parseProgram());
+
+        visitor::SemanticAnalyser semanticAnalyser;
+        semanticAnalyser.visit(programNode.get());
+    }
+
+    void CompiledProgram::run(const std::map<std::string, interpreter::Value> &globals, std::ostream &out, std::size_t capacity,
+                              bool relaxed) const {
+        visitor::Interpreter interpreter(capacity, relaxed, out);
+        run(interpreter, globals);
+    }
+
+    void CompiledProgram::run(visitor::Interpreter &interpreter, const std::map<std::string, interpreter::Value> &globals) const {
+        interpreter.run(programNode.get(), globals);
+    }
+}
@@ -0,0 +1,44 @@
+//
+// A program lexed, parsed and checked once that can be run any number of times.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_COMPILED_PROGRAM_H
+#define TEALANG_COMPILER_CPP20_COMPILED_PROGRAM_H
+
+#include "../Parser/AST.h"
+#include "../Visitor/Interpreter_Visitor.h"
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace program {
+    // The AST of a program once the semantic pass is done, it is not changed afterwards.
+    // Every run gets an interpreter of its own (fresh variables, frames and structs), so a compiled
+    // program can be shared between threads and run by any number of them at the same time.
+    class CompiledProgram {
+    public:
+        // Throws std::runtime_error with the first lexical, syntax or semantic error of source
+        explicit CompiledProgram(const std::string& source);
+        ~CompiledProgram() = default;
+
+        CompiledProgram(CompiledProgram const &) = delete;
+        CompiledProgram& operator=(CompiledProgram const &) = delete;
+
+        // Interpret the program, printing to out
+        // globals are values for top level variables, given in place of what their let would give
+        void run(const std::map<std::string, interpreter::Value>& globals = {}, std::ostream& out = std::cout,
+                 std::size_t capacity = visitor::Interpreter::defaultCapacity, bool relaxed = false) const;
+        // Interpret the program on interpreter, which keeps the functions, structs and globals it declared
+        void run(visitor::Interpreter& interpreter, const std::map<std::string, interpreter::Value>& globals = {}) const;
+
+        [[nodiscard]] std::size_t tokens() const { return tokenCount; }
+
+    private:
+        std::shared_ptr<parser::ASTProgramNode> programNode;
+        std::size_t tokenCount;
+    };
+}
+
+#endif //TEALANG_COMPILER_CPP20_COMPILED_PROGRAM_H
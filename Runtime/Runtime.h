@@ -0,0 +1,82 @@
+//
+// Runtime of the C++ translation units produced by visitor::Transpiler.
+// It is pasted at the top of every generated file so that the file compiles on its own.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_RUNTIME_H
+#define TEALANG_COMPILER_CPP20_RUNTIME_H
+
+#include <concepts>
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tl {
+    // Array storage shared between copies, the elements are only copied when a shared array is written to
+    // (the same semantics as interpreter::Array)
+    template <typename T>
+    class Array {
+    public:
+        explicit Array(std::size_t size = 0) :
+                elements(std::make_shared<std::vector<T>>(size))
+        {};
+        Array(std::initializer_list<T> items) :
+                elements(std::make_shared<std::vector<T>>(items))
+        {};
+
+        [[nodiscard]] std::size_t size() const { return elements -> size(); }
+        [[nodiscard]] T at(std::size_t i) const { return elements -> at(i); }
+        // The element for writing, the elements are copied first if another array shares them
+        typename std::vector<T>::reference write(std::size_t i){
+            if(elements.use_count() > 1)
+                elements = std::make_shared<std::vector<T>>(*elements);
+            return elements -> at(i);
+        }
+
+    private:
+        std::shared_ptr<std::vector<T>> elements;
+    };
+
+    // A parameter of type T, the declaration of a parameter does not say whether it is an array so both are accepted
+    template <typename P, typename T>
+    concept Of = std::same_as<P, T> || std::same_as<P, Array<T>>;
+
+    // Array indices may be floats
+    inline int index(int i) { return i; }
+    inline int index(float i) { return (int) i; }
+
+    // Unary - negates numbers and bools
+    inline int negate(int v) { return v * -1; }
+    inline float negate(float v) { return v * -1; }
+    inline bool negate(bool v) { return !v; }
+
+    inline void write(std::ostream& os, int v) { os << v; }
+    inline void write(std::ostream& os, float v) { os << v; }
+    inline void write(std::ostream& os, bool v) { os << (v ? "true" : "false"); }
+    inline void write(std::ostream& os, char v) { os << v; }
+    inline void write(std::ostream& os, const std::string& v) { os << v; }
+    // arrays are printed as {a, b, c}
+    template <typename T>
+    void write(std::ostream& os, const Array<T>& v) {
+        os << "{";
+        for(std::size_t i = 0; i < v.size(); ++i){
+            os << (i == 0 ? "" : ", ");
+            write(os, v.at(i));
+        }
+        os << "}";
+    }
+
+    template <typename T>
+    void print(const T& v) {
+        // nothing is printed for struct values
+        if constexpr (requires { write(std::cout, v); }){
+            write(std::cout, v);
+            std::cout << std::endl;
+        }
+    }
+}
+
+#endif //TEALANG_COMPILER_CPP20_RUNTIME_H
@@ -0,0 +1,254 @@
+//
+// Kernels for the loops over int and float arrays the interpreter runs in one go, AVX2 when it is built for it.
+//
+
+#include "SIMD.h"
+#include "../Concurrency/Thread_Pool.h"
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TEALANG_AVX2 1
+#else
+#define TEALANG_AVX2 0
+#endif
+
+namespace simd {
+    namespace {
+        // elements a kernel goes through on one thread, a kernel over fewer is not worth the pool
+        constexpr std::size_t grain = 1 << 16;
+
+        // f(begin, end, k) for the k-th chunk of [0, size), on the workers of the shared pool when there is more than one
+        template <typename F>
+        void chunked(std::size_t size, F f) {
+            concurrency::parallelFor(0, (size + grain - 1) / grain, 1, [&f, size](std::size_t k){
+                f(k * grain, std::min(size, (k + 1) * grain), k);
+            });
+        }
+
+        // int arithmetic wraps around, it is done unsigned so that overflowing is defined
+        template <lexer::OPERATOR op>
+        int scalar(int left, int right) {
+            auto l = (std::uint32_t) left, r = (std::uint32_t) right;
+            if constexpr (op == lexer::OP_ADD) return (int) (l + r);
+            else if constexpr (op == lexer::OP_SUB) return (int) (l - r);
+            else return (int) (l * r);
+        }
+
+        template <lexer::OPERATOR op>
+        float scalar(float left, float right) {
+            if constexpr (op == lexer::OP_ADD) return left + right;
+            else if constexpr (op == lexer::OP_SUB) return left - right;
+            else if constexpr (op == lexer::OP_MUL) return left * right;
+            else return left / right;
+        }
+
+#if TEALANG_AVX2
+        // 8 lanes of 32 bits
+        __m256i load(const int* p) { return _mm256_loadu_si256((const __m256i*) p); }
+        __m256 load(const float* p) { return _mm256_loadu_ps(p); }
+        void store(int* p, __m256i v) { _mm256_storeu_si256((__m256i*) p, v); }
+        void store(float* p, __m256 v) { _mm256_storeu_ps(p, v); }
+        __m256i broadcast(int v) { return _mm256_set1_epi32(v); }
+        __m256 broadcast(float v) { return _mm256_set1_ps(v); }
+
+        template <lexer::OPERATOR op>
+        __m256i vector(__m256i left, __m256i right) {
+            if constexpr (op == lexer::OP_ADD) return _mm256_add_epi32(left, right);
+            else if constexpr (op == lexer::OP_SUB) return _mm256_sub_epi32(left, right);
+            else return _mm256_mullo_epi32(left, right);
+        }
+
+        template <lexer::OPERATOR op>
+        __m256 vector(__m256 left, __m256 right) {
+            if constexpr (op == lexer::OP_ADD) return _mm256_add_ps(left, right);
+            else if constexpr (op == lexer::OP_SUB) return _mm256_sub_ps(left, right);
+            else if constexpr (op == lexer::OP_MUL) return _mm256_mul_ps(left, right);
+            else return _mm256_div_ps(left, right);
+        }
+#endif
+
+        int add(const int* elements, std::size_t size, int total) {
+            std::size_t i = 0;
+            auto result = (std::uint32_t) total;
+#if TEALANG_AVX2
+            // wrapping addition does not depend on the order, the lanes are added up at the end
+            __m256i lanes[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+            for(; i + 32 <= size; i += 32)
+                for(int k = 0; k < 4; ++k)
+                    lanes[k] = _mm256_add_epi32(lanes[k], load(elements + i + 8 * k));
+            for(; i + 8 <= size; i += 8)
+                lanes[0] = _mm256_add_epi32(lanes[0], load(elements + i));
+            auto all = _mm256_add_epi32(_mm256_add_epi32(lanes[0], lanes[1]), _mm256_add_epi32(lanes[2], lanes[3]));
+            alignas(32) std::uint32_t parts[8];
+            _mm256_store_si256((__m256i*) parts, all);
+            for(auto part : parts)
+                result += part;
+#endif
+            for(; i < size; ++i)
+                result += (std::uint32_t) elements[i];
+            return (int) result;
+        }
+
+        float add(const float* elements, std::size_t size, float total, bool relaxed) {
+            std::size_t i = 0;
+#if TEALANG_AVX2
+            if(relaxed){
+                __m256 lanes[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+                for(; i + 32 <= size; i += 32)
+                    for(int k = 0; k < 4; ++k)
+                        lanes[k] = _mm256_add_ps(lanes[k], load(elements + i + 8 * k));
+                auto all = _mm256_add_ps(_mm256_add_ps(lanes[0], lanes[1]), _mm256_add_ps(lanes[2], lanes[3]));
+                alignas(32) float parts[8];
+                _mm256_store_ps(parts, all);
+                float lanesTotal = 0;
+                for(auto part : parts)
+                    lanesTotal += part;
+                total += lanesTotal;
+            }
+#else
+            if(relaxed){
+                // the same lanes without the vectors
+                float lanes[8] = {};
+                for(; i + 8 <= size; i += 8)
+                    for(int k = 0; k < 8; ++k)
+                        lanes[k] += elements[i + k];
+                float lanesTotal = 0;
+                for(auto lane : lanes)
+                    lanesTotal += lane;
+                total += lanesTotal;
+            }
+#endif
+            // an ordered sum depends on every addition before it, it is the loop without the interpreter
+            for(; i < size; ++i)
+                total += elements[i];
+            return total;
+        }
+
+        template <lexer::OPERATOR op, typename T>
+        void map(T* out, Operand<T> left, Operand<T> right, std::size_t size) {
+            std::size_t i = 0;
+#if TEALANG_AVX2
+            auto l = broadcast(left.scalar), r = broadcast(right.scalar);
+            for(; i + 8 <= size; i += 8){
+                if(left.elements != nullptr) l = load(left.elements + i);
+                if(right.elements != nullptr) r = load(right.elements + i);
+                store(out + i, vector<op>(l, r));
+            }
+#endif
+            for(; i < size; ++i)
+                out[i] = scalar<op>(left.elements != nullptr ? left.elements[i] : left.scalar,
+                                    right.elements != nullptr ? right.elements[i] : right.scalar);
+        }
+
+        template <typename T>
+        void map(lexer::OPERATOR op, T* out, Operand<T> left, Operand<T> right, std::size_t size) {
+            switch (op) {
+                case lexer::OP_ADD: return map<lexer::OP_ADD>(out, left, right, size);
+                case lexer::OP_SUB: return map<lexer::OP_SUB>(out, left, right, size);
+                case lexer::OP_MUL: return map<lexer::OP_MUL>(out, left, right, size);
+                default:
+                    // there is no int division, it is left to the interpreter for its division by zero
+                    if constexpr (std::is_same_v<T, float>)
+                        return map<lexer::OP_DIV>(out, left, right, size);
+            }
+        }
+
+        template <lexer::OPERATOR op, typename T>
+        std::size_t select(const T* elements, std::size_t size, T best) {
+            std::size_t index = size;
+            for(std::size_t i = 0; i < size; ++i){
+                bool better;
+                if constexpr (op == lexer::OP_LT) better = elements[i] < best;
+                else if constexpr (op == lexer::OP_GT) better = elements[i] > best;
+                else if constexpr (op == lexer::OP_LE) better = elements[i] <= best;
+                else better = elements[i] >= best;
+                if(better){
+                    best = elements[i];
+                    index = i;
+                }
+            }
+            return index;
+        }
+
+        template <typename T>
+        std::size_t select(lexer::OPERATOR op, const T* elements, std::size_t size, T best) {
+            switch (op) {
+                case lexer::OP_LT: return select<lexer::OP_LT>(elements, size, best);
+                case lexer::OP_GT: return select<lexer::OP_GT>(elements, size, best);
+                case lexer::OP_LE: return select<lexer::OP_LE>(elements, size, best);
+                default: return select<lexer::OP_GE>(elements, size, best);
+            }
+        }
+
+        template <typename T>
+        std::size_t selectAll(lexer::OPERATOR op, const T* elements, std::size_t size, T start) {
+            if(size <= grain)
+                return select(op, elements, size, start);
+            // Every chunk picks from start, going through the picks in order then picks what the loop does:
+            // a chunk whose pick is not kept holds nothing the loop would have kept either
+            std::vector<std::size_t> picks((size + grain - 1) / grain);
+            chunked(size, [&](std::size_t begin, std::size_t end, std::size_t k){
+                auto pick = select(op, elements + begin, end - begin, start);
+                picks[k] = pick < end - begin ? begin + pick : size;
+            });
+            std::size_t index = size;
+            for(auto pick : picks)
+                if(pick < size && select(op, elements + pick, 1, index < size ? elements[index] : start) == 0)
+                    index = pick;
+            return index;
+        }
+
+        template <typename T>
+        void mapAll(lexer::OPERATOR op, T* out, Operand<T> left, Operand<T> right, std::size_t size) {
+            if(size <= grain)
+                return map<T>(op, out, left, right, size);
+            // every element is written on its own, the chunks can be done in any order
+            chunked(size, [&](std::size_t begin, std::size_t end, std::size_t){
+                Operand<T> l = left, r = right;
+                if(l.elements != nullptr) l.elements += begin;
+                if(r.elements != nullptr) r.elements += begin;
+                map<T>(op, out + begin, l, r, end - begin);
+            });
+        }
+    }
+
+    int sum(const int* elements, std::size_t size, int total) {
+        if(size <= grain)
+            return add(elements, size, total);
+        // wrapping addition does not depend on the order either
+        std::vector<int> totals((size + grain - 1) / grain);
+        chunked(size, [&](std::size_t begin, std::size_t end, std::size_t k){
+            totals[k] = add(elements + begin, end - begin, 0);
+        });
+        return add(totals.data(), totals.size(), total);
+    }
+
+    float sum(const float* elements, std::size_t size, float total, bool relaxed) {
+        if(!relaxed || size <= grain)
+            return add(elements, size, total, relaxed);
+        std::vector<float> totals((size + grain - 1) / grain);
+        chunked(size, [&](std::size_t begin, std::size_t end, std::size_t k){
+            totals[k] = add(elements + begin, end - begin, 0.0f, true);
+        });
+        return add(totals.data(), totals.size(), total, false);
+    }
+
+    std::size_t select(lexer::OPERATOR op, const int* elements, std::size_t size, int start) {
+        return selectAll<int>(op, elements, size, start);
+    }
+
+    std::size_t select(lexer::OPERATOR op, const float* elements, std::size_t size, float start) {
+        return selectAll<float>(op, elements, size, start);
+    }
+
+    void map(lexer::OPERATOR op, int* out, Operand<int> left, Operand<int> right, std::size_t size) {
+        mapAll<int>(op, out, left, right, size);
+    }
+
+    void map(lexer::OPERATOR op, float* out, Operand<float> left, Operand<float> right, std::size_t size) {
+        mapAll<float>(op, out, left, right, size);
+    }
+}
@@ -0,0 +1,38 @@
+//
+// Kernels for the loops over int and float arrays the interpreter runs in one go, AVX2 when it is built for it.
+// A kernel over many elements is split into chunks run on the workers of the shared thread pool.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_SIMD_H
+#define TEALANG_COMPILER_CPP20_SIMD_H
+
+#include "../Lexer/Token.h"
+#include <cstddef>
+
+namespace simd {
+    // An operand of a map, the elements of an array or the same scalar for every element when elements is null
+    template <typename T>
+    class Operand {
+    public:
+        const T* elements;
+        T scalar;
+    };
+
+    // total + elements[0] + elements[1] + ... (int wraps around like the interpreter)
+    int sum(const int* elements, std::size_t size, int total);
+    // The float sum is added left to right like the loop does unless relaxed is set (and only then split across the pool),
+    // a relaxed sum adds in lanes and chunks that are combined at the end so its last bits may differ
+    float sum(const float* elements, std::size_t size, float total, bool relaxed);
+
+    // The index of the element best is left at by  if(elements[i] op best){ best = elements[i]; }  run over the elements from
+    // best = start, size if it is never set (op is <, >, <= or >=, a minimum or a maximum that keeps the first or last one of a tie)
+    std::size_t select(lexer::OPERATOR op, const int* elements, std::size_t size, int start);
+    std::size_t select(lexer::OPERATOR op, const float* elements, std::size_t size, float start);
+
+    // out[i] = left[i] op right[i] for op +, - or * (and / for float)
+    // out may be the elements of an operand, never shifted against them
+    void map(lexer::OPERATOR op, int* out, Operand<int> left, Operand<int> right, std::size_t size);
+    void map(lexer::OPERATOR op, float* out, Operand<float> left, Operand<float> right, std::size_t size);
+}
+
+#endif //TEALANG_COMPILER_CPP20_SIMD_H
@@ -0,0 +1,102 @@
+//
+// Calls into a program through the embedding API (see Engine/Engine.h), exits with 1 if any check fails.
+//
+
+#include "../Engine/Engine.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    template <typename T>
+    void check(const std::string& what, const T& got, const T& expected) {
+        if(got == expected)
+            return;
+        std::cerr << what << ": got " << got << ", expected " << expected << std::endl;
+        ++failures;
+    }
+
+    // f has to throw a std::runtime_error whose message contains expected
+    template <typename F>
+    void fails(const std::string& what, F f, const std::string& expected) {
+        try{
+            f();
+        }catch(const std::runtime_error& e){
+            check(what, std::string(e.what()).find(expected) != std::string::npos, true);
+            return;
+        }
+        std::cerr << what << ": nothing was thrown" << std::endl;
+        ++failures;
+    }
+}
+
+int main() {
+    std::ostringstream out;
+    engine::Engine tea(R"(
+let counter : int = 0;
+let limit : int = 10;
+let weights[3] : float = {0.5, 1.5, 2.0};
+
+int Add(a : int, b : int) {
+    return a + b;
+}
+
+string Greet(who : string) {
+    print "greeting";
+    return "hello " + who;
+}
+
+int Bump(by : int) {
+    counter = counter + by;
+    return counter;
+}
+
+int Total(xs[] : int, n : int) {
+    let sum : int = 0;
+    for (let i : int = 0; i < n; i = i + 1) {
+        sum = sum + xs[i];
+    }
+    return sum;
+}
+
+int Below(x : int) {
+    if (x < limit) {
+        return 1;
+    }
+    return 0;
+}
+)", {{"limit", interpreter::Value(3)}}, out);
+
+    // Typed calls, looked up on every call and resolved once
+    check("call Add", tea.call<int>("Add", 2, 3), 5);
+    check("call Greet", tea.call<std::string>("Greet", "you"), std::string("hello you"));
+    check("print of Greet", out.str(), std::string("greeting\n"));
+    check("call Total", tea.call<int>("Total", std::vector<int>{1, 2, 3, 4}, 4), 10);
+    auto add = tea.function<int(int, int)>("Add");
+    check("function Add", add(40, 2), 42);
+
+    // Globals, given in place of their let, changed by the program and read back
+    check("given global", tea.global<int>("limit"), 3);
+    check("call Below", tea.call<int>("Below", 2) + tea.call<int>("Below", 5), 1);
+    check("call Bump", tea.call<int>("Bump", 4) + tea.call<int>("Bump", 5), 13);
+    check("changed global", tea.global<int>("counter"), 9);
+    check("array global", tea.global<std::vector<float>>("weights") == std::vector<float>{0.5f, 1.5f, 2.0f}, true);
+
+    // Signatures and types that do not match
+    fails("call with a float for an int", [&](){ tea.call<int>("Add", 1.0f, 1); },
+          "Function with identifier Add(float, int) has not been declared.");
+    fails("function with too few parameters", [&](){ tea.function<int(int)>("Add"); },
+          "Function with identifier Add(int) has not been declared.");
+    fails("result of the wrong type", [&](){ tea.call<float>("Add", 1, 1); }, "Value of type int is not of type float.");
+    fails("global of the wrong type", [&](){ tea.global<std::string>("counter"); }, "Value of type int is not of type string.");
+    fails("global that does not exist", [&](){ tea.global<int>("missing"); }, "Variable with identifier missing has not been declared.");
+    fails("given global of the wrong type", [&](){ engine::Engine("let limit : int = 10;", {{"limit", interpreter::Value(1.5f)}}); },
+          "cannot be given a value of type float.");
+
+    // the engine is still usable after a failed call
+    check("call after errors", add(1, 1), 2);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+# Runs one test program and matches what it printed (errors included) against EXPECT
+# cmake -DTEALANG=<executable> -DENGINE=<-i|-b|-f> -DPROGRAM=<file> -DEXPECT=<regex> -P Run.cmake
+execute_process(COMMAND ${TEALANG} ${ENGINE} -p ${PROGRAM}
+                OUTPUT_VARIABLE output ERROR_VARIABLE output RESULT_VARIABLE result)
+if(NOT output MATCHES "${EXPECT}")
+    message(FATAL_ERROR "${PROGRAM} run with ${ENGINE} (${result}) printed\n${output}\nexpected\n${EXPECT}")
+endif()
@@ -0,0 +1,103 @@
+//
+// Bytecode of a checked program, produced by visitor::Compiler and run by vm::VM.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_BYTECODE_H
+#define TEALANG_COMPILER_CPP20_BYTECODE_H
+
+#include "../Visitor/Interpreter_Visitor.h"
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace bytecode {
+    // The operands of an instruction are a and b, values are passed on the operand stack of the running frame
+    // Typed opcodes expect the type the compiler proved, the untyped ones check the value at runtime
+    enum OPCODE {
+        // push a, the bits of a for floats, constants[a] for strings
+        PUSH_INT, PUSH_FLOAT, PUSH_BOOL, PUSH_CHAR, PUSH_CONSTANT, POP,
+        // variables, a is the slot (the field offset for members of self)
+        LOAD_LOCAL, STORE_LOCAL, LOAD_GLOBAL, STORE_GLOBAL, LOAD_MEMBER, STORE_MEMBER, LOAD_SELF,
+        // point the reference at a variable, at a field of the record it points to (offset a or the name in constants[a])
+        REF_LOCAL, REF_GLOBAL, REF_SELF, REF_MEMBER, REF_FIELD, REF_NAMED,
+        // read or write through the reference, the element ones pop the index first
+        LOAD_REF, STORE_REF, LOAD_ELEMENT, STORE_ELEMENT,
+        // pop the size and push an array of the type named in constants[a], append the top of the stack to the array below it
+        NEW_ARRAY, PUSH_ELEMENT,
+        // make sure the prototype of struct a is built, push a copy of it
+        BUILD, INSTANCE,
+        ADD_INT, SUB_INT, MUL_INT, DIV_INT, LT_INT, GT_INT, LE_INT, GE_INT, EQ_INT, NE_INT, NEG_INT,
+        ADD_FLOAT, SUB_FLOAT, MUL_FLOAT, DIV_FLOAT, LT_FLOAT, GT_FLOAT, LE_FLOAT, GE_FLOAT, EQ_FLOAT, NE_FLOAT, NEG_FLOAT,
+        AND, OR, NOT, CONCAT,
+        // operator a (a lexer::OPERATOR, dispatched through interpreter::kernels) and negation
+        // for values whose type is only known at runtime, b is the line for errors
+        APPLY, NEGATE,
+        // jump to a (if the popped condition is false)
+        JUMP, JUMP_IF_FALSE,
+        // call function a with b arguments, on the instance the reference points to for methods
+        // a named call looks the method constants[a] up in the struct of the instance
+        CALL, CALL_METHOD, CALL_NAMED,
+        // leave the function with the popped value, leave a constructor
+        RETURN, LEAVE,
+        PRINT, HALT
+    };
+
+    class Instruction {
+    public:
+        Instruction(OPCODE op, int a, int b) :
+                op(op),
+                a(a),
+                b(b)
+        {};
+
+        OPCODE op;
+        int a;
+        int b;
+    };
+
+    class Function {
+    public:
+        Function(std::string identifier, int parameters) :
+                identifier(std::move(identifier)),
+                parameters(parameters),
+                entry(0),
+                frame(parameters),
+                stack(0)
+        {};
+
+        std::string identifier;
+        int parameters;
+        // first instruction
+        std::size_t entry;
+        // slots of the parameters and locals, the operand stack needs at most stack more
+        int frame;
+        int stack;
+    };
+
+    // Immutable once compiled, the records of a run point to its structs so it is never copied
+    class Program {
+    public:
+        Program() :
+                globals(0),
+                main(0)
+        {};
+        Program(const Program&) = delete;
+        Program& operator=(const Program&) = delete;
+
+        std::vector<Instruction> code;
+        std::vector<interpreter::Value> constants;
+        std::vector<Function> functions;
+        // The layout of each struct and the function that initialises the fields of its prototype
+        std::deque<interpreter::Struct> structs;
+        std::vector<int> constructors;
+        // Python equivalent of:
+        // methods = {functionDeclarationNode: index into functions}
+        std::map<parser::ASTFunctionDeclarationNode*, int> methods;
+        int globals;
+        // the top level statements
+        int main;
+    };
+}
+
+#endif //TEALANG_COMPILER_CPP20_BYTECODE_H
@@ -0,0 +1,323 @@
+//
+// Stack machine that runs the bytecode produced by visitor::Compiler.
+//
+
+#include "VM.h"
+#include <cstring>
+
+namespace vm {
+    namespace {
+        int index(const interpreter::Value& value) {
+            if(value.tag() == interpreter::Value::INT)
+                return std::get<int>(value);
+            if(value.tag() == interpreter::Value::FLOAT)
+                return (int) std::get<float>(value);
+            throw std::runtime_error("Array index of type " + value.type() + " is not a number.");
+        }
+    }
+
+    VM::VM(const bytecode::Program &program, std::size_t capacity) :
+            program(program),
+            capacity(capacity),
+            globals(program.globals)
+    {
+        stack.reserve(capacity);
+        prototypes.resize(program.structs.size());
+    }
+
+    void VM::enter(int index, std::size_t base) {
+        const auto& function = program.functions[index];
+        if(base + function.frame + function.stack > capacity || frames.size() >= capacity)
+            throw std::runtime_error("Stack depth exceeded calling " + function.identifier + ".");
+        stack.resize(base + function.frame);
+    }
+
+    void VM::run() {
+        // Same order as bytecode::OPCODE
+        static void* labels[] = {
+                &&PUSH_INT, &&PUSH_FLOAT, &&PUSH_BOOL, &&PUSH_CHAR, &&PUSH_CONSTANT, &&POP,
+                &&LOAD_LOCAL, &&STORE_LOCAL, &&LOAD_GLOBAL, &&STORE_GLOBAL, &&LOAD_MEMBER, &&STORE_MEMBER, &&LOAD_SELF,
+                &&REF_LOCAL, &&REF_GLOBAL, &&REF_SELF, &&REF_MEMBER, &&REF_FIELD, &&REF_NAMED,
+                &&LOAD_REF, &&STORE_REF, &&LOAD_ELEMENT, &&STORE_ELEMENT,
+                &&NEW_ARRAY, &&PUSH_ELEMENT,
+                &&BUILD, &&INSTANCE,
+                &&ADD_INT, &&SUB_INT, &&MUL_INT, &&DIV_INT, &&LT_INT, &&GT_INT, &&LE_INT, &&GE_INT, &&EQ_INT, &&NE_INT, &&NEG_INT,
+                &&ADD_FLOAT, &&SUB_FLOAT, &&MUL_FLOAT, &&DIV_FLOAT, &&LT_FLOAT, &&GT_FLOAT, &&LE_FLOAT, &&GE_FLOAT, &&EQ_FLOAT, &&NE_FLOAT, &&NEG_FLOAT,
+                &&AND, &&OR, &&NOT, &&CONCAT,
+                &&APPLY, &&NEGATE,
+                &&JUMP, &&JUMP_IF_FALSE,
+                &&CALL, &&CALL_METHOD, &&CALL_NAMED,
+                &&RETURN, &&LEAVE,
+                &&PRINT, &&HALT
+        };
+        static_assert(sizeof(labels) / sizeof(labels[0]) == bytecode::HALT + 1);
+
+        const bytecode::Instruction* code = program.code.data();
+        const bytecode::Instruction* pc = code + program.functions[program.main].entry;
+        std::size_t base = 0;
+        interpreter::Value* self = nullptr;
+        // the variable the last REF_ instruction pointed at
+        interpreter::Value* ref = nullptr;
+        int function;
+        enter(program.main, base);
+
+#define DISPATCH() goto *labels[pc -> op]
+#define NEXT() do { ++pc; DISPATCH(); } while(0)
+#define TOP() stack.back()
+#define BINARY(T, expr) do { T right = std::get<T>(TOP()); stack.pop_back(); T left = std::get<T>(TOP()); TOP() = (expr); NEXT(); } while(0)
+
+        DISPATCH();
+
+        PUSH_INT:
+            stack.emplace_back(pc -> a);
+            NEXT();
+        PUSH_FLOAT: {
+            float value;
+            std::memcpy(&value, &pc -> a, sizeof(value));
+            stack.emplace_back(value);
+            NEXT();
+        }
+        PUSH_BOOL:
+            stack.emplace_back(pc -> a != 0);
+            NEXT();
+        PUSH_CHAR:
+            stack.emplace_back((char) pc -> a);
+            NEXT();
+        PUSH_CONSTANT:
+            stack.emplace_back(program.constants[pc -> a]);
+            NEXT();
+        POP:
+            stack.pop_back();
+            NEXT();
+
+        LOAD_LOCAL:
+            stack.emplace_back(stack[base + pc -> a]);
+            NEXT();
+        STORE_LOCAL:
+            stack[base + pc -> a] = std::move(TOP());
+            stack.pop_back();
+            NEXT();
+        LOAD_GLOBAL:
+            stack.emplace_back(globals[pc -> a]);
+            NEXT();
+        STORE_GLOBAL:
+            globals[pc -> a] = std::move(TOP());
+            stack.pop_back();
+            NEXT();
+        LOAD_MEMBER:
+            stack.emplace_back(std::get<interpreter::Record>(*self).fields[pc -> a]);
+            NEXT();
+        STORE_MEMBER:
+            std::get<interpreter::Record>(*self).fields[pc -> a] = std::move(TOP());
+            stack.pop_back();
+            NEXT();
+        LOAD_SELF:
+            stack.emplace_back(*self);
+            NEXT();
+
+        REF_LOCAL:
+            ref = &stack[base + pc -> a];
+            NEXT();
+        REF_GLOBAL:
+            ref = &globals[pc -> a];
+            NEXT();
+        REF_SELF:
+            ref = self;
+            NEXT();
+        REF_MEMBER:
+            ref = &std::get<interpreter::Record>(*self).fields[pc -> a];
+            NEXT();
+        REF_FIELD:
+            ref = &std::get<interpreter::Record>(*ref).fields[pc -> a];
+            NEXT();
+        REF_NAMED: {
+            auto& record = std::get<interpreter::Record>(*ref);
+            ref = &record.fields[record.layout -> offsets.at(std::get<std::string>(program.constants[pc -> a]))];
+            NEXT();
+        }
+        LOAD_REF:
+            stack.emplace_back(*ref);
+            NEXT();
+        STORE_REF:
+            *ref = std::move(TOP());
+            stack.pop_back();
+            NEXT();
+        LOAD_ELEMENT:
+            TOP() = ref -> at(index(TOP()));
+            NEXT();
+        STORE_ELEMENT: {
+            int i = index(TOP());
+            stack.pop_back();
+            ref -> set(i, TOP());
+            stack.pop_back();
+            NEXT();
+        }
+
+        NEW_ARRAY:
+            TOP() = interpreter::Value::array(std::get<std::string>(program.constants[pc -> a]), index(TOP()));
+            NEXT();
+        PUSH_ELEMENT: {
+            auto element = std::move(TOP());
+            stack.pop_back();
+            TOP().push_back(element);
+            NEXT();
+        }
+
+        BUILD: {
+            const auto& layout = program.structs[pc -> a];
+            if(layout.constant && prototypes[pc -> a] != nullptr)
+                NEXT();
+            // The constructor initialises the fields of the prototype (of the instance itself unless the struct is constant)
+            // it can refer to the fields it already initialised
+            auto& instance = layout.constant ? prototypes[pc -> a] : building.emplace_back();
+            instance = std::make_unique<interpreter::Value>(interpreter::Record(&layout));
+            function = program.constructors[pc -> a];
+            enter(function, stack.size());
+            frames.emplace_back(pc + 1, base, self);
+            base = stack.size() - program.functions[function].frame;
+            self = instance.get();
+            pc = code + program.functions[function].entry;
+            DISPATCH();
+        }
+        INSTANCE:
+            if(program.structs[pc -> a].constant){
+                stack.emplace_back(*prototypes[pc -> a]);
+            }else{
+                stack.emplace_back(std::move(*building.back()));
+                building.pop_back();
+            }
+            NEXT();
+
+        ADD_INT: BINARY(int, left + right);
+        SUB_INT: BINARY(int, left - right);
+        MUL_INT: BINARY(int, left * right);
+        DIV_INT: BINARY(int, left / right);
+        LT_INT: BINARY(int, left < right);
+        GT_INT: BINARY(int, left > right);
+        LE_INT: BINARY(int, left <= right);
+        GE_INT: BINARY(int, left >= right);
+        EQ_INT: BINARY(int, left == right);
+        NE_INT: BINARY(int, left != right);
+        NEG_INT:
+            TOP() = std::get<int>(TOP()) * -1;
+            NEXT();
+        ADD_FLOAT: BINARY(float, left + right);
+        SUB_FLOAT: BINARY(float, left - right);
+        MUL_FLOAT: BINARY(float, left * right);
+        DIV_FLOAT: BINARY(float, left / right);
+        LT_FLOAT: BINARY(float, left < right);
+        GT_FLOAT: BINARY(float, left > right);
+        LE_FLOAT: BINARY(float, left <= right);
+        GE_FLOAT: BINARY(float, left >= right);
+        EQ_FLOAT: BINARY(float, left == right);
+        NE_FLOAT: BINARY(float, left != right);
+        NEG_FLOAT:
+            TOP() = std::get<float>(TOP()) * -1;
+            NEXT();
+        AND: BINARY(bool, left && right);
+        OR: BINARY(bool, left || right);
+        NOT:
+            TOP() = !std::get<bool>(TOP());
+            NEXT();
+        CONCAT: {
+            auto right = std::move(std::get<std::string>(TOP()));
+            stack.pop_back();
+            std::get<std::string>(TOP()) += right;
+            NEXT();
+        }
+
+        APPLY: {
+            auto right = std::move(TOP());
+            stack.pop_back();
+            TOP() = interpreter::apply((lexer::OPERATOR) pc -> a, TOP(), right, pc -> b);
+            NEXT();
+        }
+        NEGATE:
+            TOP() = interpreter::negate(TOP(), pc -> b);
+            NEXT();
+
+        JUMP:
+            pc = code + pc -> a;
+            DISPATCH();
+        JUMP_IF_FALSE: {
+            bool condition = std::get<bool>(TOP());
+            stack.pop_back();
+            if(condition)
+                NEXT();
+            pc = code + pc -> a;
+            DISPATCH();
+        }
+
+        CALL:
+            // the arguments already on the stack are the first slots of the new frame
+            function = pc -> a;
+            enter(function, stack.size() - pc -> b);
+            frames.emplace_back(pc + 1, base, self);
+            base = stack.size() - program.functions[function].frame;
+            self = nullptr;
+            pc = code + program.functions[function].entry;
+            DISPATCH();
+        CALL_METHOD:
+            function = pc -> a;
+        method:
+            enter(function, stack.size() - pc -> b);
+            frames.emplace_back(pc + 1, base, self);
+            base = stack.size() - program.functions[function].frame;
+            self = ref;
+            pc = code + program.functions[function].entry;
+            DISPATCH();
+        CALL_NAMED: {
+            // The method is found in the layout of the instance by the types of the arguments
+            const auto& name = std::get<std::string>(program.constants[pc -> a]);
+            if(ref != nullptr && ref -> tag() == interpreter::Value::RECORD){
+                std::vector<std::string> paramTypes;
+                for(auto i = stack.size() - pc -> b; i < stack.size(); ++i)
+                    paramTypes.emplace_back(stack[i].type());
+                auto layout = std::get<interpreter::Record>(*ref).layout;
+                auto result = layout -> methods.find(std::make_pair(name, paramTypes));
+                if(result != layout -> methods.end()){
+                    function = program.methods.at(result -> second);
+                    goto method;
+                }
+            }
+            // Should never get here
+            throw std::runtime_error("Function with identifier " + name + " has not been declared.");
+        }
+
+        RETURN: {
+            auto result = std::move(TOP());
+            stack.resize(base);
+            const auto& frame = frames.back();
+            pc = frame.ret;
+            base = frame.base;
+            self = frame.self;
+            frames.pop_back();
+            stack.emplace_back(std::move(result));
+            DISPATCH();
+        }
+        LEAVE: {
+            stack.resize(base);
+            const auto& frame = frames.back();
+            pc = frame.ret;
+            base = frame.base;
+            self = frame.self;
+            frames.pop_back();
+            DISPATCH();
+        }
+
+        PRINT:
+            // nothing is printed for struct values
+            if(TOP().tag() != interpreter::Value::RECORD)
+                std::cout << TOP() << std::endl;
+            stack.pop_back();
+            NEXT();
+        HALT:
+            stack.clear();
+            return;
+
+#undef BINARY
+#undef TOP
+#undef NEXT
+#undef DISPATCH
+    }
+}
@@ -0,0 +1,54 @@
+//
+// Stack machine that runs the bytecode produced by visitor::Compiler.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_VM_H
+#define TEALANG_COMPILER_CPP20_VM_H
+
+#include "Bytecode.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace vm {
+    // Saved state of a caller
+    class Frame {
+    public:
+        Frame(const bytecode::Instruction* ret, std::size_t base, interpreter::Value* self) :
+                ret(ret),
+                base(base),
+                self(self)
+        {};
+
+        const bytecode::Instruction* ret;
+        std::size_t base;
+        interpreter::Value* self;
+    };
+
+    // Locals and operands of every active call live in one stack, a frame is the slots from its base
+    // the stack never grows past capacity so references into it stay valid
+    class VM {
+    public:
+        explicit VM(const bytecode::Program& program, std::size_t capacity = 1 << 20);
+        ~VM() = default;
+
+        void run();
+
+    private:
+        const bytecode::Program& program;
+        std::size_t capacity;
+        std::vector<interpreter::Value> globals;
+        std::vector<interpreter::Value> stack;
+        std::vector<Frame> frames;
+        // the instance every new instance of a constant struct is copied from, built by its constructor on first use
+        std::vector<std::unique_ptr<interpreter::Value>> prototypes;
+        // The instances of the other structs whose constructors are running, innermost last
+        // a constructor may build instances itself (through a call) so they are only handed over by their INSTANCE
+        std::vector<std::unique_ptr<interpreter::Value>> building;
+
+        // Reserve the frame of the function at index starting at base
+        void enter(int index, std::size_t base);
+    };
+}
+
+#endif //TEALANG_COMPILER_CPP20_VM_H
@@ -0,0 +1,952 @@
+//
+// Compiles a checked program into a tree of closures, bound once to the static types of their nodes.
+//
+
+#include "Closure_Visitor.h"
+#include <type_traits>
+
+namespace closure {
+    namespace {
+        using interpreter::Value;
+
+        int index(const Value& value) {
+            if(value.tag() == Value::INT)
+                return std::get<int>(value);
+            if(value.tag() == Value::FLOAT)
+                return (int) std::get<float>(value);
+            throw std::runtime_error("Array index of type " + value.type() + " is not a number.");
+        }
+
+        // The expression as a native T, unboxed when it has a native callable
+        template <typename T>
+        std::function<T(Context&)> as(const Expression& expression) {
+            if constexpr (std::is_same_v<T, int>){
+                if(expression.asInt) return expression.asInt;
+            }else if constexpr (std::is_same_v<T, float>){
+                if(expression.asFloat) return expression.asFloat;
+            }else if constexpr (std::is_same_v<T, bool>){
+                if(expression.asBool) return expression.asBool;
+            }
+            return [value = expression.value](Context& c){ return std::get<T>(value(c)); };
+        }
+
+        // Expression of static type T computed by f
+        template <typename T>
+        Expression typed(std::function<T(Context&)> f, const std::string& type) {
+            Expression expression;
+            expression.type = type;
+            if constexpr (std::is_same_v<T, int>) expression.asInt = f;
+            else if constexpr (std::is_same_v<T, float>) expression.asFloat = f;
+            else if constexpr (std::is_same_v<T, bool>) expression.asBool = f;
+            expression.value = [f](Context& c){ return Value(f(c)); };
+            return expression;
+        }
+
+        // Fill in the native callable of an expression computed as a Value
+        void native(Expression& expression) {
+            auto value = expression.value;
+            if(expression.type == "int")
+                expression.asInt = [value](Context& c){ return std::get<int>(value(c)); };
+            else if(expression.type == "float")
+                expression.asFloat = [value](Context& c){ return std::get<float>(value(c)); };
+            else if(expression.type == "bool")
+                expression.asBool = [value](Context& c){ return std::get<bool>(value(c)); };
+        }
+
+        // Read the variable where points at
+        template <typename F>
+        Expression load(F where, const std::string& type) {
+            Expression expression;
+            expression.type = type;
+            expression.value = [where](Context& c){ return *where(c); };
+            if(type == "int")
+                expression.asInt = [where](Context& c){ return std::get<int>(*where(c)); };
+            else if(type == "float")
+                expression.asFloat = [where](Context& c){ return std::get<float>(*where(c)); };
+            else if(type == "bool")
+                expression.asBool = [where](Context& c){ return std::get<bool>(*where(c)); };
+            return expression;
+        }
+
+        // Write the value to the variable where points at, the value is computed first
+        template <typename F>
+        Statement assign(F where, const Expression& expression) {
+            if(expression.asInt)
+                return [where, f = expression.asInt](Context& c){ *where(c) = f(c); return false; };
+            if(expression.asFloat)
+                return [where, f = expression.asFloat](Context& c){ *where(c) = f(c); return false; };
+            if(expression.asBool)
+                return [where, f = expression.asBool](Context& c){ *where(c) = f(c); return false; };
+            return [where, f = expression.value](Context& c){ *where(c) = f(c); return false; };
+        }
+
+        // left op right on two T, the left operand is evaluated first
+        template <typename T, typename Op>
+        auto binary(const Expression& left, const Expression& right) {
+            typedef decltype(Op()(std::declval<T>(), std::declval<T>())) R;
+            return std::function<R(Context&)>([l = as<T>(left), r = as<T>(right)](Context& c){
+                T _left = l(c);
+                return Op()(_left, r(c));
+            });
+        }
+
+        // Comparisons, ordered is false for the types that can only be compared for equality
+        template <typename T>
+        bool compare(lexer::TOKEN_TYPE op, const Expression& left, const Expression& right, bool ordered, Expression& result) {
+            switch (op) {
+                case lexer::TOK_EQAUL_TO:
+                    result = typed(binary<T, std::equal_to<T>>(left, right), "bool");
+                    return true;
+                case lexer::TOK_NOT_EQAUL_TO:
+                    result = typed(binary<T, std::not_equal_to<T>>(left, right), "bool");
+                    return true;
+                default:
+                    break;
+            }
+            if(!ordered)
+                return false;
+            switch (op) {
+                case lexer::TOK_MORE_THAN:
+                    result = typed(binary<T, std::greater<T>>(left, right), "bool");
+                    return true;
+                case lexer::TOK_LESS_THAN:
+                    result = typed(binary<T, std::less<T>>(left, right), "bool");
+                    return true;
+                case lexer::TOK_MORE_THAN_EQUAL_TO:
+                    result = typed(binary<T, std::greater_equal<T>>(left, right), "bool");
+                    return true;
+                case lexer::TOK_LESS_THAN_EQUAL_TO:
+                    result = typed(binary<T, std::less_equal<T>>(left, right), "bool");
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // int and float operators
+        template <typename T>
+        bool arithmetic(lexer::TOKEN_TYPE op, const Expression& left, const Expression& right, Expression& result) {
+            switch (op) {
+                case lexer::TOK_PLUS:
+                    result = typed(binary<T, std::plus<T>>(left, right), left.type);
+                    return true;
+                case lexer::TOK_MINUS:
+                    result = typed(binary<T, std::minus<T>>(left, right), left.type);
+                    return true;
+                case lexer::TOK_ASTERISK:
+                    result = typed(binary<T, std::multiplies<T>>(left, right), left.type);
+                    return true;
+                case lexer::TOK_DIVIDE:
+                    result = typed(binary<T, std::divides<T>>(left, right), left.type);
+                    return true;
+                default:
+                    return compare<T>(op, left, right, true, result);
+            }
+        }
+
+        // bool operators
+        bool logical(lexer::TOKEN_TYPE op, const Expression& left, const Expression& right, Expression& result) {
+            switch (op) {
+                case lexer::TOK_AND:
+                    result = typed(binary<bool, std::logical_and<bool>>(left, right), "bool");
+                    return true;
+                case lexer::TOK_OR:
+                    result = typed(binary<bool, std::logical_or<bool>>(left, right), "bool");
+                    return true;
+                default:
+                    return compare<bool>(op, left, right, true, result);
+            }
+        }
+
+        // string operators
+        bool concatenate(lexer::TOKEN_TYPE op, const Expression& left, const Expression& right, Expression& result) {
+            if(op == lexer::TOK_PLUS){
+                result = typed(binary<std::string, std::plus<std::string>>(left, right), "string");
+                return true;
+            }
+            return compare<std::string>(op, left, right, false, result);
+        }
+
+        // Push the arguments of a call, returns where the frame of the callee starts
+        std::size_t push(Context& c, const std::vector<std::function<Value(Context&)>>& arguments) {
+            auto base = c.stack.size();
+            if(base + arguments.size() > c.stack.capacity())
+                throw std::runtime_error("Stack depth exceeded.");
+            for(const auto& argument : arguments)
+                c.stack.emplace_back(argument(c));
+            return base;
+        }
+
+        // Run function on the arguments pushed from base
+        Value invoke(Context& c, const Function& function, std::size_t base, Value* self) {
+            // the body runs nested in the native calls of the closures of the caller
+            if(base + function.frame > c.stack.capacity() || interpreter::available() == 0)
+                throw std::runtime_error("Stack depth exceeded calling " + function.identifier + ".");
+            c.stack.resize(base + function.frame);
+            auto _locals = c.locals;
+            auto _self = c.self;
+            c.locals = c.stack.data() + base;
+            c.self = self;
+            if(!function.body(c))
+                c.result = 0;
+            c.locals = _locals;
+            c.self = _self;
+            c.stack.resize(base);
+            return std::move(c.result);
+        }
+
+        // A new instance of struct index, a copy of its prototype (built on first use) when the struct is constant
+        Value instantiate(Context& c, int index) {
+            const auto& layout = c.program.structs[index];
+            // The constructor initialises the fields, it can refer to the fields it already initialised
+            if(!layout.constant){
+                Value instance = interpreter::Record(&layout);
+                invoke(c, *c.program.constructors[index], c.stack.size(), &instance);
+                return instance;
+            }
+            auto& prototype = c.prototypes[index];
+            if(prototype == nullptr){
+                prototype = std::make_unique<Value>(interpreter::Record(&layout));
+                invoke(c, *c.program.constructors[index], c.stack.size(), prototype.get());
+            }
+            return *prototype;
+        }
+
+        // Does the identifier or its last child have an index
+        parser::ASTIdentifierNode* indexed(parser::ASTIdentifierNode* identifierNode) {
+            auto last = identifierNode;
+            while(last->getChild() != nullptr && !last->getChild()->isEmpty())
+                last = last->getChild().get();
+            return last->ilocExprNode != nullptr ? last : nullptr;
+        }
+
+        // Type of the elements of an array type
+        std::string element(const std::string& type) {
+            return type.ends_with("[]") ? type.substr(0, type.size() - 2) : type;
+        }
+
+        std::function<int(Context&)> position(const Expression& expression) {
+            if(expression.asInt)
+                return expression.asInt;
+            return [value = expression.value](Context& c){ return index(value(c)); };
+        }
+    }
+
+    Context::Context(const Program &program, std::size_t capacity) :
+            program(program),
+            globals(program.globals),
+            locals(nullptr),
+            self(nullptr),
+            prototypes(program.structs.size())
+    {
+        stack.reserve(capacity);
+    }
+
+    void Program::run(std::size_t capacity) const {
+        // calls nest natively like those of the interpreter, the program runs on a native stack as large as its own
+        interpreter::onStack([this, capacity](){
+            Context context(*this, capacity);
+            invoke(context, main, 0, nullptr);
+        }, visitor::Interpreter::defaultCapacity * visitor::Interpreter::frameBytes);
+    }
+}
+
+namespace visitor {
+    using interpreter::Value;
+
+    ClosureCompiler::ClosureCompiler() {
+        next = 0;
+        frame = 0;
+        function = nullptr;
+        structure = nullptr;
+    }
+
+    compiler::Symbol ClosureCompiler::declare(const std::string &identifier, const std::string &type, bool nothing) {
+        if(scopes.empty()){
+            // a top level declaration, its slot was given to it before any code was compiled
+            auto& symbol = globals.at(identifier);
+            symbol.type = type;
+            if(nothing) symbol.kind = compiler::Symbol::NOTHING;
+            return symbol;
+        }
+        compiler::Symbol symbol(nothing ? compiler::Symbol::NOTHING : compiler::Symbol::LOCAL, next++, type);
+        frame = std::max(frame, next);
+        scopes.back().insert_or_assign(identifier, symbol);
+        return symbol;
+    }
+
+    compiler::Symbol ClosureCompiler::lookup(const std::string &identifier) {
+        // the innermost declaration, then the members of the instance, then the globals
+        for(auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope){
+            auto result = scope->find(identifier);
+            if(result != scope->end())
+                return result->second;
+        }
+        if(structure != nullptr){
+            auto offset = structure->offsets.find(identifier);
+            if(offset != structure->offsets.end()){
+                auto declarationNode = structure->fields.at(offset->second);
+                // nothing is stored for arrays of structs
+                bool nothing = declarationNode->identifier->ilocExprNode != nullptr && lexer::isStruct(declarationNode->type);
+                return {nothing ? compiler::Symbol::NOTHING : compiler::Symbol::MEMBER, (int) offset->second,
+                        declarationNode->type + (declarationNode->identifier->ilocExprNode != nullptr ? "[]" : "")};
+            }
+            if(identifier == "self")
+                return {compiler::Symbol::SELF, 0, structure->id};
+        }
+        auto result = globals.find(identifier);
+        if(result != globals.end())
+            return result->second;
+        // Should never get here because of the semantic pass
+        throw std::runtime_error("Variable with identifier " + identifier + " has not been declared.");
+    }
+
+    closure::Reference ClosureCompiler::reference(parser::ASTIdentifierNode *identifierNode, parser::ASTIdentifierNode *last, std::string& type) {
+        auto symbol = lookup(identifierNode->identifier);
+        closure::Reference where;
+        int slot = symbol.slot;
+        switch (symbol.kind) {
+            case compiler::Symbol::LOCAL:
+                where = [slot](closure::Context& c){ return c.locals + slot; };
+                break;
+            case compiler::Symbol::GLOBAL:
+                where = [slot](closure::Context& c){ return &c.globals[slot]; };
+                break;
+            case compiler::Symbol::MEMBER:
+                where = [slot](closure::Context& c){ return &std::get<interpreter::Record>(*c.self).fields[slot]; };
+                break;
+            case compiler::Symbol::SELF:
+                where = [](closure::Context& c){ return c.self; };
+                break;
+            case compiler::Symbol::NOTHING:
+                type = "";
+                return nullptr;
+        }
+        type = symbol.type;
+        bool element = identifierNode->ilocExprNode != nullptr;
+        // The members are at a fixed offset in the fields of the instance
+        for(auto child = identifierNode->getChild(); child != nullptr && !child->isEmpty() && child.get() != last; child = child->getChild()){
+            // nothing is stored for arrays of structs
+            if(element){
+                type = "";
+                return nullptr;
+            }
+            auto s = structs.find(type);
+            if(s == structs.end()){
+                // the struct is only known at runtime
+                where = [where, name = child->identifier](closure::Context& c){
+                    auto& record = std::get<interpreter::Record>(*where(c));
+                    return &record.fields[record.layout->offsets.at(name)];
+                };
+                type = "auto";
+            }else{
+                auto& layout = program.structs.at(s->second);
+                auto offset = layout.offsets.at(child->identifier);
+                auto declarationNode = layout.fields.at(offset);
+                if(declarationNode->identifier->ilocExprNode != nullptr && lexer::isStruct(declarationNode->type)){
+                    type = "";
+                    return nullptr;
+                }
+                where = [where, offset](closure::Context& c){ return &std::get<interpreter::Record>(*where(c)).fields[offset]; };
+                type = declarationNode->type + (declarationNode->identifier->ilocExprNode != nullptr ? "[]" : "");
+            }
+            element = child->ilocExprNode != nullptr;
+        }
+        return where;
+    }
+
+    closure::Expression ClosureCompiler::instance(int index) {
+        closure::Expression result;
+        result.type = program.structs.at(index).id;
+        result.value = [index](closure::Context& c){ return closure::instantiate(c, index); };
+        return result;
+    }
+
+    closure::Statement ClosureCompiler::store(const compiler::Symbol &symbol, const closure::Expression &value) {
+        int slot = symbol.slot;
+        switch (symbol.kind) {
+            case compiler::Symbol::LOCAL:
+                return closure::assign([slot](closure::Context& c){ return c.locals + slot; }, value);
+            case compiler::Symbol::GLOBAL:
+                return closure::assign([slot](closure::Context& c){ return &c.globals[slot]; }, value);
+            case compiler::Symbol::MEMBER:
+                return closure::assign([slot](closure::Context& c){ return &std::get<interpreter::Record>(*c.self).fields[slot]; }, value);
+            case compiler::Symbol::SELF:
+                return closure::assign([](closure::Context& c){ return c.self; }, value);
+            default:
+                // nothing is stored for arrays of structs
+                return [v = value.value](closure::Context& c){ v(c); return false; };
+        }
+    }
+
+    void ClosureCompiler::visit(parser::ASTProgramNode *programNode) {
+        // The layouts, every function and every global get their place before any code is compiled
+        // so that the functions can use the globals declared after them
+        for(auto &s : programNode->statements){
+            if(auto structNode = dynamic_cast<parser::ASTStructNode*>(s.get())){
+                structs.insert(std::make_pair(structNode->identifier->getID(), (int) program.structs.size()));
+                program.structs.emplace_back(structNode);
+                program.constructors.emplace_back(&program.functions.emplace_back(structNode->identifier->getID(), 0));
+                for(const auto& method : program.structs.back().methods){
+                    auto f = &program.functions.emplace_back(method.first.first, (int) method.second->parameters.size());
+                    functions.insert(std::make_pair(method.second, f));
+                    program.methods.insert(std::make_pair(method.second, f));
+                }
+            }else if(auto functionDeclarationNode = dynamic_cast<parser::ASTFunctionDeclarationNode*>(s.get())){
+                auto f = &program.functions.emplace_back(functionDeclarationNode->identifier->getID(), (int) functionDeclarationNode->parameters.size());
+                functions.insert(std::make_pair(functionDeclarationNode, f));
+            }else if(auto declarationNode = dynamic_cast<parser::ASTDeclarationNode*>(s.get())){
+                bool nothing = declarationNode->identifier->ilocExprNode != nullptr && lexer::isStruct(declarationNode->type);
+                globals.insert(std::make_pair(declarationNode->identifier->getID(),
+                                              compiler::Symbol(nothing ? compiler::Symbol::NOTHING : compiler::Symbol::GLOBAL, program.globals++,
+                                                               declarationNode->type + (declarationNode->identifier->ilocExprNode != nullptr ? "[]" : ""))));
+            }
+        }
+
+        // The constructors and methods of each struct then the functions, in program order
+        for(auto &s : programNode->statements){
+            if(auto structNode = dynamic_cast<parser::ASTStructNode*>(s.get())){
+                int index = structs.at(structNode->identifier->getID());
+                construct(index);
+                for(const auto& method : program.structs.at(index).methods)
+                    compile(method.second, &program.structs.at(index));
+            }else if(auto functionDeclarationNode = dynamic_cast<parser::ASTFunctionDeclarationNode*>(s.get())){
+                compile(functionDeclarationNode, nullptr);
+            }
+        }
+
+        // The top level statements
+        next = frame = 0;
+        std::vector<closure::Statement> statements;
+        for(auto &s : programNode->statements){
+            statement = nullptr;
+            s->accept(this);
+            if(statement)
+                statements.emplace_back(std::move(statement));
+        }
+        program.main.frame = frame;
+        program.main.body = [statements](closure::Context& c){
+            // a return outside of a function only ends its own statement
+            for(const auto& s : statements)
+                s(c);
+            return false;
+        };
+    }
+
+    void ClosureCompiler::compile(parser::ASTFunctionDeclarationNode *functionDeclarationNode, interpreter::Struct *owner) {
+        auto f = functions.at(functionDeclarationNode);
+        next = frame = f->parameters;
+        function = functionDeclarationNode;
+        structure = owner;
+        // the parameters are the first slots of the frame
+        scopes.emplace_back();
+        for(int i = 0; i < functionDeclarationNode->parameters.size(); ++i){
+            const auto& parameter = functionDeclarationNode->parameters.at(i);
+            scopes.back().insert_or_assign(parameter.first, compiler::Symbol(compiler::Symbol::LOCAL, i, parameter.second));
+        }
+        functionDeclarationNode->functionBlock->accept(this);
+        f->body = std::move(statement);
+        f->frame = frame;
+        scopes.clear();
+        function = nullptr;
+        structure = nullptr;
+    }
+
+    void ClosureCompiler::construct(int index) {
+        auto& layout = program.structs.at(index);
+        auto constructor = program.constructors.at(index);
+        next = frame = 0;
+        structure = &layout;
+        // The initial values of the fields in declaration order, they can refer to the fields declared before them
+        std::vector<closure::Statement> statements;
+        for(int i = 0; i < layout.fields.size(); ++i){
+            auto declarationNode = layout.fields.at(i);
+            auto field = [i](closure::Context& c){ return &std::get<interpreter::Record>(*c.self).fields[i]; };
+            if(declarationNode->exprNode != nullptr){
+                expression.type = declarationNode->type;
+                declarationNode->exprNode->accept(this);
+                if(expression.type.empty())
+                    statements.emplace_back([v = expression.value](closure::Context& c){ v(c); return false; });
+                else
+                    statements.emplace_back(closure::assign(field, expression));
+            }else if(declarationNode->identifier->ilocExprNode != nullptr){
+                declarationNode->identifier->ilocExprNode->accept(this);
+                auto size = closure::position(expression);
+                // nothing is stored for arrays of structs
+                if(lexer::isStruct(declarationNode->type)){
+                    statements.emplace_back([size](closure::Context& c){ size(c); return false; });
+                }else{
+                    closure::Expression array;
+                    array.value = [size, type = declarationNode->type](closure::Context& c){ return Value::array(type, size(c)); };
+                    statements.emplace_back(closure::assign(field, array));
+                }
+            }else if(declarationNode->type != layout.id){
+                statements.emplace_back(closure::assign(field, instance(structs.at(declarationNode->type))));
+            }
+        }
+        constructor->frame = frame;
+        constructor->body = [statements](closure::Context& c){
+            for(const auto& s : statements)
+                s(c);
+            return false;
+        };
+        structure = nullptr;
+    }
+
+    // Expressions
+    // Every expression sets expression to its closure
+    void ClosureCompiler::visit(parser::ASTLiteralNode<int> *literalNode) {
+        expression = closure::typed(std::function<int(closure::Context&)>([val = literalNode->val](closure::Context&){ return val; }), "int");
+    }
+
+    void ClosureCompiler::visit(parser::ASTLiteralNode<float> *literalNode) {
+        expression = closure::typed(std::function<float(closure::Context&)>([val = literalNode->val](closure::Context&){ return val; }), "float");
+    }
+
+    void ClosureCompiler::visit(parser::ASTLiteralNode<bool> *literalNode) {
+        expression = closure::typed(std::function<bool(closure::Context&)>([val = literalNode->val](closure::Context&){ return val; }), "bool");
+    }
+
+    void ClosureCompiler::visit(parser::ASTLiteralNode<char> *literalNode) {
+        expression = closure::typed(std::function<char(closure::Context&)>([val = literalNode->val](closure::Context&){ return val; }), "char");
+    }
+
+    void ClosureCompiler::visit(parser::ASTLiteralNode<std::string> *literalNode) {
+        expression = closure::typed(std::function<std::string(closure::Context&)>([val = literalNode->val](closure::Context&){ return val; }), "string");
+    }
+
+    void ClosureCompiler::visit(parser::ASTArrayLiteralNode *arrayLiteralNode) {
+        // the type of the expression is the declared type of the elements
+        std::string type = expression.type;
+        closure::Expression result;
+        if(lexer::isStruct(type)){
+            // nothing is stored for arrays of structs, the elements are not evaluated
+            result.value = [](closure::Context&){ return Value(0); };
+            expression = result;
+            return;
+        }
+        std::vector<std::function<Value(closure::Context&)>> items;
+        for(const auto& item : arrayLiteralNode->expressions){
+            item->accept(this);
+            items.emplace_back(expression.value);
+        }
+        result.type = type + "[]";
+        result.value = [type, items](closure::Context& c){
+            auto elements = Value::array(type, 0);
+            for(const auto& item : items)
+                elements.push_back(item(c));
+            return elements;
+        };
+        expression = result;
+    }
+
+    void ClosureCompiler::visit(parser::ASTBinaryNode *binaryNode) {
+        binaryNode->left->accept(this);
+        auto left = expression;
+        binaryNode->right->accept(this);
+        auto right = expression;
+
+        // The operator is picked here when both types are known, otherwise the values are checked at runtime
+        auto op = lexer::determineOperatorType(binaryNode->op);
+        closure::Expression result;
+        bool bound = false;
+        if(left.type == right.type){
+            if(left.type == "int")
+                bound = closure::arithmetic<int>(op, left, right, result);
+            else if(left.type == "float")
+                bound = closure::arithmetic<float>(op, left, right, result);
+            else if(left.type == "bool")
+                bound = closure::logical(op, left, right, result);
+            else if(left.type == "char")
+                bound = closure::compare<char>(op, left, right, false, result);
+            else if(left.type == "string")
+                bound = closure::concatenate(op, left, right, result);
+        }
+        if(!bound){
+            result.value = [l = left.value, r = right.value, kind = binaryNode->kind, lineNumber = binaryNode->lineNumber](closure::Context& c){
+                auto _left = l(c);
+                return interpreter::apply(kind, _left, r(c), lineNumber);
+            };
+            bool comparison = op == lexer::TOK_LESS_THAN || op == lexer::TOK_MORE_THAN || op == lexer::TOK_LESS_THAN_EQUAL_TO
+                              || op == lexer::TOK_MORE_THAN_EQUAL_TO || op == lexer::TOK_EQAUL_TO || op == lexer::TOK_NOT_EQAUL_TO
+                              || op == lexer::TOK_AND || op == lexer::TOK_OR;
+            result.type = comparison ? "bool" : left.type == right.type ? left.type : "auto";
+            closure::native(result);
+        }
+        expression = result;
+    }
+
+    void ClosureCompiler::visit(parser::ASTIdentifierNode *identifierNode) {
+        if((identifierNode->getChild() == nullptr || identifierNode->getChild()->isEmpty()) && identifierNode->ilocExprNode == nullptr){
+            // A plain variable is read straight from its slot
+            auto symbol = lookup(identifierNode->identifier);
+            int slot = symbol.slot;
+            switch (symbol.kind) {
+                case compiler::Symbol::LOCAL:
+                    // a parameter may hold an array of its type, it is only unboxed by the operator that uses it
+                    if(function != nullptr && slot < function->parameters.size())
+                        expression = closure::load([slot](closure::Context& c){ return c.locals + slot; }, "");
+                    else
+                        expression = closure::load([slot](closure::Context& c){ return c.locals + slot; }, symbol.type);
+                    expression.type = symbol.type;
+                    return;
+                case compiler::Symbol::GLOBAL:
+                    expression = closure::load([slot](closure::Context& c){ return &c.globals[slot]; }, symbol.type);
+                    return;
+                case compiler::Symbol::MEMBER:
+                    expression = closure::load([slot](closure::Context& c){ return &std::get<interpreter::Record>(*c.self).fields[slot]; }, symbol.type);
+                    return;
+                case compiler::Symbol::SELF:
+                    expression = closure::load([](closure::Context& c){ return c.self; }, symbol.type);
+                    return;
+                case compiler::Symbol::NOTHING:
+                    expression = closure::Expression();
+                    expression.value = [](closure::Context&){ return Value(0); };
+                    return;
+            }
+        }
+        // the index is evaluated before the reference is taken
+        std::function<int(closure::Context&)> at;
+        auto element = closure::indexed(identifierNode);
+        if(element != nullptr){
+            element->ilocExprNode->accept(this);
+            at = closure::position(expression);
+        }
+        std::string type;
+        auto where = reference(identifierNode, nullptr, type);
+        closure::Expression result;
+        if(type.empty()){
+            // nothing is stored for arrays of structs
+            result.value = [at](closure::Context& c){ if(at) at(c); return Value(0); };
+        }else if(element != nullptr){
+            result.type = closure::element(type);
+            result.value = [at, where](closure::Context& c){
+                int i = at(c);
+                return where(c)->at(i);
+            };
+            closure::native(result);
+        }else{
+            result = closure::load(where, type);
+        }
+        expression = result;
+    }
+
+    void ClosureCompiler::visit(parser::ASTUnaryNode *unaryNode) {
+        unaryNode->exprNode->accept(this);
+        if(expression.type == "int"){
+            expression = closure::typed(std::function<int(closure::Context&)>([f = closure::as<int>(expression)](closure::Context& c){ return f(c) * -1; }), "int");
+        }else if(expression.type == "float"){
+            expression = closure::typed(std::function<float(closure::Context&)>([f = closure::as<float>(expression)](closure::Context& c){ return f(c) * -1; }), "float");
+        }else if(expression.type == "bool"){
+            expression = closure::typed(std::function<bool(closure::Context&)>([f = closure::as<bool>(expression)](closure::Context& c){ return !f(c); }), "bool");
+        }else{
+            auto type = expression.type;
+            expression.value = [f = expression.value, lineNumber = unaryNode->lineNumber](closure::Context& c){
+                return interpreter::negate(f(c), lineNumber);
+            };
+            expression.asInt = nullptr;
+            expression.asFloat = nullptr;
+            expression.asBool = nullptr;
+            expression.type = type;
+        }
+    }
+
+    // Tasks need the interpreter's scheduler, closures have nothing for them
+    void ClosureCompiler::visit(parser::ASTSpawnNode *spawnNode) {
+        throw std::runtime_error("spawn on line " + std::to_string(spawnNode->lineNumber) + " is only supported by the interpreter.");
+    }
+
+    void ClosureCompiler::visit(parser::ASTAwaitNode *awaitNode) {
+        throw std::runtime_error("await on line " + std::to_string(awaitNode->lineNumber) + " is only supported by the interpreter.");
+    }
+
+    void ClosureCompiler::visit(parser::ASTFunctionCallNode *functionCallNode) {
+        call(functionCallNode->identifier, functionCallNode->parameters, functionCallNode->callee, functionCallNode->lineNumber);
+    }
+    // Expressions
+
+    // Statements
+    // Every statement sets statement to its closure
+    void ClosureCompiler::visit(parser::ASTSFunctionCallNode *sFunctionCallNode) {
+        call(sFunctionCallNode->identifier, sFunctionCallNode->parameters, sFunctionCallNode->callee, sFunctionCallNode->lineNumber);
+        // the result is not used
+        statement = [f = expression.value](closure::Context& c){ f(c); return false; };
+    }
+
+    void ClosureCompiler::call(const std::shared_ptr<parser::ASTIdentifierNode>& identifier, const std::vector<std::shared_ptr<parser::ASTExprNode>>& parameters,
+                               parser::ASTFunctionDeclarationNode* callee, unsigned int lineNumber) {
+        // The arguments become the first slots of the frame of the callee
+        std::vector<std::string> paramTypes;
+        std::vector<std::function<Value(closure::Context&)>> arguments;
+        for(const auto& param : parameters){
+            param->accept(this);
+            paramTypes.emplace_back(closure::element(expression.type));
+            arguments.emplace_back(expression.value);
+        }
+        // the type of the result, auto functions have the type of their first return
+        auto result = [this](parser::ASTFunctionDeclarationNode* declaration){
+            if(declaration->type != "auto")
+                return declaration->type;
+            auto type = types.find(declaration);
+            return type != types.end() ? type->second : std::string("auto");
+        };
+        closure::Expression call;
+        if(callee == nullptr){
+            // A method, the instance it runs on is the identifier up to its last child (self for bare calls)
+            auto name = identifier.get();
+            while(name->getChild() != nullptr && !name->getChild()->isEmpty())
+                name = name->getChild().get();
+            interpreter::Struct* layout = nullptr;
+            closure::Reference receiver;
+            if(name != identifier.get()){
+                std::string type;
+                receiver = reference(identifier.get(), name, type);
+                auto s = structs.find(type);
+                if(s != structs.end())
+                    layout = &program.structs.at(s->second);
+            }else if(structure != nullptr && std::any_of(structure->methods.begin(), structure->methods.end(),
+                                                         [name](const auto& method){ return method.first.first == name->identifier; })){
+                receiver = [](closure::Context& c){ return c.self; };
+                layout = structure;
+            }else{
+                // a global function that was not resolved by the semantic pass
+                for(const auto& f : functions){
+                    if(program.methods.count(f.first) != 0 || f.first->identifier->getID() != name->identifier || f.first->parameters.size() != arguments.size())
+                        continue;
+                    bool matches = true;
+                    for(int i = 0; i < arguments.size(); ++i)
+                        matches = matches && (paramTypes.at(i) == "auto" || paramTypes.at(i) == f.first->parameters.at(i).second);
+                    if(matches){
+                        callee = f.first;
+                        break;
+                    }
+                }
+                if(callee == nullptr)
+                    throw std::runtime_error("Function with identifier " + identifier->getID() + " called on line "
+                                             + std::to_string(lineNumber) + " has not been declared.");
+            }
+            if(callee == nullptr){
+                std::map<std::pair<std::string, std::vector<std::string>>, parser::ASTFunctionDeclarationNode*>::iterator method;
+                if(layout != nullptr && (method = layout->methods.find(std::make_pair(name->identifier, paramTypes))) != layout->methods.end()){
+                    call.value = [arguments, receiver, f = functions.at(method->second)](closure::Context& c){
+                        auto base = closure::push(c, arguments);
+                        return closure::invoke(c, *f, base, receiver(c));
+                    };
+                    call.type = result(method->second);
+                }else{
+                    // The method is looked up in the struct of the instance when it is called
+                    call.value = [arguments, receiver, name = name->identifier](closure::Context& c){
+                        auto base = closure::push(c, arguments);
+                        auto self = receiver ? receiver(c) : nullptr;
+                        if(self != nullptr && self->tag() == Value::RECORD){
+                            std::vector<std::string> types;
+                            for(auto i = base; i < c.stack.size(); ++i)
+                                types.emplace_back(c.stack[i].type());
+                            auto layout = std::get<interpreter::Record>(*self).layout;
+                            auto method = layout->methods.find(std::make_pair(name, types));
+                            if(method != layout->methods.end())
+                                return closure::invoke(c, *c.program.methods.at(method->second), base, self);
+                        }
+                        // Should never get here
+                        throw std::runtime_error("Function with identifier " + name + " has not been declared.");
+                    };
+                    call.type = "auto";
+                }
+                closure::native(call);
+                expression = call;
+                return;
+            }
+        }
+        call.value = [arguments, f = functions.at(callee)](closure::Context& c){
+            auto base = closure::push(c, arguments);
+            return closure::invoke(c, *f, base, nullptr);
+        };
+        call.type = result(callee);
+        closure::native(call);
+        expression = call;
+    }
+
+    void ClosureCompiler::visit(parser::ASTDeclarationNode *declarationNode) {
+        auto id = declarationNode->identifier->getID();
+        if(declarationNode->exprNode != nullptr){
+            // by setting the type we help to init an array literal
+            expression.type = declarationNode->type;
+            declarationNode->exprNode->accept(this);
+            // nothing is stored for arrays of structs
+            auto type = declarationNode->type == "auto" ? expression.type
+                        : declarationNode->type + (declarationNode->identifier->ilocExprNode != nullptr ? "[]" : "");
+            auto symbol = declare(id, type, expression.type.empty());
+            statement = store(symbol, expression);
+        }else if(declarationNode->identifier->ilocExprNode != nullptr){
+            // array declaration case
+            declarationNode->identifier->ilocExprNode->accept(this);
+            auto size = closure::position(expression);
+            if(lexer::isStruct(declarationNode->type)){
+                declare(id, declarationNode->type, true);
+                statement = [size](closure::Context& c){ size(c); return false; };
+                return;
+            }
+            closure::Expression array;
+            array.type = declarationNode->type + "[]";
+            array.value = [size, type = declarationNode->type](closure::Context& c){ return Value::array(type, size(c)); };
+            statement = store(declare(id, array.type, false), array);
+        }else{
+            // struct case, a new instance with its fields initialised (see interpreter::Struct::constant)
+            auto value = instance(structs.at(declarationNode->type));
+            statement = store(declare(id, declarationNode->type, false), value);
+        }
+    }
+
+    void ClosureCompiler::visit(parser::ASTAssignmentNode *assignmentNode) {
+        assignmentNode->exprNode->accept(this);
+        auto value = expression;
+        // nothing is stored for arrays of structs
+        if(value.type.empty()){
+            statement = [v = value.value](closure::Context& c){ v(c); return false; };
+            return;
+        }
+        auto identifierNode = assignmentNode->identifier.get();
+        if((identifierNode->getChild() == nullptr || identifierNode->getChild()->isEmpty()) && identifierNode->ilocExprNode == nullptr){
+            statement = store(lookup(identifierNode->identifier), value);
+            return;
+        }
+        // The target is referenced once the value is computed
+        std::function<int(closure::Context&)> at;
+        auto element = closure::indexed(identifierNode);
+        if(element != nullptr){
+            element->ilocExprNode->accept(this);
+            at = closure::position(expression);
+        }
+        std::string type;
+        auto where = reference(identifierNode, nullptr, type);
+        if(type.empty()){
+            statement = [v = value.value, at](closure::Context& c){ v(c); if(at) at(c); return false; };
+        }else if(element != nullptr){
+            statement = [v = value.value, at, where](closure::Context& c){
+                auto _value = v(c);
+                int i = at(c);
+                where(c)->set(i, _value);
+                return false;
+            };
+        }else{
+            statement = closure::assign(where, value);
+        }
+    }
+
+    void ClosureCompiler::visit(parser::ASTPrintNode *printNode) {
+        printNode->exprNode->accept(this);
+        // nothing is printed for struct values
+        if(lexer::isStruct(closure::element(expression.type))){
+            statement = [v = expression.value](closure::Context& c){ v(c); return false; };
+            return;
+        }
+        statement = [v = expression.value](closure::Context& c){
+            auto value = v(c);
+            if(value.tag() != Value::RECORD)
+                std::cout << value << std::endl;
+            return false;
+        };
+    }
+
+    void ClosureCompiler::visit(parser::ASTBlockNode *blockNode) {
+        // the slots of the block's declarations are reused once it is over
+        scopes.emplace_back();
+        int _next = next;
+        std::vector<closure::Statement> statements;
+        for(auto &s : blockNode->statements){
+            statement = nullptr;
+            s->accept(this);
+            if(statement)
+                statements.emplace_back(std::move(statement));
+        }
+        next = _next;
+        scopes.pop_back();
+        statement = [statements](closure::Context& c){
+            // stop at a return
+            for(const auto& s : statements)
+                if(s(c)) return true;
+            return false;
+        };
+    }
+
+    void ClosureCompiler::visit(parser::ASTIfNode *ifNode) {
+        ifNode->condition->accept(this);
+        auto condition = closure::as<bool>(expression);
+        ifNode->ifBlock->accept(this);
+        auto ifBlock = std::move(statement);
+        closure::Statement elseBlock;
+        if(ifNode->elseBlock != nullptr){
+            ifNode->elseBlock->accept(this);
+            elseBlock = std::move(statement);
+        }
+        statement = [condition, ifBlock, elseBlock](closure::Context& c){
+            if(condition(c))
+                return ifBlock(c);
+            return elseBlock ? elseBlock(c) : false;
+        };
+    }
+
+    void ClosureCompiler::visit(parser::ASTForNode *forNode) {
+        // the loop variable only lives as long as the loop
+        scopes.emplace_back();
+        int _next = next;
+        closure::Statement declaration;
+        if(forNode->declaration != nullptr){
+            forNode->declaration->accept(this);
+            declaration = std::move(statement);
+        }
+        forNode->condition->accept(this);
+        auto condition = closure::as<bool>(expression);
+        forNode->loopBlock->accept(this);
+        auto loopBlock = std::move(statement);
+        closure::Statement assignment;
+        if(forNode->assignment != nullptr){
+            forNode->assignment->accept(this);
+            assignment = std::move(statement);
+        }
+        next = _next;
+        scopes.pop_back();
+        statement = [declaration, condition, loopBlock, assignment](closure::Context& c){
+            if(declaration) declaration(c);
+            while(condition(c)){
+                if(loopBlock(c)) return true;
+                if(assignment) assignment(c);
+            }
+            return false;
+        };
+    }
+
+    void ClosureCompiler::visit(parser::ASTWhileNode *whileNode) {
+        whileNode->condition->accept(this);
+        auto condition = closure::as<bool>(expression);
+        whileNode->loopBlock->accept(this);
+        statement = [condition, loopBlock = std::move(statement)](closure::Context& c){
+            while(condition(c))
+                if(loopBlock(c)) return true;
+            return false;
+        };
+    }
+
+    void ClosureCompiler::visit(parser::ASTFunctionDeclarationNode *functionDeclarationNode) {
+        // compiled on its own before the top level statements
+        statement = nullptr;
+    }
+
+    void ClosureCompiler::visit(parser::ASTReturnNode *returnNode) {
+        returnNode->exprNode->accept(this);
+        if(function == nullptr){
+            // a return outside of a function only ends its own statement
+            statement = [v = expression.value](closure::Context& c){ v(c); return true; };
+            return;
+        }
+        if(function->type == "auto" && !expression.type.empty())
+            types.insert(std::make_pair(function, expression.type));
+        statement = [v = expression.value](closure::Context& c){ c.result = v(c); return true; };
+    }
+
+    void ClosureCompiler::visit(parser::ASTStructNode *structNode) {
+        // the layout was built before any code was compiled
+        statement = nullptr;
+    }
+    // Statements
+}
@@ -0,0 +1,178 @@
+//
+// Compiles a checked program into a tree of closures, bound once to the static types of their nodes.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_CLOSURE_VISITOR_H
+#define TEALANG_COMPILER_CPP20_CLOSURE_VISITOR_H
+
+#include "Visitor.h"
+#include "Interpreter_Visitor.h"
+#include "Compiler_Visitor.h"
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace closure {
+    class Program;
+
+    // Runtime state of one run of a program
+    class Context {
+    public:
+        Context(const Program& program, std::size_t capacity);
+
+        const Program& program;
+        std::vector<interpreter::Value> globals;
+        // The frames of the active calls, reserved up front so that locals never move
+        std::vector<interpreter::Value> stack;
+        // the frame of the running function and the instance it runs on
+        interpreter::Value* locals;
+        interpreter::Value* self;
+        // value of the last return
+        interpreter::Value result;
+        // the instance every new instance of a constant struct is copied from
+        std::vector<std::unique_ptr<interpreter::Value>> prototypes;
+    };
+
+    // A compiled expression, the native callables are only set when the static type is int, float or bool
+    // so that typed operators never box their operands
+    class Expression {
+    public:
+        // "auto" if it is only known at runtime, empty if nothing is stored for it
+        std::string type;
+        std::function<interpreter::Value(Context&)> value;
+        std::function<int(Context&)> asInt;
+        std::function<float(Context&)> asFloat;
+        std::function<bool(Context&)> asBool;
+    };
+
+    // A compiled statement, returns true once a return statement ran
+    typedef std::function<bool(Context&)> Statement;
+    // Points at the variable an identifier refers to
+    typedef std::function<interpreter::Value*(Context&)> Reference;
+
+    class Function {
+    public:
+        Function(std::string identifier, int parameters) :
+                identifier(std::move(identifier)),
+                parameters(parameters),
+                frame(parameters)
+        {};
+
+        std::string identifier;
+        int parameters;
+        // slots of the parameters and locals
+        int frame;
+        Statement body;
+    };
+
+    // Immutable once compiled, the records of a run point to its structs so it is never copied
+    class Program {
+    public:
+        Program() :
+                globals(0),
+                main("main", 0)
+        {};
+        Program(const Program&) = delete;
+        Program& operator=(const Program&) = delete;
+
+        // Run the top level statements with a fresh context, capacity is the number of slots for the frames of the calls
+        // Throws std::runtime_error once the calls nest deeper than the slots or the native stack allow
+        void run(std::size_t capacity = 1 << 20) const;
+
+        // functions keep their address while the program is compiled
+        std::deque<Function> functions;
+        // The layout of each struct and the function that initialises the fields of its prototype
+        std::deque<interpreter::Struct> structs;
+        std::vector<Function*> constructors;
+        // Python equivalent of:
+        // methods = {functionDeclarationNode: function}
+        std::map<parser::ASTFunctionDeclarationNode*, Function*> methods;
+        int globals;
+        // the top level statements, a return only ends its own statement
+        Function main;
+    };
+}
+
+namespace visitor {
+    class ClosureCompiler : public Visitor {
+    public:
+        ClosureCompiler();
+        ~ClosureCompiler() = default;
+
+        closure::Program program;
+
+        void visit(parser::ASTProgramNode* programNode) override;
+
+        void visit(parser::ASTLiteralNode<int>* literalNode) override;
+        void visit(parser::ASTLiteralNode<float>* literalNode) override;
+        void visit(parser::ASTLiteralNode<bool>* literalNode) override;
+        void visit(parser::ASTLiteralNode<char>* literalNode) override;
+        void visit(parser::ASTLiteralNode<std::string>* literalNode) override;
+        void visit(parser::ASTArrayLiteralNode* arrayLiteralNode) override;
+        void visit(parser::ASTBinaryNode* binaryNode) override;
+        void visit(parser::ASTIdentifierNode* identifierNode) override;
+        void visit(parser::ASTUnaryNode* unaryNode) override;
+        void visit(parser::ASTSpawnNode* spawnNode) override;
+        void visit(parser::ASTAwaitNode* awaitNode) override;
+        void visit(parser::ASTFunctionCallNode* functionCallNode) override;
+
+        void visit(parser::ASTSFunctionCallNode* sFunctionCallNode) override;
+        void visit(parser::ASTDeclarationNode* declarationNode) override;
+        void visit(parser::ASTAssignmentNode* assignmentNode) override;
+        void visit(parser::ASTPrintNode* printNode) override;
+        void visit(parser::ASTBlockNode* blockNode) override;
+        void visit(parser::ASTIfNode* ifNode) override;
+        void visit(parser::ASTForNode* forNode) override;
+        void visit(parser::ASTWhileNode* whileNode) override;
+        void visit(parser::ASTFunctionDeclarationNode* functionDeclarationNode) override;
+        void visit(parser::ASTReturnNode* returnNode) override;
+        void visit(parser::ASTStructNode* structNode) override;
+
+    private:
+        // The closure of the last compiled expression or statement
+        closure::Expression expression;
+        closure::Statement statement;
+
+        // Python equivalent of:
+        // globals = {identifier: Symbol}
+        std::map<std::string, compiler::Symbol> globals;
+        // The block scopes of the function being compiled, innermost last
+        std::vector<std::map<std::string, compiler::Symbol>> scopes;
+        // next free slot and slots used by the function being compiled
+        int next;
+        int frame;
+        // the function being compiled, null for the top level statements and constructors
+        parser::ASTFunctionDeclarationNode* function;
+        // the struct whose method or constructor is being compiled, null otherwise
+        interpreter::Struct* structure;
+
+        // Python equivalent of:
+        // structs = {identifier: index into program.structs}
+        std::map<std::string, int> structs;
+        // functions = {functionDeclarationNode: function}
+        std::map<parser::ASTFunctionDeclarationNode*, closure::Function*> functions;
+        // types = {functionDeclarationNode: return type}, auto functions get the type of their first return
+        std::map<parser::ASTFunctionDeclarationNode*, std::string> types;
+
+        // Allocate a variable in the innermost scope (the globals for top level declarations)
+        compiler::Symbol declare(const std::string& identifier, const std::string& type, bool nothing);
+        compiler::Symbol lookup(const std::string& identifier);
+        // The variable an identifier refers to up to (not including) last, type is set to its type
+        // empty if nothing is stored for it
+        closure::Reference reference(parser::ASTIdentifierNode* identifierNode, parser::ASTIdentifierNode* last, std::string& type);
+        // A new instance of struct index
+        closure::Expression instance(int index);
+        // Store the value of expression into the variable of symbol
+        closure::Statement store(const compiler::Symbol& symbol, const closure::Expression& value);
+
+        void compile(parser::ASTFunctionDeclarationNode* functionDeclarationNode, interpreter::Struct* owner);
+        void construct(int index);
+        void call(const std::shared_ptr<parser::ASTIdentifierNode>& identifier, const std::vector<std::shared_ptr<parser::ASTExprNode>>& parameters,
+                  parser::ASTFunctionDeclarationNode* callee, unsigned int lineNumber);
+    };
+}
+
+#endif //TEALANG_COMPILER_CPP20_CLOSURE_VISITOR_H
@@ -0,0 +1,653 @@
+//
+// Lowers a checked program into bytecode for vm::VM.
+//
+
+#include "Compiler_Visitor.h"
+#include <cstring>
+
+namespace visitor {
+    Compiler::Compiler() {
+        currentType = std::string();
+        next = 0;
+        frame = 0;
+        depth = 0;
+        peak = 0;
+        function = nullptr;
+        structure = nullptr;
+    }
+
+    std::size_t Compiler::emit(bytecode::OPCODE op, int a, int b) {
+        // effect of the instruction on the operand stack
+        switch (op) {
+            case bytecode::PUSH_INT: case bytecode::PUSH_FLOAT: case bytecode::PUSH_BOOL: case bytecode::PUSH_CHAR:
+            case bytecode::PUSH_CONSTANT: case bytecode::LOAD_LOCAL: case bytecode::LOAD_GLOBAL: case bytecode::LOAD_MEMBER:
+            case bytecode::LOAD_SELF: case bytecode::LOAD_REF: case bytecode::INSTANCE:
+                ++depth;
+                break;
+            case bytecode::POP: case bytecode::STORE_LOCAL: case bytecode::STORE_GLOBAL: case bytecode::STORE_MEMBER:
+            case bytecode::STORE_REF: case bytecode::PUSH_ELEMENT: case bytecode::JUMP_IF_FALSE: case bytecode::RETURN:
+            case bytecode::PRINT:
+            case bytecode::ADD_INT: case bytecode::SUB_INT: case bytecode::MUL_INT: case bytecode::DIV_INT:
+            case bytecode::LT_INT: case bytecode::GT_INT: case bytecode::LE_INT: case bytecode::GE_INT:
+            case bytecode::EQ_INT: case bytecode::NE_INT:
+            case bytecode::ADD_FLOAT: case bytecode::SUB_FLOAT: case bytecode::MUL_FLOAT: case bytecode::DIV_FLOAT:
+            case bytecode::LT_FLOAT: case bytecode::GT_FLOAT: case bytecode::LE_FLOAT: case bytecode::GE_FLOAT:
+            case bytecode::EQ_FLOAT: case bytecode::NE_FLOAT:
+            case bytecode::AND: case bytecode::OR: case bytecode::CONCAT: case bytecode::APPLY:
+                --depth;
+                break;
+            case bytecode::STORE_ELEMENT:
+                depth -= 2;
+                break;
+            case bytecode::CALL: case bytecode::CALL_METHOD: case bytecode::CALL_NAMED:
+                // the arguments are replaced by the result
+                depth += 1 - b;
+                break;
+            default:
+                break;
+        }
+        peak = std::max(peak, depth);
+        program.code.emplace_back(op, a, b);
+        return program.code.size() - 1;
+    }
+
+    void Compiler::patch(std::size_t at) {
+        program.code.at(at).a = (int) program.code.size();
+    }
+
+    int Compiler::constant(const interpreter::Value &value) {
+        program.constants.emplace_back(value);
+        return (int) program.constants.size() - 1;
+    }
+
+    compiler::Symbol Compiler::declare(const std::string &identifier, const std::string &type, bool nothing) {
+        if(scopes.empty()){
+            // a top level declaration, its slot was given to it before any code was compiled
+            auto& symbol = globals.at(identifier);
+            symbol.type = type;
+            if(nothing) symbol.kind = compiler::Symbol::NOTHING;
+            return symbol;
+        }
+        compiler::Symbol symbol(nothing ? compiler::Symbol::NOTHING : compiler::Symbol::LOCAL, next++, type);
+        frame = std::max(frame, next);
+        scopes.back().insert_or_assign(identifier, symbol);
+        return symbol;
+    }
+
+    compiler::Symbol Compiler::lookup(const std::string &identifier) {
+        // the innermost declaration, then the members of the instance, then the globals
+        for(auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope){
+            auto result = scope->find(identifier);
+            if(result != scope->end())
+                return result->second;
+        }
+        if(structure != nullptr){
+            auto offset = structure->offsets.find(identifier);
+            if(offset != structure->offsets.end()){
+                auto declarationNode = structure->fields.at(offset->second);
+                // nothing is stored for arrays of structs
+                bool nothing = declarationNode->identifier->ilocExprNode != nullptr && lexer::isStruct(declarationNode->type);
+                return {nothing ? compiler::Symbol::NOTHING : compiler::Symbol::MEMBER, (int) offset->second, declarationNode->type};
+            }
+            if(identifier == "self")
+                return {compiler::Symbol::SELF, 0, structure->id};
+        }
+        auto result = globals.find(identifier);
+        if(result != globals.end())
+            return result->second;
+        // Should never get here because of the semantic pass
+        throw std::runtime_error("Variable with identifier " + identifier + " has not been declared.");
+    }
+
+    std::string Compiler::reference(parser::ASTIdentifierNode *identifierNode, parser::ASTIdentifierNode *last) {
+        auto symbol = lookup(identifierNode->identifier);
+        switch (symbol.kind) {
+            case compiler::Symbol::LOCAL:
+                emit(bytecode::REF_LOCAL, symbol.slot);
+                break;
+            case compiler::Symbol::GLOBAL:
+                emit(bytecode::REF_GLOBAL, symbol.slot);
+                break;
+            case compiler::Symbol::MEMBER:
+                emit(bytecode::REF_MEMBER, symbol.slot);
+                break;
+            case compiler::Symbol::SELF:
+                emit(bytecode::REF_SELF);
+                break;
+            case compiler::Symbol::NOTHING:
+                return "";
+        }
+        std::string type = symbol.type;
+        bool element = identifierNode->ilocExprNode != nullptr;
+        // The members are at a fixed offset in the fields of the instance
+        for(auto child = identifierNode->getChild(); child != nullptr && !child->isEmpty() && child.get() != last; child = child->getChild()){
+            // nothing is stored for arrays of structs
+            if(element)
+                return "";
+            auto s = structs.find(type);
+            if(s == structs.end()){
+                // the struct is only known at runtime
+                emit(bytecode::REF_NAMED, constant(child->identifier));
+                type = "auto";
+            }else{
+                auto& layout = program.structs.at(s->second);
+                auto declarationNode = layout.fields.at(layout.offsets.at(child->identifier));
+                if(declarationNode->identifier->ilocExprNode != nullptr && lexer::isStruct(declarationNode->type))
+                    return "";
+                emit(bytecode::REF_FIELD, (int) layout.offsets.at(child->identifier));
+                type = declarationNode->type;
+            }
+            element = child->ilocExprNode != nullptr;
+        }
+        return type;
+    }
+
+    parser::ASTIdentifierNode *Compiler::indexed(parser::ASTIdentifierNode *identifierNode) {
+        auto last = identifierNode;
+        while(last->getChild() != nullptr && !last->getChild()->isEmpty())
+            last = last->getChild().get();
+        return last->ilocExprNode != nullptr ? last : nullptr;
+    }
+
+    void Compiler::begin(int index) {
+        program.functions.at(index).entry = program.code.size();
+        next = frame = program.functions.at(index).parameters;
+        depth = 0;
+        peak = 0;
+    }
+
+    void Compiler::end(int index) {
+        program.functions.at(index).frame = frame;
+        program.functions.at(index).stack = peak;
+    }
+
+    void Compiler::visit(parser::ASTProgramNode *programNode) {
+        // The layouts, every function and every global get their index before any code is compiled
+        // so that the functions can use the globals declared after them
+        for(auto &statement : programNode->statements){
+            if(auto structNode = dynamic_cast<parser::ASTStructNode*>(statement.get())){
+                structs.insert(std::make_pair(structNode->identifier->getID(), (int) program.structs.size()));
+                program.structs.emplace_back(structNode);
+                program.constructors.emplace_back((int) program.functions.size());
+                program.functions.emplace_back(structNode->identifier->getID(), 0);
+                for(const auto& method : program.structs.back().methods){
+                    functions.insert(std::make_pair(method.second, (int) program.functions.size()));
+                    program.methods.insert(std::make_pair(method.second, (int) program.functions.size()));
+                    program.functions.emplace_back(method.first.first, (int) method.second->parameters.size());
+                }
+            }else if(auto functionDeclarationNode = dynamic_cast<parser::ASTFunctionDeclarationNode*>(statement.get())){
+                functions.insert(std::make_pair(functionDeclarationNode, (int) program.functions.size()));
+                program.functions.emplace_back(functionDeclarationNode->identifier->getID(), (int) functionDeclarationNode->parameters.size());
+            }else if(auto declarationNode = dynamic_cast<parser::ASTDeclarationNode*>(statement.get())){
+                bool nothing = declarationNode->identifier->ilocExprNode != nullptr && lexer::isStruct(declarationNode->type);
+                globals.insert(std::make_pair(declarationNode->identifier->getID(),
+                                              compiler::Symbol(nothing ? compiler::Symbol::NOTHING : compiler::Symbol::GLOBAL, program.globals++, declarationNode->type)));
+            }
+        }
+        program.main = (int) program.functions.size();
+        program.functions.emplace_back("main", 0);
+
+        // The constructors and methods of each struct then the functions, in program order
+        for(auto &statement : programNode->statements){
+            if(auto structNode = dynamic_cast<parser::ASTStructNode*>(statement.get())){
+                int index = structs.at(structNode->identifier->getID());
+                construct(index);
+                for(const auto& method : program.structs.at(index).methods)
+                    compile(method.second, &program.structs.at(index));
+            }else if(auto functionDeclarationNode = dynamic_cast<parser::ASTFunctionDeclarationNode*>(statement.get())){
+                compile(functionDeclarationNode, nullptr);
+            }
+        }
+
+        // The top level statements
+        begin(program.main);
+        for(auto &statement : programNode->statements){
+            statement->accept(this);
+            // a return outside of a function only ends its own statement
+            for(auto exit : exits)
+                patch(exit);
+            exits.clear();
+        }
+        emit(bytecode::HALT);
+        end(program.main);
+    }
+
+    void Compiler::compile(parser::ASTFunctionDeclarationNode *functionDeclarationNode, interpreter::Struct *owner) {
+        int index = functions.at(functionDeclarationNode);
+        begin(index);
+        function = functionDeclarationNode;
+        structure = owner;
+        // the parameters are the first slots of the frame
+        scopes.emplace_back();
+        for(int i = 0; i < functionDeclarationNode->parameters.size(); ++i){
+            const auto& parameter = functionDeclarationNode->parameters.at(i);
+            scopes.back().insert_or_assign(parameter.first, compiler::Symbol(compiler::Symbol::LOCAL, i, parameter.second));
+        }
+        functionDeclarationNode->functionBlock->accept(this);
+        // only reached when every return is inside a branch
+        emit(bytecode::PUSH_INT, 0);
+        emit(bytecode::RETURN);
+        scopes.clear();
+        function = nullptr;
+        structure = nullptr;
+        end(index);
+    }
+
+    void Compiler::construct(int index) {
+        auto& layout = program.structs.at(index);
+        begin(program.constructors.at(index));
+        structure = &layout;
+        // The initial values of the fields in declaration order, they can refer to the fields declared before them
+        for(int i = 0; i < layout.fields.size(); ++i){
+            auto declarationNode = layout.fields.at(i);
+            if(declarationNode->exprNode != nullptr){
+                currentType = declarationNode->type;
+                declarationNode->exprNode->accept(this);
+                emit(currentType.empty() ? bytecode::POP : bytecode::STORE_MEMBER, i);
+            }else if(declarationNode->identifier->ilocExprNode != nullptr){
+                declarationNode->identifier->ilocExprNode->accept(this);
+                // nothing is stored for arrays of structs
+                if(lexer::isStruct(declarationNode->type)){
+                    emit(bytecode::POP);
+                }else{
+                    emit(bytecode::NEW_ARRAY, constant(declarationNode->type));
+                    emit(bytecode::STORE_MEMBER, i);
+                }
+            }else if(declarationNode->type != layout.id){
+                int s = structs.at(declarationNode->type);
+                emit(bytecode::BUILD, s);
+                emit(bytecode::INSTANCE, s);
+                emit(bytecode::STORE_MEMBER, i);
+            }
+        }
+        emit(bytecode::LEAVE);
+        structure = nullptr;
+        end(program.constructors.at(index));
+    }
+
+    // Expressions
+    // Every expression pushes exactly one value
+    void Compiler::visit(parser::ASTLiteralNode<int> *literalNode) {
+        emit(bytecode::PUSH_INT, literalNode->val);
+        currentType = "int";
+    }
+
+    void Compiler::visit(parser::ASTLiteralNode<float> *literalNode) {
+        int bits;
+        std::memcpy(&bits, &literalNode->val, sizeof(bits));
+        emit(bytecode::PUSH_FLOAT, bits);
+        currentType = "float";
+    }
+
+    void Compiler::visit(parser::ASTLiteralNode<bool> *literalNode) {
+        emit(bytecode::PUSH_BOOL, literalNode->val);
+        currentType = "bool";
+    }
+
+    void Compiler::visit(parser::ASTLiteralNode<char> *literalNode) {
+        emit(bytecode::PUSH_CHAR, literalNode->val);
+        currentType = "char";
+    }
+
+    void Compiler::visit(parser::ASTLiteralNode<std::string> *literalNode) {
+        emit(bytecode::PUSH_CONSTANT, constant(literalNode->val));
+        currentType = "string";
+    }
+
+    void Compiler::visit(parser::ASTArrayLiteralNode *arrayLiteralNode) {
+        // the current type is the declared type of the elements
+        std::string type = currentType;
+        if(lexer::isStruct(type)){
+            // nothing is stored for arrays of structs, the elements are not evaluated
+            emit(bytecode::PUSH_INT, 0);
+            currentType = "";
+            return;
+        }
+        emit(bytecode::PUSH_INT, 0);
+        emit(bytecode::NEW_ARRAY, constant(type));
+        for(const auto& item : arrayLiteralNode->expressions){
+            item->accept(this);
+            emit(bytecode::PUSH_ELEMENT);
+        }
+        currentType = type;
+    }
+
+    void Compiler::visit(parser::ASTBinaryNode *binaryNode) {
+        binaryNode->left->accept(this);
+        std::string left = currentType;
+        binaryNode->right->accept(this);
+        std::string right = currentType;
+
+        auto op = lexer::determineOperatorType(binaryNode->op);
+        bool comparison = op == lexer::TOK_LESS_THAN || op == lexer::TOK_MORE_THAN || op == lexer::TOK_LESS_THAN_EQUAL_TO
+                          || op == lexer::TOK_MORE_THAN_EQUAL_TO || op == lexer::TOK_EQAUL_TO || op == lexer::TOK_NOT_EQAUL_TO;
+        bool logical = op == lexer::TOK_AND || op == lexer::TOK_OR;
+        // The operator is picked here when both types are known, otherwise the values are checked at runtime
+        int typed = -1;
+        if(left == right && (left == "int" || left == "float")){
+            int offset = left == "int" ? 0 : bytecode::ADD_FLOAT - bytecode::ADD_INT;
+            switch (op) {
+                case lexer::TOK_PLUS: typed = bytecode::ADD_INT + offset; break;
+                case lexer::TOK_MINUS: typed = bytecode::SUB_INT + offset; break;
+                case lexer::TOK_ASTERISK: typed = bytecode::MUL_INT + offset; break;
+                case lexer::TOK_DIVIDE: typed = bytecode::DIV_INT + offset; break;
+                case lexer::TOK_LESS_THAN: typed = bytecode::LT_INT + offset; break;
+                case lexer::TOK_MORE_THAN: typed = bytecode::GT_INT + offset; break;
+                case lexer::TOK_LESS_THAN_EQUAL_TO: typed = bytecode::LE_INT + offset; break;
+                case lexer::TOK_MORE_THAN_EQUAL_TO: typed = bytecode::GE_INT + offset; break;
+                case lexer::TOK_EQAUL_TO: typed = bytecode::EQ_INT + offset; break;
+                case lexer::TOK_NOT_EQAUL_TO: typed = bytecode::NE_INT + offset; break;
+                default: break;
+            }
+        }else if(left == right && left == "bool" && logical){
+            typed = op == lexer::TOK_AND ? bytecode::AND : bytecode::OR;
+        }else if(left == right && left == "string" && op == lexer::TOK_PLUS){
+            typed = bytecode::CONCAT;
+        }
+        if(typed >= 0)
+            emit((bytecode::OPCODE) typed);
+        else
+            emit(bytecode::APPLY, binaryNode->kind, (int) binaryNode->lineNumber);
+
+        if(comparison || logical)
+            currentType = "bool";
+        else
+            currentType = left == right ? left : "auto";
+    }
+
+    void Compiler::visit(parser::ASTIdentifierNode *identifierNode) {
+        if((identifierNode->getChild() == nullptr || identifierNode->getChild()->isEmpty()) && identifierNode->ilocExprNode == nullptr){
+            // A plain variable is read straight from its slot
+            auto symbol = lookup(identifierNode->identifier);
+            switch (symbol.kind) {
+                case compiler::Symbol::LOCAL:
+                    emit(bytecode::LOAD_LOCAL, symbol.slot);
+                    break;
+                case compiler::Symbol::GLOBAL:
+                    emit(bytecode::LOAD_GLOBAL, symbol.slot);
+                    break;
+                case compiler::Symbol::MEMBER:
+                    emit(bytecode::LOAD_MEMBER, symbol.slot);
+                    break;
+                case compiler::Symbol::SELF:
+                    emit(bytecode::LOAD_SELF);
+                    break;
+                case compiler::Symbol::NOTHING:
+                    emit(bytecode::PUSH_INT, 0);
+                    currentType = "";
+                    return;
+            }
+            currentType = symbol.type;
+            return;
+        }
+        // the index is evaluated before the reference is taken
+        auto element = indexed(identifierNode);
+        if(element != nullptr)
+            element->ilocExprNode->accept(this);
+        auto type = reference(identifierNode, nullptr);
+        if(type.empty()){
+            // nothing is stored for arrays of structs
+            if(element != nullptr)
+                emit(bytecode::POP);
+            emit(bytecode::PUSH_INT, 0);
+            currentType = "";
+            return;
+        }
+        emit(element != nullptr ? bytecode::LOAD_ELEMENT : bytecode::LOAD_REF);
+        currentType = type;
+    }
+
+    void Compiler::visit(parser::ASTUnaryNode *unaryNode) {
+        unaryNode->exprNode->accept(this);
+        if(currentType == "int")
+            emit(bytecode::NEG_INT);
+        else if(currentType == "float")
+            emit(bytecode::NEG_FLOAT);
+        else if(currentType == "bool")
+            emit(bytecode::NOT);
+        else
+            emit(bytecode::NEGATE, unaryNode->kind, (int) unaryNode->lineNumber);
+    }
+
+    // Tasks need the interpreter's scheduler, the VM has no instructions for them
+    void Compiler::visit(parser::ASTSpawnNode *spawnNode) {
+        throw std::runtime_error("spawn on line " + std::to_string(spawnNode->lineNumber) + " is only supported by the interpreter.");
+    }
+
+    void Compiler::visit(parser::ASTAwaitNode *awaitNode) {
+        throw std::runtime_error("await on line " + std::to_string(awaitNode->lineNumber) + " is only supported by the interpreter.");
+    }
+
+    void Compiler::visit(parser::ASTFunctionCallNode *functionCallNode) {
+        call(functionCallNode->identifier, functionCallNode->parameters, functionCallNode->callee, functionCallNode->lineNumber);
+    }
+    // Expressions
+
+    // Statements
+    void Compiler::visit(parser::ASTSFunctionCallNode *sFunctionCallNode) {
+        call(sFunctionCallNode->identifier, sFunctionCallNode->parameters, sFunctionCallNode->callee, sFunctionCallNode->lineNumber);
+        // the result is not used
+        emit(bytecode::POP);
+    }
+
+    void Compiler::call(const std::shared_ptr<parser::ASTIdentifierNode>& identifier, const std::vector<std::shared_ptr<parser::ASTExprNode>>& parameters,
+                        parser::ASTFunctionDeclarationNode* callee, unsigned int lineNumber) {
+        // The arguments become the first slots of the frame of the callee
+        std::vector<std::string> paramTypes;
+        for(const auto& param : parameters){
+            param->accept(this);
+            paramTypes.emplace_back(currentType);
+        }
+        int arguments = (int) parameters.size();
+        // the type of the result, auto functions have the type of their first return
+        auto result = [this](parser::ASTFunctionDeclarationNode* declaration){
+            if(declaration->type != "auto")
+                return declaration->type;
+            auto type = types.find(declaration);
+            return type != types.end() ? type->second : std::string("auto");
+        };
+        if(callee != nullptr){
+            emit(bytecode::CALL, functions.at(callee), arguments);
+            currentType = result(callee);
+            return;
+        }
+
+        // A method, the instance it runs on is the identifier up to its last child (self for bare calls)
+        auto name = identifier.get();
+        while(name->getChild() != nullptr && !name->getChild()->isEmpty())
+            name = name->getChild().get();
+        interpreter::Struct* layout = nullptr;
+        if(name != identifier.get()){
+            auto s = structs.find(reference(identifier.get(), name));
+            if(s != structs.end())
+                layout = &program.structs.at(s->second);
+        }else if(structure != nullptr && std::any_of(structure->methods.begin(), structure->methods.end(),
+                                                     [name](const auto& method){ return method.first.first == name->identifier; })){
+            emit(bytecode::REF_SELF);
+            layout = structure;
+        }else{
+            // a global function that was not resolved by the semantic pass
+            for(const auto& f : functions){
+                if(program.methods.count(f.first) != 0 || f.first->identifier->getID() != name->identifier || f.first->parameters.size() != arguments)
+                    continue;
+                bool matches = true;
+                for(int i = 0; i < arguments; ++i)
+                    matches = matches && (paramTypes.at(i) == "auto" || paramTypes.at(i) == f.first->parameters.at(i).second);
+                if(matches){
+                    emit(bytecode::CALL, f.second, arguments);
+                    currentType = result(f.first);
+                    return;
+                }
+            }
+            throw std::runtime_error("Function with identifier " + identifier->getID() + " called on line "
+                                     + std::to_string(lineNumber) + " has not been declared.");
+        }
+        if(layout != nullptr){
+            auto method = layout->methods.find(std::make_pair(name->identifier, paramTypes));
+            if(method != layout->methods.end()){
+                emit(bytecode::CALL_METHOD, functions.at(method->second), arguments);
+                currentType = result(method->second);
+                return;
+            }
+        }
+        // The method is looked up in the struct of the instance when it is called
+        emit(bytecode::CALL_NAMED, constant(name->identifier), arguments);
+        currentType = "auto";
+    }
+
+    void Compiler::visit(parser::ASTDeclarationNode *declarationNode) {
+        auto id = declarationNode->identifier->getID();
+        compiler::Symbol symbol(compiler::Symbol::NOTHING, 0, declarationNode->type);
+        if(declarationNode->exprNode != nullptr){
+            // by changing the current type we help to init an array literal
+            currentType = declarationNode->type;
+            declarationNode->exprNode->accept(this);
+            if(currentType.empty()){
+                // nothing is stored for arrays of structs
+                emit(bytecode::POP);
+                declare(id, declarationNode->type, true);
+                return;
+            }
+            symbol = declare(id, declarationNode->type == "auto" ? currentType : declarationNode->type, false);
+        }else if(declarationNode->identifier->ilocExprNode != nullptr){
+            // array declaration case
+            declarationNode->identifier->ilocExprNode->accept(this);
+            if(lexer::isStruct(declarationNode->type)){
+                emit(bytecode::POP);
+                declare(id, declarationNode->type, true);
+                return;
+            }
+            emit(bytecode::NEW_ARRAY, constant(declarationNode->type));
+            symbol = declare(id, declarationNode->type, false);
+        }else{
+            // struct case, a new instance with its fields initialised (see interpreter::Struct::constant)
+            int s = structs.at(declarationNode->type);
+            emit(bytecode::BUILD, s);
+            emit(bytecode::INSTANCE, s);
+            symbol = declare(id, declarationNode->type, false);
+        }
+        emit(symbol.kind == compiler::Symbol::GLOBAL ? bytecode::STORE_GLOBAL : bytecode::STORE_LOCAL, symbol.slot);
+    }
+
+    void Compiler::visit(parser::ASTAssignmentNode *assignmentNode) {
+        assignmentNode->exprNode->accept(this);
+        // nothing is stored for arrays of structs
+        if(currentType.empty()){
+            emit(bytecode::POP);
+            return;
+        }
+        auto identifierNode = assignmentNode->identifier.get();
+        if((identifierNode->getChild() == nullptr || identifierNode->getChild()->isEmpty()) && identifierNode->ilocExprNode == nullptr){
+            auto symbol = lookup(identifierNode->identifier);
+            switch (symbol.kind) {
+                case compiler::Symbol::LOCAL:
+                    emit(bytecode::STORE_LOCAL, symbol.slot);
+                    break;
+                case compiler::Symbol::GLOBAL:
+                    emit(bytecode::STORE_GLOBAL, symbol.slot);
+                    break;
+                case compiler::Symbol::MEMBER:
+                    emit(bytecode::STORE_MEMBER, symbol.slot);
+                    break;
+                case compiler::Symbol::SELF:
+                    emit(bytecode::REF_SELF);
+                    emit(bytecode::STORE_REF);
+                    break;
+                case compiler::Symbol::NOTHING:
+                    emit(bytecode::POP);
+                    break;
+            }
+            return;
+        }
+        // The target is referenced once the value is on the stack
+        auto element = indexed(identifierNode);
+        if(element != nullptr)
+            element->ilocExprNode->accept(this);
+        if(reference(identifierNode, nullptr).empty()){
+            if(element != nullptr)
+                emit(bytecode::POP);
+            emit(bytecode::POP);
+            return;
+        }
+        emit(element != nullptr ? bytecode::STORE_ELEMENT : bytecode::STORE_REF);
+    }
+
+    void Compiler::visit(parser::ASTPrintNode *printNode) {
+        printNode->exprNode->accept(this);
+        // nothing is printed for struct values
+        emit(lexer::isStruct(currentType) ? bytecode::POP : bytecode::PRINT);
+    }
+
+    void Compiler::visit(parser::ASTBlockNode *blockNode) {
+        // the slots of the block's declarations are reused once it is over
+        scopes.emplace_back();
+        int _next = next;
+        for(auto &statement : blockNode->statements)
+            statement->accept(this);
+        next = _next;
+        scopes.pop_back();
+    }
+
+    void Compiler::visit(parser::ASTIfNode *ifNode) {
+        ifNode->condition->accept(this);
+        auto otherwise = emit(bytecode::JUMP_IF_FALSE);
+        ifNode->ifBlock->accept(this);
+        if(ifNode->elseBlock != nullptr){
+            auto over = emit(bytecode::JUMP);
+            patch(otherwise);
+            ifNode->elseBlock->accept(this);
+            patch(over);
+        }else{
+            patch(otherwise);
+        }
+    }
+
+    void Compiler::visit(parser::ASTForNode *forNode) {
+        // the loop variable only lives as long as the loop
+        scopes.emplace_back();
+        int _next = next;
+        if(forNode->declaration != nullptr)
+            forNode->declaration->accept(this);
+        auto condition = program.code.size();
+        forNode->condition->accept(this);
+        auto exit = emit(bytecode::JUMP_IF_FALSE);
+        forNode->loopBlock->accept(this);
+        if(forNode->assignment != nullptr)
+            forNode->assignment->accept(this);
+        emit(bytecode::JUMP, (int) condition);
+        patch(exit);
+        next = _next;
+        scopes.pop_back();
+    }
+
+    void Compiler::visit(parser::ASTWhileNode *whileNode) {
+        auto condition = program.code.size();
+        whileNode->condition->accept(this);
+        auto exit = emit(bytecode::JUMP_IF_FALSE);
+        whileNode->loopBlock->accept(this);
+        emit(bytecode::JUMP, (int) condition);
+        patch(exit);
+    }
+
+    void Compiler::visit(parser::ASTFunctionDeclarationNode *functionDeclarationNode) {
+        // compiled on its own before the top level statements
+    }
+
+    void Compiler::visit(parser::ASTReturnNode *returnNode) {
+        returnNode->exprNode->accept(this);
+        if(function == nullptr){
+            // a return outside of a function only ends its own statement
+            emit(bytecode::POP);
+            exits.emplace_back(emit(bytecode::JUMP));
+            return;
+        }
+        if(function->type == "auto" && !currentType.empty())
+            types.insert(std::make_pair(function, currentType));
+        emit(bytecode::RETURN);
+    }
+
+    void Compiler::visit(parser::ASTStructNode *structNode) {
+        // the layout was built before any code was compiled
+    }
+    // Statements
+}
@@ -0,0 +1,127 @@
+//
+// Lowers a checked program into bytecode for vm::VM.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_COMPILER_VISITOR_H
+#define TEALANG_COMPILER_CPP20_COMPILER_VISITOR_H
+
+#include "Visitor.h"
+#include "../VM/Bytecode.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace compiler {
+    // Where a variable lives at runtime, resolved once while compiling
+    class Symbol {
+    public:
+        // NOTHING is an array of structs, nothing is stored for it (like the interpreter)
+        enum KIND {LOCAL, GLOBAL, MEMBER, SELF, NOTHING};
+
+        Symbol(KIND kind, int slot, std::string type) :
+                kind(kind),
+                slot(slot),
+                type(std::move(type))
+        {};
+
+        KIND kind;
+        int slot;
+        // "auto" when the type is only known at runtime
+        std::string type;
+    };
+}
+
+namespace visitor {
+    class Compiler : public Visitor {
+    public:
+        Compiler();
+        ~Compiler() = default;
+
+        bytecode::Program program;
+
+        void visit(parser::ASTProgramNode* programNode) override;
+
+        void visit(parser::ASTLiteralNode<int>* literalNode) override;
+        void visit(parser::ASTLiteralNode<float>* literalNode) override;
+        void visit(parser::ASTLiteralNode<bool>* literalNode) override;
+        void visit(parser::ASTLiteralNode<char>* literalNode) override;
+        void visit(parser::ASTLiteralNode<std::string>* literalNode) override;
+        void visit(parser::ASTArrayLiteralNode* arrayLiteralNode) override;
+        void visit(parser::ASTBinaryNode* binaryNode) override;
+        void visit(parser::ASTIdentifierNode* identifierNode) override;
+        void visit(parser::ASTUnaryNode* unaryNode) override;
+        void visit(parser::ASTSpawnNode* spawnNode) override;
+        void visit(parser::ASTAwaitNode* awaitNode) override;
+        void visit(parser::ASTFunctionCallNode* functionCallNode) override;
+
+        void visit(parser::ASTSFunctionCallNode* sFunctionCallNode) override;
+        void visit(parser::ASTDeclarationNode* declarationNode) override;
+        void visit(parser::ASTAssignmentNode* assignmentNode) override;
+        void visit(parser::ASTPrintNode* printNode) override;
+        void visit(parser::ASTBlockNode* blockNode) override;
+        void visit(parser::ASTIfNode* ifNode) override;
+        void visit(parser::ASTForNode* forNode) override;
+        void visit(parser::ASTWhileNode* whileNode) override;
+        void visit(parser::ASTFunctionDeclarationNode* functionDeclarationNode) override;
+        void visit(parser::ASTReturnNode* returnNode) override;
+        void visit(parser::ASTStructNode* structNode) override;
+
+    private:
+        // Static type of the last compiled expression, "auto" if it is only known at runtime
+        // and empty if nothing is stored for it
+        std::string currentType;
+
+        // Python equivalent of:
+        // globals = {identifier: Symbol}
+        std::map<std::string, compiler::Symbol> globals;
+        // The block scopes of the function being compiled, innermost last
+        std::vector<std::map<std::string, compiler::Symbol>> scopes;
+        // next free slot and slots used by the function being compiled
+        int next;
+        int frame;
+        // operand stack depth at the current instruction and the deepest it got in the function being compiled
+        int depth;
+        int peak;
+        // the function being compiled, null for the top level statements and constructors
+        parser::ASTFunctionDeclarationNode* function;
+        // the struct whose method or constructor is being compiled, null otherwise
+        interpreter::Struct* structure;
+        // returns outside of a function jump to the end of their top level statement
+        std::vector<std::size_t> exits;
+
+        // Python equivalent of:
+        // structs = {identifier: index into program.structs}
+        std::map<std::string, int> structs;
+        // functions = {functionDeclarationNode: index into program.functions}
+        std::map<parser::ASTFunctionDeclarationNode*, int> functions;
+        // types = {functionDeclarationNode: return type}, auto functions get the type of their first return
+        std::map<parser::ASTFunctionDeclarationNode*, std::string> types;
+
+        // Append an instruction and account for its effect on the operand stack
+        std::size_t emit(bytecode::OPCODE op, int a = 0, int b = 0);
+        // Point the jump at at the next instruction
+        void patch(std::size_t at);
+        int constant(const interpreter::Value& value);
+
+        // Allocate a variable in the innermost scope (the globals for top level declarations)
+        compiler::Symbol declare(const std::string& identifier, const std::string& type, bool nothing);
+        compiler::Symbol lookup(const std::string& identifier);
+        // Emit the references down to (not including) last, returns the type of the referenced value
+        // empty if nothing is stored for it
+        std::string reference(parser::ASTIdentifierNode* identifierNode, parser::ASTIdentifierNode* last);
+        // Does the identifier or its last child have an index
+        static parser::ASTIdentifierNode* indexed(parser::ASTIdentifierNode* identifierNode);
+
+        // Compile a function (a method when structure is set) into its entry of program.functions
+        void compile(parser::ASTFunctionDeclarationNode* functionDeclarationNode, interpreter::Struct* owner);
+        // Compile the field initialisers of a struct into its constructor
+        void construct(int index);
+        // Start and finish the code of the function at index
+        void begin(int index);
+        void end(int index);
+        void call(const std::shared_ptr<parser::ASTIdentifierNode>& identifier, const std::vector<std::shared_ptr<parser::ASTExprNode>>& parameters,
+                  parser::ASTFunctionDeclarationNode* callee, unsigned int lineNumber);
+    };
+}
+
+#endif //TEALANG_COMPILER_CPP20_COMPILER_VISITOR_H
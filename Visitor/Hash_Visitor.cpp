@@ -0,0 +1,200 @@
+//
+// Structural hash of a (sub) program, used to recognise unchanged declarations between runs.
+//
+
+#include "Hash_Visitor.h"
+
+namespace visitor {
+    // Tags that keep different node kinds with the same contents apart
+    enum NODE_TAG {
+        PROGRAM = 1, INT_LITERAL, FLOAT_LITERAL, BOOL_LITERAL, CHAR_LITERAL, STRING_LITERAL, ARRAY_LITERAL,
+        BINARY, IDENTIFIER, UNARY, FUNCTION_CALL, S_FUNCTION_CALL, DECLARATION, ASSIGNMENT, PRINT, BLOCK,
+        IF, FOR, WHILE, FUNCTION_DECLARATION, RETURN, STRUCT, EMPTY, SPAWN, AWAIT
+    };
+
+    std::uint64_t HashVisitor::hash(parser::ASTNode *node) {
+        value = OFFSET;
+        mix(node);
+        return value;
+    }
+
+    void HashVisitor::mix(std::uint64_t v) {
+        // Mix every byte of v
+        for(int i = 0; i < 8; ++i){
+            value ^= (v >> (i * 8)) & 0xFF;
+            value *= PRIME;
+        }
+    }
+
+    void HashVisitor::mix(const std::string &s) {
+        // the length keeps "ab" + "c" and "a" + "bc" apart
+        mix(s.size());
+        for(auto c : s){
+            value ^= (unsigned char) c;
+            value *= PRIME;
+        }
+    }
+
+    void HashVisitor::mix(parser::ASTNode *node) {
+        if(node == nullptr)
+            mix(EMPTY);
+        else
+            node->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTProgramNode *programNode) {
+        mix(PROGRAM);
+        mix(programNode->statements.size());
+        for(auto &statement : programNode->statements)
+            statement->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTLiteralNode<int> *literalNode) {
+        mix(INT_LITERAL);
+        mix((std::uint64_t) literalNode->val);
+    }
+
+    void HashVisitor::visit(parser::ASTLiteralNode<float> *literalNode) {
+        mix(FLOAT_LITERAL);
+        std::uint32_t bits;
+        std::memcpy(&bits, &literalNode->val, sizeof(bits));
+        mix(bits);
+    }
+
+    void HashVisitor::visit(parser::ASTLiteralNode<bool> *literalNode) {
+        mix(BOOL_LITERAL);
+        mix(literalNode->val ? 1 : 0);
+    }
+
+    void HashVisitor::visit(parser::ASTLiteralNode<char> *literalNode) {
+        mix(CHAR_LITERAL);
+        mix((std::uint64_t) literalNode->val);
+    }
+
+    void HashVisitor::visit(parser::ASTLiteralNode<std::string> *literalNode) {
+        mix(STRING_LITERAL);
+        mix(literalNode->val);
+    }
+
+    void HashVisitor::visit(parser::ASTArrayLiteralNode *arrayLiteralNode) {
+        mix(ARRAY_LITERAL);
+        mix(arrayLiteralNode->expressions.size());
+        for(auto &item : arrayLiteralNode->expressions)
+            item->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTBinaryNode *binaryNode) {
+        mix(BINARY);
+        mix(binaryNode->op);
+        binaryNode->left->accept(this);
+        binaryNode->right->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTIdentifierNode *identifierNode) {
+        mix(IDENTIFIER);
+        mix(identifierNode->identifier);
+        mix(identifierNode->ilocExprNode.get());
+        mix(identifierNode->getChild().get());
+    }
+
+    void HashVisitor::visit(parser::ASTUnaryNode *unaryNode) {
+        mix(UNARY);
+        mix(unaryNode->op);
+        unaryNode->exprNode->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTSpawnNode *spawnNode) {
+        mix(SPAWN);
+        spawnNode->call->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTAwaitNode *awaitNode) {
+        mix(AWAIT);
+        awaitNode->exprNode->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTFunctionCallNode *functionCallNode) {
+        mix(FUNCTION_CALL);
+        functionCallNode->identifier->accept(this);
+        mix(functionCallNode->parameters.size());
+        for(auto &param : functionCallNode->parameters)
+            param->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTSFunctionCallNode *sFunctionCallNode) {
+        mix(S_FUNCTION_CALL);
+        sFunctionCallNode->identifier->accept(this);
+        mix(sFunctionCallNode->parameters.size());
+        for(auto &param : sFunctionCallNode->parameters)
+            param->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTDeclarationNode *declarationNode) {
+        mix(DECLARATION);
+        mix(declarationNode->type);
+        declarationNode->identifier->accept(this);
+        mix(declarationNode->exprNode.get());
+    }
+
+    void HashVisitor::visit(parser::ASTAssignmentNode *assignmentNode) {
+        mix(ASSIGNMENT);
+        assignmentNode->identifier->accept(this);
+        assignmentNode->exprNode->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTPrintNode *printNode) {
+        mix(PRINT);
+        printNode->exprNode->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTBlockNode *blockNode) {
+        mix(BLOCK);
+        mix(blockNode->statements.size());
+        for(auto &statement : blockNode->statements)
+            statement->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTIfNode *ifNode) {
+        mix(IF);
+        ifNode->condition->accept(this);
+        ifNode->ifBlock->accept(this);
+        mix(ifNode->elseBlock.get());
+    }
+
+    void HashVisitor::visit(parser::ASTForNode *forNode) {
+        mix(FOR);
+        mix(forNode->declaration.get());
+        forNode->condition->accept(this);
+        mix(forNode->assignment.get());
+        forNode->loopBlock->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTWhileNode *whileNode) {
+        mix(WHILE);
+        whileNode->condition->accept(this);
+        whileNode->loopBlock->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTFunctionDeclarationNode *functionDeclarationNode) {
+        mix(FUNCTION_DECLARATION);
+        mix(functionDeclarationNode->type);
+        functionDeclarationNode->identifier->accept(this);
+        mix(functionDeclarationNode->parameters.size());
+        for(auto &parameter : functionDeclarationNode->parameters){
+            mix(parameter.first);
+            mix(parameter.second);
+        }
+        functionDeclarationNode->functionBlock->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTReturnNode *returnNode) {
+        mix(RETURN);
+        returnNode->exprNode->accept(this);
+    }
+
+    void HashVisitor::visit(parser::ASTStructNode *structNode) {
+        mix(STRUCT);
+        structNode->identifier->accept(this);
+        structNode->structBlock->accept(this);
+    }
+}
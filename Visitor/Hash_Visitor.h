@@ -0,0 +1,65 @@
+//
+// Structural hash of a (sub) program, used to recognise unchanged declarations between runs.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_HASH_VISITOR_H
+#define TEALANG_COMPILER_CPP20_HASH_VISITOR_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include "Visitor.h"
+#include "../Parser/AST.h"
+
+namespace visitor{
+
+    class HashVisitor : public Visitor {
+
+    public:
+        HashVisitor() : value(OFFSET) {};
+        ~HashVisitor() = default;
+
+        // Hash of the node and everything below it
+        // Line numbers are left out so that moving a declaration around does not change its hash
+        std::uint64_t hash(parser::ASTNode* node);
+
+        void visit(parser::ASTProgramNode* programNode) override;
+
+        void visit(parser::ASTLiteralNode<int>* literalNode) override;
+        void visit(parser::ASTLiteralNode<float>* literalNode) override;
+        void visit(parser::ASTLiteralNode<bool>* literalNode) override;
+        void visit(parser::ASTLiteralNode<char>* literalNode) override;
+        void visit(parser::ASTLiteralNode<std::string>* literalNode) override;
+        void visit(parser::ASTArrayLiteralNode* arrayLiteralNode) override;
+        void visit(parser::ASTBinaryNode* binaryNode) override;
+        void visit(parser::ASTIdentifierNode* identifierNode) override;
+        void visit(parser::ASTUnaryNode* unaryNode) override;
+        void visit(parser::ASTSpawnNode* spawnNode) override;
+        void visit(parser::ASTAwaitNode* awaitNode) override;
+        void visit(parser::ASTFunctionCallNode* functionCallNode) override;
+
+        void visit(parser::ASTSFunctionCallNode* sFunctionCallNode) override;
+        void visit(parser::ASTDeclarationNode* declarationNode) override;
+        void visit(parser::ASTAssignmentNode* assignmentNode) override;
+        void visit(parser::ASTPrintNode* printNode) override;
+        void visit(parser::ASTBlockNode* blockNode) override;
+        void visit(parser::ASTIfNode* ifNode) override;
+        void visit(parser::ASTForNode* forNode) override;
+        void visit(parser::ASTWhileNode* whileNode) override;
+        void visit(parser::ASTFunctionDeclarationNode* functionDeclarationNode) override;
+        void visit(parser::ASTReturnNode* returnNode) override;
+        void visit(parser::ASTStructNode* structNode) override;
+
+    private:
+        // FNV-1a
+        static constexpr std::uint64_t OFFSET = 14695981039346656037ULL;
+        static constexpr std::uint64_t PRIME = 1099511628211ULL;
+        std::uint64_t value;
+
+        void mix(std::uint64_t v);
+        void mix(const std::string& s);
+        // hashes an optional child, null children get their own marker
+        void mix(parser::ASTNode* node);
+    };
+}
+#endif //TEALANG_COMPILER_CPP20_HASH_VISITOR_H
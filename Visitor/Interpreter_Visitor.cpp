@@ -3,6 +3,268 @@
 //
 
 #include "Interpreter_Visitor.h"
+#include "../SIMD/SIMD.h"
+#include "../Concurrency/Task.h"
+#include <climits>
+#include <cmath>
+#include <exception>
+#include <iterator>
+#include <pthread.h>
+#include <sstream>
+
+namespace interpreter {
+    namespace {
+        // Is the expression made of literals only, evaluating it always gives the same value and does nothing else
+        bool literal(parser::ASTExprNode* exprNode) {
+            if(auto binaryNode = dynamic_cast<parser::ASTBinaryNode*>(exprNode))
+                return literal(binaryNode->left.get()) && literal(binaryNode->right.get());
+            if(auto unaryNode = dynamic_cast<parser::ASTUnaryNode*>(exprNode))
+                return literal(unaryNode->exprNode.get());
+            if(auto arrayLiteralNode = dynamic_cast<parser::ASTArrayLiteralNode*>(exprNode))
+                return std::all_of(arrayLiteralNode->expressions.begin(), arrayLiteralNode->expressions.end(),
+                                   [](const auto& element){ return literal(element.get()); });
+            return dynamic_cast<parser::ASTLiteralNode<int>*>(exprNode) != nullptr
+                   || dynamic_cast<parser::ASTLiteralNode<float>*>(exprNode) != nullptr
+                   || dynamic_cast<parser::ASTLiteralNode<bool>*>(exprNode) != nullptr
+                   || dynamic_cast<parser::ASTLiteralNode<char>*>(exprNode) != nullptr
+                   || dynamic_cast<parser::ASTLiteralNode<std::string>*>(exprNode) != nullptr;
+        }
+    }
+
+    Record::Record(const Struct* layout) :
+            layout(layout),
+            fields(layout -> fields.size())
+    {}
+
+    Struct::Struct(parser::ASTStructNode *structNode) :
+            id(structNode->identifier->getID()),
+            structNode(structNode->structBlock),
+            constant(true)
+    {
+        for(auto &statement : structNode->structBlock->statements){
+            if(auto declarationNode = dynamic_cast<parser::ASTDeclarationNode*>(statement.get())){
+                // self is the instance itself
+                if(declarationNode->identifier->getID() == "self") continue;
+                offsets.insert(std::make_pair(declarationNode->identifier->getID(), fields.size()));
+                fields.emplace_back(declarationNode);
+                // a field holding an instance of another struct is only as constant as that struct
+                if(declarationNode->exprNode != nullptr)
+                    constant = constant && literal(declarationNode->exprNode.get());
+                else if(declarationNode->identifier->ilocExprNode != nullptr)
+                    constant = constant && literal(declarationNode->identifier->ilocExprNode.get());
+                else if(lexer::isStruct(declarationNode->type) && declarationNode->type != id)
+                    constant = false;
+            }else if(auto functionDeclarationNode = dynamic_cast<parser::ASTFunctionDeclarationNode*>(statement.get())){
+                std::vector<std::string> paramTypes;
+                for (auto & parameter : functionDeclarationNode->parameters)
+                    paramTypes.emplace_back(parameter.second);
+                methods.insert(std::make_pair(std::make_pair(functionDeclarationNode->identifier->getID(), paramTypes), functionDeclarationNode));
+            }
+        }
+    }
+
+    std::string Value::type() const {
+        switch (tag()) {
+            case INT: case INT_ARRAY:
+                return "int";
+            case FLOAT: case FLOAT_ARRAY:
+                return "float";
+            case BOOL: case BOOL_ARRAY:
+                return "bool";
+            case CHAR: case CHAR_ARRAY:
+                return "char";
+            case STRING: case STRING_ARRAY:
+                return "string";
+            case RECORD:
+                return std::get<Record>(*this).layout -> id;
+            case HANDLE:
+                return std::get<Handle>(*this).type;
+        }
+        return "";
+    }
+
+    Value Value::at(int i) const {
+        switch (tag()) {
+            case INT_ARRAY:
+                return std::get<Array<int>>(*this).at(i);
+            case FLOAT_ARRAY:
+                return std::get<Array<float>>(*this).at(i);
+            case BOOL_ARRAY:
+                return std::get<Array<bool>>(*this).at(i);
+            case CHAR_ARRAY:
+                return std::get<Array<char>>(*this).at(i);
+            case STRING_ARRAY:
+                return std::get<Array<std::string>>(*this).at(i);
+            default:
+                throw std::runtime_error("Value of type " + type() + " is not an array.");
+        }
+    }
+
+    void Value::set(int i, const Value &element) {
+        switch (tag()) {
+            case INT_ARRAY:
+                std::get<Array<int>>(*this).write().at(i) = std::get<int>(element);
+                break;
+            case FLOAT_ARRAY:
+                std::get<Array<float>>(*this).write().at(i) = std::get<float>(element);
+                break;
+            case BOOL_ARRAY:
+                std::get<Array<bool>>(*this).write().at(i) = std::get<bool>(element);
+                break;
+            case CHAR_ARRAY:
+                std::get<Array<char>>(*this).write().at(i) = std::get<char>(element);
+                break;
+            case STRING_ARRAY:
+                std::get<Array<std::string>>(*this).write().at(i) = std::get<std::string>(element);
+                break;
+            default:
+                throw std::runtime_error("Value of type " + type() + " is not an array.");
+        }
+    }
+
+    void Value::push_back(const Value &element) {
+        switch (tag()) {
+            case INT_ARRAY:
+                std::get<Array<int>>(*this).write().emplace_back(std::get<int>(element));
+                break;
+            case FLOAT_ARRAY:
+                std::get<Array<float>>(*this).write().emplace_back(std::get<float>(element));
+                break;
+            case BOOL_ARRAY:
+                std::get<Array<bool>>(*this).write().emplace_back(std::get<bool>(element));
+                break;
+            case CHAR_ARRAY:
+                std::get<Array<char>>(*this).write().emplace_back(std::get<char>(element));
+                break;
+            case STRING_ARRAY:
+                std::get<Array<std::string>>(*this).write().emplace_back(std::get<std::string>(element));
+                break;
+            default:
+                throw std::runtime_error("Value of type " + type() + " is not an array.");
+        }
+    }
+
+    Value Value::array(const std::string &type, int size) {
+        if(type == "int") return Array<int>(size);
+        if(type == "float") return Array<float>(size);
+        if(type == "bool") return Array<bool>(size);
+        if(type == "char") return Array<char>(size);
+        if(type == "string") return Array<std::string>(size);
+        throw std::runtime_error("Arrays of type " + type + " hold no values.");
+    }
+
+    std::ostream& operator<<(std::ostream& os, const Value& value) {
+        switch (value.tag()) {
+            case Value::INT:
+                return os << std::get<int>(value);
+            case Value::FLOAT:
+                return os << std::get<float>(value);
+            case Value::BOOL:
+                return os << (std::get<bool>(value) ? "true" : "false");
+            case Value::CHAR:
+                return os << std::get<char>(value);
+            case Value::STRING:
+                return os << std::get<std::string>(value);
+            case Value::HANDLE:
+                return os << std::get<Handle>(value).type;
+            default:
+                break;
+        }
+        // arrays are printed as {a, b, c}
+        os << "{";
+        std::visit([&os](const auto& v){
+            if constexpr (!std::is_same_v<std::decay_t<decltype(v)>, std::string>
+                          && requires { v.size(); v.at(0); }) {
+                for(std::size_t i = 0; i < v.size(); ++i)
+                    os << (i == 0 ? "" : ", ") << Value(v.at(i));
+            }
+        }, (const ValueVariant&) value);
+        return os << "}";
+    }
+
+    void onStack(const std::function<void()>& f, std::size_t size) {
+        class Task {
+        public:
+            const std::function<void()>* f;
+            std::exception_ptr error;
+        } task{&f, nullptr};
+        auto start = [](void* argument) -> void* {
+            auto task = (Task*) argument;
+            try{
+                (*task -> f)();
+            }catch(...){
+                task -> error = std::current_exception();
+            }
+            return nullptr;
+        };
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+        pthread_t thread;
+        bool started = pthread_attr_setstacksize(&attributes, std::max<std::size_t>(size, PTHREAD_STACK_MIN)) == 0
+                       && pthread_create(&thread, &attributes, start, &task) == 0;
+        pthread_attr_destroy(&attributes);
+        if(!started){
+            // no thread for it, the stack of the caller has to do
+            f();
+            return;
+        }
+        pthread_join(thread, nullptr);
+        if(task.error)
+            std::rethrow_exception(task.error);
+    }
+
+    std::size_t available() {
+#if defined(__linux__)
+        // The lowest address the thread may use, found on its first call
+        // room is kept below it for the deepest call between two checks
+        static thread_local char* limit = [](){
+            pthread_attr_t attributes;
+            void* address = nullptr;
+            std::size_t size = 0;
+            if(pthread_getattr_np(pthread_self(), &attributes) == 0){
+                pthread_attr_getstack(&attributes, &address, &size);
+                pthread_attr_destroy(&attributes);
+            }
+            std::size_t reserve = std::min<std::size_t>(size / 4, 256 << 10);
+            return address != nullptr ? (char*) address + reserve : nullptr;
+        }();
+        auto top = (char*) __builtin_frame_address(0);
+        if(limit == nullptr)
+            return SIZE_MAX;
+        return top > limit ? top - limit : 0;
+#else
+        // only the number of calls is checked
+        return SIZE_MAX;
+#endif
+    }
+
+    void incorrect(lexer::OPERATOR op, const Value& operand, unsigned int lineNumber) {
+        throw std::runtime_error("Expression on line " + std::to_string(lineNumber)
+                                 + " has incorrect operator " + lexer::operatorSymbol(op)
+                                 + (op == lexer::OP_NEGATE ? " acting for expression of type " : " acting between expressions of type ")
+                                 + operand.type());
+    }
+}
+
+namespace interpreter {
+    // A spawned call, run by an interpreter of its own that prints into output
+    class Job {
+    public:
+        std::ostringstream output;
+        std::unique_ptr<visitor::Interpreter> interpreter;
+        // the result, destroyed first since it waits for the call to be over
+        concurrency::Task<Value> task;
+        // set by the first await, which writes output out
+        std::atomic<bool> flushed = false;
+    };
+
+    // Starts on the spawning thread and goes over to a worker of the pool straight away
+    static concurrency::Task<Value> perform(visitor::Interpreter* interpreter, parser::ASTFunctionDeclarationNode* callee,
+                                            std::vector<Value> arguments) {
+        co_await concurrency::schedule();
+        co_return interpreter -> invoke(callee, arguments.data(), arguments.size());
+    }
+}
 
 namespace visitor {
 
@@ -25,902 +287,458 @@ namespace visitor {
         return result != functionTable.end();
     }
 
+    void Interpreter::run(parser::ASTProgramNode *programNode, const std::map<std::string, interpreter::Value> &globals) {
+        // nested calls recurse through accept, the program runs on a stack with room for capacity of them
+        interpreter::onStack([this, programNode, &globals](){
+            // For each statement, accept
+            for(auto &statement : programNode -> statements){
+                auto declarationNode = dynamic_cast<parser::ASTDeclarationNode*>(statement.get());
+                auto global = declarationNode != nullptr ? globals.find(declarationNode -> identifier -> getID()) : globals.end();
+                if(global != globals.end()){
+                    // the given value is declared instead, its expression is not evaluated
+                    const auto& value = global -> second;
+                    bool isArray = declarationNode -> identifier -> ilocExprNode != nullptr;
+                    if(value.type() != declarationNode -> type || value.isArray() != isArray)
+                        throw std::runtime_error("Global " + global -> first + " declared on line " + std::to_string(declarationNode -> lineNumber)
+                                                 + " cannot be given a value of type " + value.type() + (value.isArray() ? "[]." : "."));
+                    variableTable.insert(interpreter::Variable<interpreter::Value>(declarationNode -> type, global -> first, isArray, value,
+                                                                                   declarationNode -> lineNumber));
+                    toPop.emplace_back(interpreter::Popable(declarationNode -> type, global -> first));
+                    continue;
+                }
+                statement -> accept(this);
+                // a return outside of a function only ends its own statement
+                returning = false;
+            }
+            settle();
+        }, capacity * frameBytes);
+    }
+
     void Interpreter::visit(parser::ASTProgramNode *programNode) {
-        // For each statement, accept
-        for(auto &statement : programNode -> statements)
-            statement -> accept(this);
+        run(programNode, {});
     }
 
     // Expressions
-    // Literal visits add a new literal variable to the 'literalTYPE' variable in the variableTable
+    // Every expression leaves its value in current, nothing is stored in the variableTable
     void Interpreter::visit(parser::ASTLiteralNode<int> *literalNode) {
-        interpreter::Variable<int> v("int", "0literal", false, literalNode -> val, literalNode -> lineNumber);
-        // remove previous literal
-        intTable.pop_back("0literal");
-        intTable.insert(v);
+        current = literalNode -> val;
         currentType = "int";
-        currentID = "0literal";
+        currentID = "";
         array = false;
     }
 
     void Interpreter::visit(parser::ASTLiteralNode<float> *literalNode) {
-        interpreter::Variable<float> v("float", "0literal", false, literalNode -> val, literalNode -> lineNumber);
-        // remove previous literal
-        floatTable.pop_back("0literal");
-        floatTable.insert(v);
+        current = literalNode -> val;
         currentType = "float";
-        currentID = "0literal";
+        currentID = "";
         array = false;
     }
 
     void Interpreter::visit(parser::ASTLiteralNode<bool> *literalNode) {
-        interpreter::Variable<bool> v("bool", "0literal", false, literalNode -> val, literalNode -> lineNumber);
-        // remove previous literal
-        boolTable.pop_back("0literal");
-        boolTable.insert(v);
+        current = literalNode -> val;
         currentType = "bool";
-        currentID = "0literal";
+        currentID = "";
         array = false;
     }
 
     void Interpreter::visit(parser::ASTLiteralNode<std::string> *literalNode) {
-        interpreter::Variable<std::string> v("string", "0literal", false, literalNode -> val, literalNode -> lineNumber);
-        // remove previous literal
-        stringTable.pop_back("0literal");
-        stringTable.insert(v);
+        current = literalNode -> val;
         currentType = "string";
-        currentID = "0literal";
+        currentID = "";
+        array = false;
     }
 
     void Interpreter::visit(parser::ASTLiteralNode<char> *literalNode) {
-        interpreter::Variable<char> v("char", "0literal", false, literalNode -> val, literalNode -> lineNumber);
-        // remove previous literal
-        charTable.pop_back("0literal");
-        charTable.insert(v);
+        current = literalNode -> val;
         currentType = "char";
-        currentID = "0literal";
+        currentID = "";
         array = false;
     }
 
     void Interpreter::visit(parser::ASTArrayLiteralNode *arrayLiteralNode) {
-        if(currentType == "int"){
-            std::vector<int> arr;
-            for(const auto& item : arrayLiteralNode->expressions){
-                item->accept(this);
-                arr.emplace_back(intTable.get(currentID).latestValue);
-            }
-            currentType = "int";
-            intArrayTable.insert(interpreter::Variable<std::vector<int>>("int", "0literal", true, arr, arrayLiteralNode->lineNumber));
-        }else if(currentType == "float"){
-            std::vector<float> arr;
-
-            for(const auto& item : arrayLiteralNode->expressions){
-                item->accept(this);
-                arr.emplace_back(floatTable.get(currentID).latestValue);
-            }
-            floatArrayTable.insert(interpreter::Variable<std::vector<float>>("int", "0literal", true, arr, arrayLiteralNode->lineNumber));
-        }else if(currentType == "bool"){
-            std::vector<bool> arr;
-
-            for(const auto& item : arrayLiteralNode->expressions){
-                item->accept(this);
-                arr.emplace_back(boolTable.get(currentID).latestValue);
-            }
-            boolArrayTable.insert(interpreter::Variable<std::vector<bool>>("int", "0literal", true, arr, arrayLiteralNode->lineNumber));
-        }else if(currentType == "string"){
-            std::vector<std::string> arr;
-
-            for(const auto& item : arrayLiteralNode->expressions){
-                item->accept(this);
-                arr.emplace_back(stringTable.get(currentID).latestValue);
-            }
-            stringArrayTable.insert(interpreter::Variable<std::vector<std::string>>("int", "0literal", true, arr, arrayLiteralNode->lineNumber));
-        }else if(currentType == "char"){
-            std::vector<char> arr;
-
-            for(const auto& item : arrayLiteralNode->expressions){
-                item->accept(this);
-                arr.emplace_back(charTable.get(currentID).latestValue);
+        // the current type is the declared type of the elements
+        std::string type = currentType;
+        // nothing is stored for arrays of structs, leave the type empty so that nothing uses the value
+        if(lexer::isStruct(type)){
+            current = interpreter::Value();
+            type = "";
+        }else{
+            auto elements = interpreter::Value::array(type, 0);
+            for(const auto& item : arrayLiteralNode -> expressions){
+                item -> accept(this);
+                elements.push_back(current);
             }
-            charArrayTable.insert(interpreter::Variable<std::vector<char>>("int", "0literal", true, arr, arrayLiteralNode->lineNumber));
+            current = std::move(elements);
         }
+        currentType = type;
+        currentID = "";
         array = true;
-        currentID = "0literal";
+        iloc = -1;
     }
 
     void Interpreter::visit(parser::ASTBinaryNode *binaryNode) {
-        // First get the operator
-        std::string op = binaryNode -> op;
         // Accept left expression
         binaryNode -> left -> accept(this);
-        // Push left node into 0CurrentVariable
-        if(currentType == "int"){
-            intTable.insert(interpreter::Variable<int>("int", "0CurrentVariable",
-                                                       false,
-                                                       (array ? intArrayTable.get(currentID).latestValue.at(iloc) : intTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-        }else if(currentType == "float"){
-            floatTable.insert(interpreter::Variable<float>("float", "0CurrentVariable",
-                                                           false,
-                                                           (array ? floatArrayTable.get(currentID).latestValue.at(iloc) : floatTable.get(currentID).latestValue),
-                                                           binaryNode->lineNumber));
-        }else if(currentType == "bool"){
-            boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                           false,
-                                                           (array ? boolArrayTable.get(currentID).latestValue.at(iloc) : boolTable.get(currentID).latestValue),
-                                                           binaryNode->lineNumber));
-        }else if(currentType == "string"){
-            stringTable.insert(interpreter::Variable<std::string>("string", "0CurrentVariable",
-                                                           false,
-                                                           (array ? stringArrayTable.get(currentID).latestValue.at(iloc) : stringTable.get(currentID).latestValue),
-                                                            binaryNode->lineNumber));
-        }else if(currentType == "char"){
-            charTable.insert(interpreter::Variable<char>("char", "0CurrentVariable",
-                                                     false,
-                                                          (array ? charArrayTable.get(currentID).latestValue.at(iloc) : charTable.get(currentID).latestValue),
-                                                          binaryNode->lineNumber));
-        }else{
+        if(lexer::isStruct(currentType)){
             // should never get here
             throw std::runtime_error("Expression on line " + std::to_string(binaryNode -> lineNumber)
                                      + " has incorrect operator " + binaryNode -> op
-                                     + " acting on expression of type " + currentType);
+                                     + " acting between expressions of type " + currentType);
         }
+        // Keep the left value while the right expression is visited
+        interpreter::Value left = std::move(current);
 
         // Accept right expression
-        std::string _struct_copy = structID;
-        // clear for now
-        structID = "";
         binaryNode -> right -> accept(this);
-        structID = _struct_copy;
-        // We know both variables have the same type
-        // So we check the currentType's type to see which operations we can do
-        // check op type
-        if(currentType == "int"){
-            switch (lexer::determineOperatorType(binaryNode -> op)) {
-                /*
-                 * The following code will follow this structure
-                 *
-                 * insert(Variable(TYPE, CURRENTVARIABLE, EXPRESSION, LINENUMBER)
-                 *
-                 * the EXPRESSION is built by popping the CURRENTVARIABLE list of values and operating with the currentID variable
-                 * which is retreived via the find function.
-                 * here I do not check with found() because we already know this variable exists as either the
-                 * literal variable or any other variable as it is changed by the visits to the literal or identifier nodes.
-                 *
-                 * I am sure that there is a cleaner way of doing this but I still think this is pretty clean
-                 *
-                 * ...albeit very long and repetitive
-                 *
-                 */
-                case lexer::TOK_NOT_EQAUL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       intTable.get().latestValue
-                                                       !=
-                                                       (array ? intArrayTable.get(currentID).latestValue.at(iloc) : intTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_EQAUL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       intTable.get().latestValue
-                                                       ==
-                                                       (array ? intArrayTable.get(currentID).latestValue.at(iloc) : intTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_MORE_THAN:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       intTable.get().latestValue
-                                                       >
-                                                       (array ? intArrayTable.get(currentID).latestValue.at(iloc) : intTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_LESS_THAN:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       intTable.get().latestValue
-                                                       <
-                                                       (array ? intArrayTable.get(currentID).latestValue.at(iloc) : intTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_MORE_THAN_EQUAL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       intTable.get().latestValue
-                                                       >=
-                                                       (array ? intArrayTable.get(currentID).latestValue.at(iloc) : intTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_LESS_THAN_EQUAL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       intTable.get().latestValue
-                                                      <=
-                                                      (array ? intArrayTable.get(currentID).latestValue.at(iloc) : intTable.get(currentID).latestValue),
-                                                      binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                // int and float accepted operators
-                case lexer::TOK_PLUS:
-                    intTable.insert(interpreter::Variable<int>("int", "0CurrentVariable",
-                                                       false,
-                                                       intTable.get().latestValue
-                                                       +
-                                                       (array ? intArrayTable.get(currentID).latestValue.at(iloc) : intTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "int";
-                    break;
-                case lexer::TOK_ASTERISK:
-                    intTable.insert(interpreter::Variable<int>("int", "0CurrentVariable",
-                                                       false,
-                                                       intTable.get().latestValue
-                                                      *
-                                                      (array ? intArrayTable.get(currentID).latestValue.at(iloc) : intTable.get(currentID).latestValue),
-                                                      binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "int";
-                    break;
-                case lexer::TOK_DIVIDE:
-                    // if divide by 0 happens, gcc will raise its own error, no need to change the structure to accomodate for this
-                    intTable.insert(interpreter::Variable<int>("int", "0CurrentVariable",
-                                                       false,
-                                                       intTable.get().latestValue
-                                                      /
-                                                      (array ? intArrayTable.get(currentID).latestValue.at(iloc) : intTable.get(currentID).latestValue),
-                                                      binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "int";
-                    break;
-                case lexer::TOK_MINUS:
-                    intTable.insert(interpreter::Variable<int>("int", "0CurrentVariable",
-                                                       false,
-                                                       intTable.get().latestValue
-                                                      -
-                                                      (array ? intArrayTable.get(currentID).latestValue.at(iloc) : intTable.get(currentID).latestValue),
-                                                      binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "int";
-                    break;
-                default:
-                    // Should never get here because of the semantic pass but still included because of the default case
-                    throw std::runtime_error("Expression on line " + std::to_string(binaryNode -> lineNumber)
-                                             + " has incorrect operator " + binaryNode -> op
-                                             + " acting between expressions of type " + currentType);
-            }
-        }else if(currentType == "float") {
-            switch (lexer::determineOperatorType(binaryNode -> op)) {
-                case lexer::TOK_NOT_EQAUL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       floatTable.get().latestValue
-                                                       !=
-                                                       (array ? floatArrayTable.get(currentID).latestValue.at(iloc) : floatTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_EQAUL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       floatTable.get().latestValue
-                                                       ==
-                                                       (array ? floatArrayTable.get(currentID).latestValue.at(iloc) : floatTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_MORE_THAN:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       floatTable.get().latestValue
-                                                       >
-                                                       (array ? floatArrayTable.get(currentID).latestValue.at(iloc) : floatTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_LESS_THAN:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       floatTable.get().latestValue
-                                                       <
-                                                       (array ? floatArrayTable.get(currentID).latestValue.at(iloc) : floatTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_MORE_THAN_EQUAL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       floatTable.get().latestValue
-                                                       >=
-                                                       (array ? floatArrayTable.get(currentID).latestValue.at(iloc) : floatTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_LESS_THAN_EQUAL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       floatTable.get().latestValue
-                                                       <=
-                                                       (array ? floatArrayTable.get(currentID).latestValue.at(iloc) : floatTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                    // int and float accepted operators
-                case lexer::TOK_PLUS:
-                    floatTable.insert(interpreter::Variable<float>("float", "0CurrentVariable",
-                                                       false,
-                                                       floatTable.get().latestValue
-                                                       +
-                                                       (array ? floatArrayTable.get(currentID).latestValue.at(iloc) : floatTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "float";
-                    break;
-                case lexer::TOK_ASTERISK:
-                    floatTable.insert(interpreter::Variable<float>("float", "0CurrentVariable",
-                                                       false,
-                                                       floatTable.get().latestValue
-                                                        *
-                                                        (array ? floatArrayTable.get(currentID).latestValue.at(iloc) : floatTable.get(currentID).latestValue),
-                                                        binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "float";
-                    break;
-                case lexer::TOK_DIVIDE:
-                    // if divide by 0 happens, gcc will raise its own error, no need to change the structure to accomodate for this
-                    floatTable.insert(interpreter::Variable<float>("float", "0CurrentVariable",
-                                                       false,
-                                                       floatTable.get().latestValue
-                                                        /
-                                                        (array ? floatArrayTable.get(currentID).latestValue.at(iloc) : floatTable.get(currentID).latestValue),
-                                                        binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "float";
-                    break;
-                case lexer::TOK_MINUS:
-                    floatTable.insert(interpreter::Variable<float>("float", "0CurrentVariable",
-                                                       false,
-                                                       floatTable.get().latestValue
-                                                        -
-                                                        (array ? floatArrayTable.get(currentID).latestValue.at(iloc) : floatTable.get(currentID).latestValue),
-                                                        binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "float";
-                    break;
-                default:
-                    // Should never get here because of the semantic pass but still included because of the default case
-                    throw std::runtime_error("Expression on line " + std::to_string(binaryNode -> lineNumber)
-                                             + " has incorrect operator " + binaryNode -> op
-                                             + " acting between expressions of type " + currentType);
-            }
-        }else if(currentType == "bool"){
-            switch (lexer::determineOperatorType(binaryNode -> op)) {
-                case lexer::TOK_NOT_EQAUL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       boolTable.get().latestValue
-                                                        !=
-                                                        (array ? boolArrayTable.get(currentID).latestValue.at(iloc) : boolTable.get(currentID).latestValue),
-                                                        binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_EQAUL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       boolTable.get().latestValue
-                                                       ==
-                                                       (array ? boolArrayTable.get(currentID).latestValue.at(iloc) : boolTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_AND:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       boolTable.get().latestValue
-                                                       &&
-                                                       (array ? boolArrayTable.get(currentID).latestValue.at(iloc) : boolTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "0CurrentVariable";
-                    break;
-                case lexer::TOK_OR:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       boolTable.get().latestValue
-                                                       ||
-                                                       (array ? boolArrayTable.get(currentID).latestValue.at(iloc) : boolTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_MORE_THAN:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       boolTable.get().latestValue
-                                                       >
-                                                       (array ? boolArrayTable.get(currentID).latestValue.at(iloc) : boolTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_LESS_THAN:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       boolTable.get().latestValue
-                                                       <
-                                                       (array ? boolArrayTable.get(currentID).latestValue.at(iloc) : boolTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_MORE_THAN_EQUAL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       boolTable.get().latestValue
-                                                       >=
-                                                       (array ? boolArrayTable.get(currentID).latestValue.at(iloc) : boolTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "0CurrentVariable";
-                    break;
-                case lexer::TOK_LESS_THAN_EQUAL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       boolTable.get().latestValue
-                                                       <=
-                                                       (array ? boolArrayTable.get(currentID).latestValue.at(iloc) : boolTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                default:
-                    // Should never get here because of the semantic pass but still included because of the default case
-                    throw std::runtime_error("Expression on line " + std::to_string(binaryNode -> lineNumber)
-                                             + " has incorrect operator " + binaryNode -> op
-                                             + " acting between expressions of type " + currentType);
-            }
-        }else if(currentType == "string") {
-            switch (lexer::determineOperatorType(binaryNode -> op)) {
-                case lexer::TOK_NOT_EQAUL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       stringTable.get().latestValue
-                                                       !=
-                                                       (array ? stringArrayTable.get(currentID).latestValue.at(iloc) : stringTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_EQAUL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                       false,
-                                                       stringTable.get().latestValue
-                                                       ==
-                                                       (array ? stringArrayTable.get(currentID).latestValue.at(iloc) : stringTable.get(currentID).latestValue),
-                                                       binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_PLUS:
-                    stringTable.insert(interpreter::Variable<std::string>("string", "0CurrentVariable",
-                                                              false,
-                                                              stringTable.get().latestValue
-                                                              +
-                                                              (array ? stringArrayTable.get(currentID).latestValue.at(iloc) : stringTable.get(currentID).latestValue),
-                                                              binaryNode -> lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "string";
-                    break;
-                default:
-                    // Should never get here because of the semantic pass but still included because of the default case
-                    throw std::runtime_error("Expression on line " + std::to_string(binaryNode -> lineNumber)
-                                             + " has incorrect operator " + binaryNode -> op
-                                             + " acting between expressions of type " + currentType);
-            }
-        }else if(currentType == "char") {
-            switch (lexer::determineOperatorType(binaryNode->op)) {
-                case lexer::TOK_NOT_EQAUL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                                 false,
-                                                                 charTable.get().latestValue
-                                                                 !=
-                                                                 (array ? charArrayTable.get(
-                                                                         currentID).latestValue.at(iloc)
-                                                                        : charTable.get(currentID).latestValue),
-                                                                 binaryNode->lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                case lexer::TOK_EQAUL_TO:
-                    boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable",
-                                                                 false,
-                                                                 charTable.get().latestValue
-                                                                 ==
-                                                                 (array ? charArrayTable.get(
-                                                                         currentID).latestValue.at(iloc)
-                                                                        : charTable.get(currentID).latestValue),
-                                                                 binaryNode->lineNumber));
-                    // Update Current Type to the that of the type being inserted
-                    currentType = "bool";
-                    break;
-                default:
-                    // Should never get here because of the semantic pass but still included because of the default case
-                    throw std::runtime_error("Expression on line " + std::to_string(binaryNode->lineNumber)
-                                             + " has incorrect operator " + binaryNode->op
-                                             + " acting between expressions of type " + currentType);
-            }
-        }
-        // Update Current ID
-        currentID = "0CurrentVariable";
+
+        current = interpreter::apply(binaryNode -> kind, left, current, binaryNode -> lineNumber);
+        // Update Current Type to the that of the result
+        currentType = current.type();
+        currentID = "";
         // ensure array is off
         array = false;
     }
 
     void Interpreter::visit(parser::ASTIdentifierNode *identifierNode) {
-        // two cases 1 where iloc is defined (array) the other when it isnt (other types)
-        std::string id = "";
-        if(!structID.empty()){
-            id += structID + ".";
-        }
-        id += identifierNode -> getID();
-        if(identifierNode->ilocExprNode == nullptr){
-            // Build variable shells
+        auto v = locate(identifierNode);
+        currentID = identifierNode -> identifier;
+        if(v == nullptr){
+            // nothing is stored for arrays of structs, leave the type empty so that nothing uses the value
+            current = interpreter::Value();
+            currentType = "";
             array = false;
-            interpreter::Variable<int> i(id);
-            interpreter::Variable<float> f(id);
-            interpreter::Variable<bool> b(id);
-            interpreter::Variable<std::string> s(id);
-            interpreter::Variable<char> c(id);
-            //struct
-            // Check that a variable with this identifier exists
-            auto resultI = intTable.find(i);
-            if(intTable.found(resultI)) {
-                // if identifier has been found
-                // change current Type
-                currentType = resultI -> second.type;
-                // change current ID
-                currentID = resultI -> second.identifier;
-                // Then return
-                return;
-            }
-            auto resultF = floatTable.find(f);
-            if(floatTable.found(resultF)) {
-                // if identifier has been found
-                // change current Type
-                currentType = resultF -> second.type;
-                // change current ID
-                currentID = resultF -> second.identifier;
-                // Then return
-                return;
-            }
-            auto resultB = boolTable.find(b);
-            if(boolTable.found(resultB)) {
-                // if identifier has been found
-                // change current Type
-                currentType = resultB -> second.type;
-                // change current ID
-                currentID = resultB -> second.identifier;
-                // Then return
-                return;
-            }
-            auto resultS = stringTable.find(s);
-            if(stringTable.found(resultS)) {
-                // if identifier has been found
-                // change current Type
-                currentType = resultS -> second.type;
-                // change current ID
-                currentID = resultS -> second.identifier;
-                // Then return
-                return;
+            return;
+        }
+        currentType = v -> type();
+        array = v -> isArray();
+        // only the element is copied out of an indexed array, arrays themselves are shared
+        current = (array && iloc >= 0) ? v -> at(iloc) : *v;
+    }
+
+    int Interpreter::index(parser::ASTIdentifierNode *identifierNode) {
+        array = false;
+        identifierNode -> ilocExprNode -> accept(this);
+        if(current.tag() == interpreter::Value::INT)
+            return std::get<int>(current);
+        if(current.tag() == interpreter::Value::FLOAT)
+            return (int) std::get<float>(current);
+        throw std::runtime_error("Variable with identifier " + identifierNode->getID() + " called on line "
+                                 + std::to_string(identifierNode->lineNumber) + " has not incorrect value between [].");
+    }
+
+    interpreter::Value* Interpreter::locate(parser::ASTIdentifierNode *identifierNode, parser::ASTIdentifierNode *last) {
+        // two cases 1 where iloc is defined (array) the other when it isnt (other types)
+        int element = identifierNode -> ilocExprNode != nullptr ? index(identifierNode) : -1;
+        interpreter::Value* v = nullptr;
+        if(identifierNode -> slot >= 0){
+            // a parameter of the current call
+            v = &frames[base + identifierNode -> slot];
+        }else if(self != nullptr && identifierNode -> offset >= 0){
+            // a member of the instance the method runs on
+            v = &std::get<interpreter::Record>(*self).fields[identifierNode -> offset];
+        }else if(self != nullptr && identifierNode -> identifier == "self"){
+            v = self;
+        }else{
+            if(self != nullptr && byName){
+                auto& record = std::get<interpreter::Record>(*self);
+                auto member = record.layout -> offsets.find(identifierNode -> identifier);
+                if(member != record.layout -> offsets.end())
+                    v = &record.fields[member -> second];
             }
-            auto resultC = charTable.find(c);
-            if(charTable.found(resultC)) {
-                // if identifier has been found
-                // change current Type
-                currentType = resultC -> second.type;
-                // change current ID
-                currentID = resultC -> second.identifier;
-                // Then return
-                return;
+            if(v == nullptr){
+                // A single lookup, the type is read from the value
+                auto result = variableTable.find(identifierNode -> identifier);
+                if(!variableTable.found(result))
+                    return nullptr;
+                v = &result -> second.latestValue;
             }
         }
-        // array cases
-
-        if(identifierNode->ilocExprNode != nullptr){
-            // get array iloc
-            auto _cId = currentID;
-            auto _cType = currentType;
-            identifierNode->ilocExprNode->accept(this);
-            if(currentType == "int"){
-                iloc = intTable.get(currentID).latestValue;
-            }else if(currentType == "float"){
-                iloc = floatTable.get(currentID).latestValue;
+        // The members are at a fixed offset in the fields of the instance
+        for(auto child = identifierNode -> getChild(); child != nullptr && !child -> isEmpty() && child.get() != last; child = child -> getChild()){
+            // nothing is stored for arrays of structs
+            if(element >= 0 || v -> tag() != interpreter::Value::RECORD)
+                return nullptr;
+            auto& record = std::get<interpreter::Record>(*v);
+            if(child -> offset >= 0){
+                v = &record.fields[child -> offset];
             }else{
-                throw std::runtime_error("Variable with identifier " + identifierNode->getID() + " called on line "
-                                         + std::to_string(identifierNode->lineNumber) + " has not incorrect value between [].");
+                auto member = record.layout -> offsets.find(child -> identifier);
+                if(member == record.layout -> offsets.end())
+                    return nullptr;
+                v = &record.fields[member -> second];
             }
-            currentID = _cId;
-            currentType = _cType;
-        }else{
-            iloc = -1;
-        }
-        // Build variable shells
-        interpreter::Variable<std::vector<int>> i(id);
-        interpreter::Variable<std::vector<float>> f(id);
-        interpreter::Variable<std::vector<bool>> b(id);
-        interpreter::Variable<std::vector<std::string>> s(id);
-        interpreter::Variable<std::vector<char>> c(id);
-        //struct
-        array = true;
-        // Check that a variable with this identifier exists
-        auto resultI = intArrayTable.find(i);
-        if(intArrayTable.found(resultI)) {
-            // if identifier has been found
-            // change current Type
-            currentType = resultI -> second.type;
-            // change current ID
-            currentID = resultI -> second.identifier;
-            // Then return
-            return;
-        }
-        auto resultF = floatArrayTable.find(f);
-        if(floatArrayTable.found(resultF)) {
-            // if identifier has been found
-            // change current Type
-            currentType = resultF -> second.type;
-            // change current ID
-            currentID = resultF -> second.identifier;
-            // Then return
-            return;
-        }
-        auto resultB = boolArrayTable.find(b);
-        if(boolArrayTable.found(resultB)) {
-            // if identifier has been found
-            // change current Type
-            currentType = resultB -> second.type;
-            // change current ID
-            currentID = resultB -> second.identifier;
-            // Then return
-            return;
-        }
-        auto resultS = stringArrayTable.find(s);
-        if(stringArrayTable.found(resultS)) {
-            // if identifier has been found
-            // change current Type
-            currentType = resultS -> second.type;
-            // change current ID
-            currentID = resultS -> second.identifier;
-            // Then return
-            return;
-        }
-        auto resultC = charArrayTable.find(c);
-        if(charArrayTable.found(resultC)) {
-            // if identifier has been found
-            // change current Type
-            currentType = resultC -> second.type;
-            // change current ID
-            currentID = resultC -> second.identifier;
-            // Then return
-            return;
+            element = child -> ilocExprNode != nullptr ? index(child.get()) : -1;
         }
-        // Variable hasn't been found (should never get here)
-        // iof not found than it is a struct
-        currentType = struct_variable.find((structID.empty() ? identifierNode->getID() : structID))->second;
-        currentID = identifierNode->getID();
+        iloc = element;
+        return v;
     }
 
     void Interpreter::visit(parser::ASTUnaryNode *unaryNode) {
-        // visit the expression to get the type and id
+        // visit the expression to get the type and value
         unaryNode -> exprNode -> accept(this);
-        // now we check the type
-        if(currentType == "int"){
-            intTable.insert(interpreter::Variable<int>("int", "string", false, intTable.get(currentID).latestValue * -1, unaryNode -> lineNumber));
-        }else if(currentType == "float"){
-            floatTable.insert(interpreter::Variable<float>("float", "0CurrentVariable", false, floatTable.get(currentID).latestValue * -1, unaryNode -> lineNumber));
-        }else if(currentType == "bool"){
-            boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable", false, ! boolTable.get(currentID).latestValue, unaryNode -> lineNumber));
-        }else{
-            // should get here
-            throw std::runtime_error("Expression on line " + std::to_string(unaryNode -> lineNumber)
-                                     + " has incorrect operator " + unaryNode -> op
-                                     + " acting for expression of type " + currentType);
-        }
+        current = interpreter::negate(current, unaryNode -> lineNumber);
+        currentID = "";
+        array = false;
     }
 
     void Interpreter::visit(parser::ASTFunctionCallNode *functionCallNode) {
-        // get parameters
-        std::vector<std::string> paramTypes;
-        for (const auto& param : functionCallNode->parameters){
-            // this visit will check if the variables exist
-            param->accept(this);
-            // store the types (in order) so than we can confirm that the types are good
-            // when the function is found
-            paramTypes.emplace_back(currentType);
-        }
-        // Generate Function
-        interpreter::Function f(functionCallNode -> identifier -> getID(), paramTypes);
-        // find actual function
-        auto result = find(f);
-        if(! found(result)) {
-            // Should never get here
-            throw std::runtime_error("Function with identifier " + f.identifier + " called on line "
-                                     + std::to_string(functionCallNode->lineNumber) + " has not been declared.");
+        call(functionCallNode -> identifier, functionCallNode -> parameters, functionCallNode -> callee,
+             functionCallNode -> method, functionCallNode -> lineNumber);
+    }
+    // Expressions
+
+    // Statements
+
+    void Interpreter::visit(parser::ASTSFunctionCallNode *sFunctionCallNode) {
+        call(sFunctionCallNode -> identifier, sFunctionCallNode -> parameters, sFunctionCallNode -> callee,
+             sFunctionCallNode -> method, sFunctionCallNode -> lineNumber);
+    }
+
+    parser::ASTFunctionDeclarationNode* Interpreter::resolve(parser::ASTIdentifierNode* identifier, parser::ASTIdentifierNode* name, std::size_t frame,
+                                                             parser::ASTFunctionDeclarationNode* callee, interpreter::Value*& receiver,
+                                                             std::atomic<parser::ASTFunctionDeclarationNode*>& method, unsigned int lineNumber) {
+        if(callee != nullptr){
+            receiver = nullptr;
+            return callee;
         }
-        f = result->second;
-        // go over the function parameters
-        // and make sure to update these variables according to the parameters passed
-        for (int i = 0; i < functionCallNode -> parameters.size(); ++i){
-            // this visit will check if the variables exist
-            functionCallNode -> parameters.at(i) -> accept(this);
-            // This visit updates the currentID and currentType
-            // store current ID so that we dont need to visit the parameters again to pop their values
-            toPop.emplace_back(interpreter::Popable(currentType, f.paramIDs.at(i), array));
-            if(lexer::isStruct(currentType)){
-//                parser::ASTDeclarationNode declarationNode(currentType,
-//                                                           std::make_shared<parser::ASTIdentifierNode>(f.paramIDs.at(i), nullptr, nullptr, functionCallNode->lineNumber),
-//                                                           nullptr, functionCallNode->lineNumber);
-//                declarationNode.accept(this);
-
-            }else
-            if(currentType == "int"){
-                /* Update the currentID variable by emplacing back
-                 * to f.paramIDs.at(i) variable
-                 * what is found inside the variable with identifier currentID
-                 * which we got from visiting the parameter expression
-                 * this temporarily overwrites any global variable
-                 * Once the block is function block is visited we pop back these variables to clear memory
-                */
-                array ?
-                intArrayTable.insert(interpreter::Variable<std::vector<int>>("int", f.paramIDs.at(i), true, intArrayTable.get(currentID).latestValue, functionCallNode -> lineNumber))
-                      :
-                intTable.insert(interpreter::Variable<int>("int", f.paramIDs.at(i), false, intTable.get(currentID).latestValue, functionCallNode -> lineNumber));
-            }else if(currentType == "float"){
-                array ?
-                floatArrayTable.insert(interpreter::Variable<std::vector<float>>("float", f.paramIDs.at(i), true, floatArrayTable.get(currentID).latestValue, functionCallNode -> lineNumber))
-                      :
-                floatTable.insert(interpreter::Variable<float>("float", f.paramIDs.at(i), false, floatTable.get(currentID).latestValue, functionCallNode -> lineNumber));
-            }else if(currentType == "bool"){
-                array ?
-                boolArrayTable.insert(interpreter::Variable<std::vector<bool>>("bool", f.paramIDs.at(i), true, boolArrayTable.get(currentID).latestValue, functionCallNode -> lineNumber))
-                      :
-                boolTable.insert(interpreter::Variable<bool>("bool", f.paramIDs.at(i), false, boolTable.get(currentID).latestValue, functionCallNode -> lineNumber));
-            }else if(currentType == "string"){
-                array ?
-                stringArrayTable.insert(interpreter::Variable<std::vector<std::string>>("string", f.paramIDs.at(i), true, stringArrayTable.get(currentID).latestValue, functionCallNode -> lineNumber))
-                      :
-                stringTable.insert(interpreter::Variable<std::string>("string", f.paramIDs.at(i), false, stringTable.get(currentID).latestValue, functionCallNode -> lineNumber));
-            }else if(currentType == "char"){
-                array ?
-                charArrayTable.insert(interpreter::Variable<std::vector<char>>("char", f.paramIDs.at(i), true, charArrayTable.get(currentID).latestValue, functionCallNode -> lineNumber))
-                      :
-                charTable.insert(interpreter::Variable<char>("char", f.paramIDs.at(i), false, charTable.get(currentID).latestValue, functionCallNode -> lineNumber));
+        // The argument types are only built when the callee has to be looked up
+        auto paramTypes = [this, frame](){
+            std::vector<std::string> types;
+            for(auto i = frame; i < frames.size(); ++i)
+                types.emplace_back(frames[i].type());
+            return types;
+        };
+        // methods are found in the layout of the receiver, bare calls inside a method may call one too
+        if(receiver != nullptr && receiver -> tag() == interpreter::Value::RECORD){
+            auto layout = std::get<interpreter::Record>(*receiver).layout;
+            auto cached = method.load(std::memory_order_relaxed);
+            if(cached != nullptr && cached -> owner == layout -> structNode.get()){
+                // the same struct as the last call from here
+                callee = cached;
+            }else{
+                auto result = layout -> methods.find(std::make_pair(name -> identifier, paramTypes()));
+                if(result != layout -> methods.end()){
+                    callee = result -> second;
+                    method.store(callee, std::memory_order_relaxed);
+                }
             }
         }
-        // Ok so now we have updated the arguments, so we can call the actual function to run
-        function = true;
-
-        if(!functionCallNode->identifier->isEmpty()){
-            auto parent = parser::ASTIdentifierNode(functionCallNode->identifier->identifier, functionCallNode->identifier->getChild(), functionCallNode->identifier->ilocExprNode, functionCallNode->identifier->lineNumber);
-            auto child = parent.getChild();
-            structID = "";
-            while(child != nullptr){
-                structID += functionCallNode->identifier->identifier;
-                parent = parser::ASTIdentifierNode(child);
-                child = child->getChild();
+        if(callee == nullptr && name == identifier){
+            auto result = find(interpreter::Function(identifier -> identifier, paramTypes()));
+            if(found(result)){
+                callee = result -> second.declaration;
+                // a global function does not run on the instance
+                receiver = nullptr;
             }
         }
-
-        f.blockNode -> accept(this);
-        function = false;
+        if(callee == nullptr) {
+            // Should never get here
+            throw std::runtime_error("Function with identifier " + identifier -> getID() + " called on line "
+                                     + std::to_string(lineNumber) + " has not been declared.");
+        }
+        return callee;
     }
-    // Expressions
-
-    // Statements
 
-    void Interpreter::visit(parser::ASTSFunctionCallNode *sFunctionCallNode) {
-        // get parameters
-        std::vector<std::string> paramTypes;
-        for (const auto& param : sFunctionCallNode->parameters){
-            // this visit will check if the variables exist
+    void Interpreter::call(const std::shared_ptr<parser::ASTIdentifierNode>& identifier, const std::vector<std::shared_ptr<parser::ASTExprNode>>& parameters,
+                           parser::ASTFunctionDeclarationNode* callee, std::atomic<parser::ASTFunctionDeclarationNode*>& method,
+                           unsigned int lineNumber) {
+        // the new frame starts after the frames of the active calls
+        std::size_t frame = frames.size();
+        // Evaluate each argument once, straight into its slot
+        for (const auto& param : parameters){
             param->accept(this);
-            // store the types (in order) so than we can confirm that the types are good
-            // when the function is found
-            paramTypes.emplace_back(currentType);
+            frames.emplace_back(std::move(current));
         }
-        // Generate Function
-        interpreter::Function f(sFunctionCallNode -> identifier -> getID(), paramTypes);
-        // find actual function
-        auto result = find(f);
-        if(! found(result)) {
-            // Should never get here
-            throw std::runtime_error("Function with identifier " + f.identifier + " called on line "
-                                     + std::to_string(sFunctionCallNode->lineNumber) + " has not been declared.");
+        // The instance a method runs on, the method is the last child of the identifier
+        auto receiver = self;
+        auto name = identifier.get();
+        while(name -> getChild() != nullptr && !name -> getChild() -> isEmpty())
+            name = name -> getChild().get();
+        if(name != identifier.get())
+            receiver = locate(identifier.get(), name);
+        callee = resolve(identifier.get(), name, frame, callee, receiver, method, lineNumber);
+        enter(identifier.get(), callee, frame, receiver, lineNumber);
+    }
+
+    void Interpreter::enter(parser::ASTIdentifierNode* identifier, parser::ASTFunctionDeclarationNode* callee, std::size_t frame,
+                            interpreter::Value* receiver, unsigned int lineNumber) {
+        // A hot global function runs as native code when the JIT supports it
+        if(receiver == nullptr && jit.run(callee, frames, frame, depth + 1, current)){
+            frames.resize(frame);
+            return;
         }
-        f = result->second;
-        // go over the function parameters
-        // and make sure to update these variables according to the parameters passed
-        for (int i = 0; i < sFunctionCallNode -> parameters.size(); ++i){
-            // this visit will check if the variables exist
-            sFunctionCallNode -> parameters.at(i) -> accept(this);
-            // This visit updates the currentID and currentType
-            // store current ID so that we dont need to visit the parameters again to pop their values
-            toPop.emplace_back(interpreter::Popable(currentType, f.paramIDs.at(i), array));
-            if(lexer::isStruct(currentType)){
-//                parser::ASTDeclarationNode declarationNode(currentType,
-//                                                           std::make_shared<parser::ASTIdentifierNode>(f.paramIDs.at(i), nullptr, nullptr, sFunctionCallNode->lineNumber),
-//                                                           nullptr, sFunctionCallNode->lineNumber);
-//                declarationNode.accept(this);
-
-            }else
-            if(currentType == "int"){
-                /* Update the currentID variable by emplacing back
-                 * to f.paramIDs.at(i) variable
-                 * what is found inside the variable with identifier currentID
-                 * which we got from visiting the parameter expression
-                 * this temporarily overwrites any global variable
-                 * Once the block is function block is visited we pop back these variables to clear memory
-                */
-                array ?
-                intArrayTable.insert(interpreter::Variable<std::vector<int>>("int", f.paramIDs.at(i), true, intArrayTable.get(currentID).latestValue, sFunctionCallNode -> lineNumber))
-                :
-                intTable.insert(interpreter::Variable<int>("int", f.paramIDs.at(i), false, intTable.get(currentID).latestValue, sFunctionCallNode -> lineNumber));
-            }else if(currentType == "float"){
-                array ?
-                floatArrayTable.insert(interpreter::Variable<std::vector<float>>("float", f.paramIDs.at(i), true, floatArrayTable.get(currentID).latestValue, sFunctionCallNode -> lineNumber))
-                :
-                floatTable.insert(interpreter::Variable<float>("float", f.paramIDs.at(i), false, floatTable.get(currentID).latestValue, sFunctionCallNode -> lineNumber));
-            }else if(currentType == "bool"){
-                array ?
-                boolArrayTable.insert(interpreter::Variable<std::vector<bool>>("bool", f.paramIDs.at(i), true, boolArrayTable.get(currentID).latestValue, sFunctionCallNode -> lineNumber))
-                :
-                boolTable.insert(interpreter::Variable<bool>("bool", f.paramIDs.at(i), false, boolTable.get(currentID).latestValue, sFunctionCallNode -> lineNumber));
-            }else if(currentType == "string"){
-                array ?
-                stringArrayTable.insert(interpreter::Variable<std::vector<std::string>>("string", f.paramIDs.at(i), true, stringArrayTable.get(currentID).latestValue, sFunctionCallNode -> lineNumber))
-                :
-                stringTable.insert(interpreter::Variable<std::string>("string", f.paramIDs.at(i), false, stringTable.get(currentID).latestValue, sFunctionCallNode -> lineNumber));
-            }else if(currentType == "char"){
-                array ?
-                charArrayTable.insert(interpreter::Variable<std::vector<char>>("char", f.paramIDs.at(i), true, charArrayTable.get(currentID).latestValue, sFunctionCallNode -> lineNumber))
-                :
-                charTable.insert(interpreter::Variable<char>("char", f.paramIDs.at(i), false, charTable.get(currentID).latestValue, sFunctionCallNode -> lineNumber));
+
+        if(depth >= capacity || interpreter::available() == 0)
+            throw std::runtime_error("Stack depth exceeded calling " + identifier -> getID() + ".");
+        ++depth;
+        auto _base = base;
+        auto _self = self;
+        auto _byName = byName;
+        while(true){
+            // everything declared from here on (locals and parameters bound by name) is undone once the call is over
+            auto mark = toPop.size();
+            if(!callee -> resolved){
+                // The block still refers to its parameters by name
+                // so they shadow any global variable with the same identifier until the call is over
+                for (int i = 0; i < callee -> parameters.size(); ++i){
+                    const auto& parameter = callee -> parameters.at(i);
+                    const auto& argument = frames.at(frame + i);
+                    variableTable.insert(interpreter::Variable<interpreter::Value>(parameter.second, parameter.first, argument.isArray(), argument, lineNumber));
+                    toPop.emplace_back(interpreter::Popable(parameter.second, parameter.first));
+                }
             }
+
+            // Ok so now we have the arguments, so we can call the actual function to run
+            base = frame;
+            self = receiver;
+            byName = !callee -> resolved;
+            callee -> functionBlock -> accept(this);
+            // the return (if any) stops here
+            returning = false;
+            // the parameters and locals go out of scope
+            pop(mark);
+            if(tail == nullptr)
+                break;
+
+            // The call returned in tail position runs in this frame, its arguments take the place of the parameters
+            auto next = tail;
+            tail = nullptr;
+            auto arguments = next -> parameters.size();
+            for(std::size_t i = 0; i < arguments; ++i)
+                frames[frame + i] = std::move(frames[frames.size() - arguments + i]);
+            frames.resize(frame + arguments);
+            auto nextID = next -> identifier.get();
+            callee = resolve(nextID, nextID, frame, next -> callee, receiver, next -> method, next -> lineNumber);
+            if(receiver == nullptr && jit.run(callee, frames, frame, depth, current))
+                break;
         }
-        // Ok so now we have updated the arguments, so we can call the actual function to run
-        function = true;
-
-        if(!sFunctionCallNode->identifier->isEmpty()){
-            auto parent = parser::ASTIdentifierNode(sFunctionCallNode->identifier->identifier, sFunctionCallNode->identifier->getChild(), sFunctionCallNode->identifier->ilocExprNode, sFunctionCallNode->identifier->lineNumber);
-            auto child = parent.getChild();
-            structID = "";
-            while(child != nullptr){
-                structID += sFunctionCallNode->identifier->identifier;
-                parent = parser::ASTIdentifierNode(child);
-                child = child->getChild();
-            }
+        jit.leave(depth);
+        --depth;
+        base = _base;
+        self = _self;
+        byName = _byName;
+        // the frame goes out of scope
+        frames.resize(frame);
+    }
+
+    void Interpreter::visit(parser::ASTSpawnNode *spawnNode) {
+        auto callNode = spawnNode -> call.get();
+        // The arguments are evaluated here, before the task starts
+        std::size_t frame = frames.size();
+        for (const auto& param : callNode -> parameters){
+            param -> accept(this);
+            frames.emplace_back(std::move(current));
+        }
+        interpreter::Value* receiver = nullptr;
+        auto callee = resolve(callNode -> identifier.get(), callNode -> identifier.get(), frame, callNode -> callee, receiver,
+                              callNode -> method, callNode -> lineNumber);
+        std::vector<interpreter::Value> arguments(std::make_move_iterator(frames.begin() + (std::ptrdiff_t) frame),
+                                                  std::make_move_iterator(frames.end()));
+        frames.resize(frame);
+
+        // The task gets an interpreter of its own with the functions, structs and globals declared so far
+        // every global is given the value it has outside of the active calls (the outermost one)
+        auto job = std::make_shared<interpreter::Job>();
+        job -> interpreter = std::make_unique<Interpreter>(capacity, relaxed, job -> output);
+        auto& task = *job -> interpreter;
+        task.functionTable = functionTable;
+        task.structTable = structTable;
+        for(const auto& [identifier, variable] : variableTable.self){
+            const auto& value = variable.values.empty() ? variable.latestValue : variable.values.front();
+            task.variableTable.insert(interpreter::Variable<interpreter::Value>(value.type(), identifier, value.isArray(), value, variable.lineNumber));
+        }
+        job -> task = interpreter::perform(&task, callee, std::move(arguments));
+
+        // tasks that have been awaited are over, only their handles (if any) keep them
+        std::erase_if(spawned, [](const std::shared_ptr<interpreter::Job>& j){ return j -> flushed.load(); });
+        spawned.emplace_back(job);
+        currentType = "task<" + callee -> type + ">";
+        current = interpreter::Handle{std::move(job), currentType};
+        currentID = "";
+        array = false;
+    }
+
+    void Interpreter::visit(parser::ASTAwaitNode *awaitNode) {
+        awaitNode -> exprNode -> accept(this);
+        // the handle stays alive while it is awaited even if current is overwritten
+        auto job = std::get<interpreter::Handle>(current).job;
+        current = await(*job);
+        currentType = current.type();
+        currentID = "";
+        array = current.isArray();
+        iloc = -1;
+    }
+
+    interpreter::Value Interpreter::invoke(parser::ASTFunctionDeclarationNode *callee, interpreter::Value *arguments, std::size_t count) {
+        std::size_t frame = frames.size();
+        auto mark = toPop.size();
+        auto _depth = depth;
+        auto _base = base;
+        auto _self = self;
+        auto _byName = byName;
+        for(std::size_t i = 0; i < count; ++i)
+            frames.emplace_back(std::move(arguments[i]));
+        try{
+            enter(callee -> identifier.get(), callee, frame, nullptr, callee -> lineNumber);
+            settle();
+        }catch(...){
+            // What the failed call left behind is undone so that the interpreter can be called again
+            // its pending tasks are waited for and dropped
+            pop(mark);
+            frames.resize(frame);
+            depth = _depth;
+            jit.leave(depth + 1);
+            base = _base;
+            self = _self;
+            byName = _byName;
+            returning = false;
+            tail = nullptr;
+            spawned.clear();
+            throw;
         }
+        return std::move(current);
+    }
 
-        f.blockNode -> accept(this);
-        function = false;
+    parser::ASTFunctionDeclarationNode* Interpreter::declaration(const std::string &identifier, const std::vector<std::string> &paramTypes) {
+        auto result = functionTable.find(std::make_pair(identifier, paramTypes));
+        return result != functionTable.end() ? result -> second.declaration : nullptr;
+    }
+
+    const interpreter::Value* Interpreter::global(const std::string &identifier) const {
+        auto result = variableTable.self.find(identifier);
+        if(result == variableTable.self.end())
+            return nullptr;
+        // the value outside of the active calls
+        const auto& variable = result -> second;
+        return variable.values.empty() ? &variable.latestValue : &variable.values.front();
+    }
+
+    interpreter::Value Interpreter::await(interpreter::Job &job) {
+        job.task.wait();
+        if(!job.flushed.exchange(true))
+            out << job.output.str();
+        auto result = job.task.get();
+        adopt(result);
+        return result;
+    }
+
+    void Interpreter::settle() {
+        // awaited in spawn order, the first task that failed stops the rest from being written out
+        auto pending = std::move(spawned);
+        spawned.clear();
+        for(const auto& job : pending)
+            await(*job);
+    }
+
+    void Interpreter::adopt(interpreter::Value &value) {
+        if(value.tag() != interpreter::Value::RECORD)
+            return;
+        auto& record = std::get<interpreter::Record>(value);
+        auto layout = structTable.find(record.layout -> id);
+        if(layout != structTable.end())
+            record.layout = &layout -> second;
+        for(auto& field : record.fields)
+            adopt(field);
     }
 
     void Interpreter::visit(parser::ASTDeclarationNode *declarationNode) {
@@ -928,318 +746,96 @@ namespace visitor {
         // a variable with identifier as provided to exist
         // instead we directly assign the variable when the interpreter::Variable is created
 //        declarationNode -> identifier -> accept(this);
+        std::string id = declarationNode -> identifier -> getID();
 
         // Visit the expression to get the current Type and Current Id
         if(declarationNode->exprNode != nullptr){
+            // by changing the current type we help to init an array literal
+            currentType = declarationNode -> type;
             declarationNode->exprNode->accept(this);
         }else{
             // array declaration case
             if(declarationNode->identifier->ilocExprNode != nullptr){
                 // get array size
+                int elements = index(declarationNode->identifier.get());
                 currentType = declarationNode -> type;
-                auto _cType = currentType;
-                declarationNode->identifier->ilocExprNode->accept(this);
-                int size;
-                if(currentType == "int"){
-                    size = intTable.get(currentID).latestValue;
-                }else if(currentType == "float"){
-                    size = floatTable.get(currentID).latestValue;
-                }else{
-                    throw std::runtime_error("Variable with identifier " + declarationNode->identifier->getID() + " called on line "
-                                             + std::to_string(declarationNode->lineNumber) + " has not incorrect value between [].");
-                }
-                currentType = _cType;
-                // amend array
-                if(currentType == "int"){
-                    intArrayTable.insert (
-                            interpreter::Variable<std::vector<int>>(currentType, structID + declarationNode -> identifier -> getID(),
-                                                                    true, std::vector<int>(size), declarationNode -> lineNumber)
-                    );
-                }else if(currentType == "float"){
-                    floatArrayTable.insert (
-                            interpreter::Variable<std::vector<float>>(currentType, structID + declarationNode -> identifier -> getID(),
-                                                         true, std::vector<float>(size), declarationNode -> lineNumber)
-                    );
-                }else if(currentType == "bool"){
-                    boolArrayTable.insert (
-                            interpreter::Variable<std::vector<bool>>(currentType, structID + declarationNode -> identifier -> getID(),
-                                                        true, std::vector<bool>(size), declarationNode -> lineNumber)
-                    );
-                }else if(currentType == "string"){
-                    stringArrayTable.insert (
-                            interpreter::Variable<std::vector<std::string>>(currentType, structID + declarationNode -> identifier -> getID(),
-                                                               true, std::vector<std::string>(size), declarationNode -> lineNumber)
-                    );
-                }else if(currentType == "char"){
-                    charArrayTable.insert (
-                            interpreter::Variable<std::vector<char>>(currentType, structID + declarationNode -> identifier -> getID(),
-                                                        true, std::vector<char>(size), declarationNode -> lineNumber)
-                    );
-                }
-                if(function){
-                    toPop.emplace_back(interpreter::Popable(currentType, structID + declarationNode -> identifier -> getID(), true));
+                // nothing is stored for arrays of structs
+                if(!lexer::isStruct(currentType)){
+                    variableTable.insert(interpreter::Variable<interpreter::Value>(currentType, id, true, interpreter::Value::array(currentType, elements), declarationNode -> lineNumber));
+                    toPop.emplace_back(interpreter::Popable(currentType, id));
                 }
+                array = false;
                 return;
             }else{
                 // struct case
-                // find struct build
-                // insert new struct variable
-                // ignore self
-                if(declarationNode -> identifier -> getID() != "self") {
-                    structID = declarationNode->identifier->getID() + ".";
-                    listOfStructs.emplace_back(declarationNode->identifier->getID());
-                    struct_variable.insert(std::make_pair(declarationNode->identifier->getID(), declarationNode->type));
-                    structTable.find(declarationNode->type)->second.structNode->accept(this);
-                    structID = "";
-                }
-                return;
+                // a new instance with its fields initialised (see interpreter::Struct::constant)
+                currentType = declarationNode -> type;
+                current = instantiate(structTable.find(currentType) -> second);
             }
         }
 
         // Now we have an updated current type and id
         // Create a variable with this information
-
-        // Insert the new variable
-
-        if(currentType == "int"){
-            array ? intArrayTable.insert (
-                    interpreter::Variable<std::vector<int>>(currentType, structID + declarationNode -> identifier -> getID(), true, intArrayTable.get(currentID).latestValue, declarationNode -> lineNumber)
-            )
-            :
-            intTable.insert (
-                    interpreter::Variable<int>(currentType, structID + declarationNode -> identifier -> getID(), false, intTable.get(currentID).latestValue, declarationNode -> lineNumber)
-            );
-        }else if(currentType == "float"){
-            array ? floatArrayTable.insert (
-                    interpreter::Variable<std::vector<float>>(currentType, structID + declarationNode -> identifier -> getID(), true, floatArrayTable.get(currentID).latestValue, declarationNode -> lineNumber)
-            )
-            :
-            floatTable.insert (
-                    interpreter::Variable<float>(currentType, structID + declarationNode -> identifier -> getID(), false, floatTable.get(currentID).latestValue, declarationNode -> lineNumber)
-            );
-        }else if(currentType == "bool"){
-            array ? boolArrayTable.insert (
-                    interpreter::Variable<std::vector<bool>>(currentType, structID + declarationNode -> identifier -> getID(), true, boolArrayTable.get(currentID).latestValue, declarationNode -> lineNumber)
-            )
-            :
-            boolTable.insert (
-                    interpreter::Variable<bool>(currentType, structID + declarationNode -> identifier -> getID(), false, boolTable.get(currentID).latestValue, declarationNode -> lineNumber)
-            );
-        }else if(currentType == "string"){
-            array ? stringArrayTable.insert (
-                    interpreter::Variable<std::vector<std::string>>(currentType, structID + declarationNode -> identifier -> getID(), true, stringArrayTable.get(currentID).latestValue, declarationNode -> lineNumber)
-            )
-            :
-            stringTable.insert (
-                    interpreter::Variable<std::string>(currentType, structID + declarationNode -> identifier -> getID(), false, stringTable.get(currentID).latestValue, declarationNode -> lineNumber)
-            );
-        }else if(currentType == "char"){
-            array ? charArrayTable.insert (
-                    interpreter::Variable<std::vector<char>>(currentType, structID + declarationNode -> identifier -> getID(), true, charArrayTable.get(currentID).latestValue, declarationNode -> lineNumber)
-            )
-            :
-            charTable.insert (
-                    interpreter::Variable<char>(currentType, structID + declarationNode -> identifier -> getID(), false, charTable.get(currentID).latestValue, declarationNode -> lineNumber)
-            );
-        }
-
-        if(function){
-            toPop.emplace_back(interpreter::Popable(currentType, structID + declarationNode -> identifier -> getID(), array));
+        // nothing is stored for arrays of structs
+        if(!currentType.empty()){
+            bool isArray = current.isArray();
+            variableTable.insert(interpreter::Variable<interpreter::Value>(currentType, id, isArray, std::move(current), declarationNode -> lineNumber));
+            toPop.emplace_back(interpreter::Popable(currentType, id));
         }
         array = false;
     }
 
     void Interpreter::visit(parser::ASTAssignmentNode *assignmentNode) {
-        // We visit the identifier node now as we expect the variable to exist
-        assignmentNode -> identifier -> accept(this);
-        // We can update the type and identifier local variables
-        // These two variables define the found variable
-        std::string type = currentType;
-        std::string id = currentID;
-        // the array variable will also tell us if an array is being accessed right now
-        bool accessing_array = array;
         // Visit the expression to get the current Type and Current Id
         array = false;
         assignmentNode -> exprNode -> accept(this);
-        bool assigning_array = array;
-        // Now we have an updated current type and id
-        // These two variables define what we will give id
-        // Replace the variable value
-        // Replacement can be done by popping then inserting
-
-        // accessing_array assignment cases
-
-        if(accessing_array){
-//            if(assignmentNode->identifier->ilocExprNode != nullptr) {
-                // get array iloc
-//                assignmentNode->identifier->ilocExprNode->accept(this);
-                if(currentType == "int"){
-                    auto result = intArrayTable.find(interpreter::Variable<std::vector<int>>(id));
-                    if(!intArrayTable.found(result)){
-                        throw std::runtime_error("Failed to find variable with identifier " + id);
-                    }
-                    std::vector<int> cpy = (result -> second.values)[0];
-                    cpy[iloc] = intTable.get(currentID).latestValue;
-                    // remove the old array
-                    intArrayTable.pop_back(id);
-                    // insert the copy
-                    intArrayTable.insert (
-                            interpreter::Variable<std::vector<int>>(type, id, false, cpy, assignmentNode -> lineNumber)
-                    );
-                }else if(currentType == "float"){
-                    auto result = floatArrayTable.find(interpreter::Variable<std::vector<float>>(id));
-                    if(!floatArrayTable.found(result)){
-                        throw std::runtime_error("Failed to find variable with identifier " + id);
-                    }
-                    std::vector<float> cpy = (result -> second.values)[0];
-                    cpy[iloc] = floatTable.get(currentID).latestValue;
-                    // remove the old array
-                    floatArrayTable.pop_back(id);
-                    // insert the copy
-                    floatArrayTable.insert (
-                            interpreter::Variable<std::vector<float>>(type, id, false, cpy, assignmentNode -> lineNumber)
-                    );
-                }else if(currentType == "bool"){
-                    auto result = boolArrayTable.find(interpreter::Variable<std::vector<bool>>(id));
-                    if(!boolArrayTable.found(result)){
-                        throw std::runtime_error("Failed to find variable with identifier " + id);
-                    }
-                    std::vector<bool> cpy = (result -> second.values)[0];
-                    cpy[iloc] = boolTable.get(currentID).latestValue;
-                    // remove the old array
-                    boolArrayTable.pop_back(id);
-                    // insert the copy
-                    boolArrayTable.insert (
-                            interpreter::Variable<std::vector<bool>>(type, id, false, cpy, assignmentNode -> lineNumber)
-                    );
-                }else if(currentType == "string"){
-                    auto result = stringArrayTable.find(interpreter::Variable<std::vector<std::string>>(id));
-                    if(!stringArrayTable.found(result)){
-                        throw std::runtime_error("Failed to find variable with identifier " + id);
-                    }
-                    std::vector<std::string> cpy = (result -> second.values)[0];
-                    cpy[iloc] = stringTable.get(currentID).latestValue;
-                    // remove the old array
-                    stringArrayTable.pop_back(id);
-                    // insert the copy
-                    stringArrayTable.pop_back(id);
-                    stringArrayTable.insert (
-                            interpreter::Variable<std::vector<std::string>>(type, id, false, cpy, assignmentNode -> lineNumber)
-                    );
-                }else if(currentType == "char"){
-                    auto result = charArrayTable.find(interpreter::Variable<std::vector<char>>(id));
-                    if(!charArrayTable.found(result)){
-                        throw std::runtime_error("Failed to find variable with identifier " + id);
-                    }
-                    std::vector<char> cpy = (result -> second.values)[0];
-                    cpy[iloc] = charTable.get(currentID).latestValue;
-                    // remove the old array
-                    charArrayTable.pop_back(id);
-                    // insert the copy
-                    charArrayTable.insert (
-                            interpreter::Variable<std::vector<char>>(type, id, false, cpy, assignmentNode -> lineNumber)
-                    );
-                }
-                if(function){
-                    toPop.emplace_back(interpreter::Popable(currentType, id, true));
-                }
-                array = false;
-                return;
-            }
-//        }
-
-        // assigning_array cases
-
-        if(assigning_array){
-            if(currentType == "int"){
-                intArrayTable.insert (
-                        interpreter::Variable<std::vector<int>>(currentType, id, true, intArrayTable.get(currentID).latestValue, assignmentNode -> lineNumber)
-                );
-            }else if(currentType == "float"){
-                floatArrayTable.insert (
-                        interpreter::Variable<std::vector<float>>(currentType, id, true, floatArrayTable.get(currentID).latestValue, assignmentNode -> lineNumber)
-                );
-            }else if(currentType == "bool"){
-                boolArrayTable.insert (
-                        interpreter::Variable<std::vector<bool>>(currentType, id, true, boolArrayTable.get(currentID).latestValue, assignmentNode -> lineNumber)
-                );
-            }else if(currentType == "string"){
-                stringArrayTable.insert (
-                        interpreter::Variable<std::vector<std::string>>(currentType, id, true, stringArrayTable.get(currentID).latestValue, assignmentNode -> lineNumber)
-                );
-            }else if(currentType == "char array"){
-                charArrayTable.insert (
-                        interpreter::Variable<std::vector<char>>(currentType, id, true, charArrayTable.get(currentID).latestValue, assignmentNode -> lineNumber)
-                );
-            }
-            if(function){
-                toPop.emplace_back(interpreter::Popable(currentType, id, true));
-            }
+        // nothing is stored for arrays of structs
+        if(currentType.empty()){
             array = false;
             return;
         }
-
-        // Normal variable cases
-        if(currentType == "int"){
-            intTable.pop_back(id);
-            intTable.insert (
-                    interpreter::Variable<int>(type, id, false, intTable.get(currentID).latestValue, assignmentNode -> lineNumber)
-            );
-        }else if(currentType == "float"){
-            floatTable.pop_back(id);
-            floatTable.insert (
-                    interpreter::Variable<float>(type, id, false, floatTable.get(currentID).latestValue, assignmentNode -> lineNumber)
-            );
-        }else if(currentType == "bool"){
-            boolTable.pop_back(id);
-            boolTable.insert (
-                    interpreter::Variable<bool>(type, id, false, boolTable.get(currentID).latestValue, assignmentNode -> lineNumber)
-            );
-        }else if(currentType == "string"){
-            stringTable.pop_back(id);
-            stringTable.insert (
-                    interpreter::Variable<std::string>(type, id, false, stringTable.get(currentID).latestValue, assignmentNode -> lineNumber)
-            );
-        }else if(currentType == "char"){
-            charTable.pop_back(id);
-            charTable.insert (
-                    interpreter::Variable<char>(type, id, false, charTable.get(currentID).latestValue, assignmentNode -> lineNumber)
-            );
-        }
-        if(function){
-            toPop.emplace_back(interpreter::Popable(currentType, id, false));
+        auto value = std::move(current);
+        // The identifier is located once the value is known so that the expression cannot move it
+        auto v = locate(assignmentNode -> identifier.get());
+        if(v == nullptr){
+            array = false;
+            return;
         }
+        // Update the value in place
+        // an array element is being accessed right now
+        if(v -> isArray() && iloc >= 0)
+            v -> set(iloc, value);
+        else
+            *v = std::move(value);
+        array = false;
     }
 
     void Interpreter::visit(parser::ASTPrintNode *printNode) {
         // Visit expression node to get current type
-        structID = "";
         printNode -> exprNode -> accept(this);
-        if(currentType == "int"){
-            std::cout << (array ? intArrayTable.get(currentID).latestValue.at(iloc) : intTable.get(currentID).latestValue) << std::endl;
-        }else if(currentType == "float"){
-            std::cout << (array ? floatArrayTable.get(currentID).latestValue.at(iloc) : floatTable.get(currentID).latestValue) << std::endl;
-        }else if(currentType == "bool"){
-            std::cout << ((array ? boolArrayTable.get(currentID).latestValue.at(iloc) : boolTable.get(currentID).latestValue) ? "true" : "false") << std::endl;
-        }else if(currentType == "string"){
-            std::cout << (array ? stringArrayTable.get(currentID).latestValue.at(iloc) : stringTable.get(currentID).latestValue) << std::endl;
-        }else if(currentType == "char"){
-            std::cout << (array ? charArrayTable.get(currentID).latestValue.at(iloc) : charTable.get(currentID).latestValue) << std::endl;
+        // nothing is stored for struct values
+        if(!lexer::isStruct(currentType)){
+            out << current << std::endl;
         }
         array = false;
     }
 
     void Interpreter::visit(parser::ASTBlockNode *blockNode) {
-        // Visit each statement in the block
-        for(auto &statement : blockNode -> statements)
+        auto mark = toPop.size();
+        // Visit each statement in the block, stopping at a return
+        for(auto &statement : blockNode -> statements){
             statement -> accept(this);
+            if(returning) break;
+        }
+        // the block's declarations go out of scope
+        pop(mark);
     }
 
     void Interpreter::visit(parser::ASTIfNode *ifNode) {
         // Get the condition
         ifNode -> condition -> accept(this);
         // follow the if structure
-        if(boolTable.get(currentID).latestValue){
+        if(std::get<bool>(current)){
             // do the if block
             ifNode -> ifBlock -> accept(this);
         }else{
@@ -1250,15 +846,22 @@ namespace visitor {
     }
 
     void Interpreter::visit(parser::ASTForNode *forNode) {
+        // the loop variable only lives as long as the loop
+        auto mark = toPop.size();
         // Get the declaration
         if(forNode -> declaration != nullptr)
             forNode -> declaration -> accept(this);
+        if(counted(forNode)){
+            pop(mark);
+            return;
+        }
         // Get the condition
         forNode -> condition -> accept(this);
 
-        while(boolTable.get(currentID).latestValue){
+        while(std::get<bool>(current)){
             // do the loop block
             forNode -> loopBlock -> accept(this);
+            if(returning) break;
 
             // Now go over the assignment
             if(forNode -> assignment != nullptr)
@@ -1266,212 +869,454 @@ namespace visitor {
             // Get the condition again
             forNode -> condition -> accept(this);
         }
+        pop(mark);
+    }
+
+    // The identifier when an expression is a variable on its own (no member, no element)
+    static parser::ASTIdentifierNode* plain(parser::ASTExprNode* exprNode) {
+        auto identifierNode = dynamic_cast<parser::ASTIdentifierNode*>(exprNode);
+        if(identifierNode == nullptr || identifierNode -> ilocExprNode != nullptr
+           || (identifierNode -> getChild() != nullptr && !identifierNode -> getChild() -> isEmpty()))
+            return nullptr;
+        return identifierNode;
+    }
+
+    // The value of an int or float literal of type T
+    template <typename T>
+    static bool literal(parser::ASTExprNode* exprNode, T& value) {
+        auto literalNode = dynamic_cast<parser::ASTLiteralNode<T>*>(exprNode);
+        if(literalNode == nullptr)
+            return false;
+        value = literalNode -> val;
+        return true;
+    }
+
+    // The elements [from, to) a loop goes through when its variable starts at start and is stepped by 1 while it is op last
+    // false if the loop does not stop or counts past what T holds exactly
+    template <typename T>
+    static bool range(T start, lexer::OPERATOR op, T last, int& from, int& to) {
+        constexpr double largest = std::is_same_v<T, int> ? INT_MAX - 1.0 : 16777216.0;
+        double first = start, end = last;
+        if(std::isnan(end) || first != std::floor(first) || std::fabs(first) > largest || std::fabs(end) > largest)
+            return false;
+        switch (op) {
+            case lexer::OP_LT:
+                end = std::ceil(end);
+                break;
+            case lexer::OP_LE:
+                end = std::floor(end) + 1;
+                break;
+            case lexer::OP_NE:
+                if(end != std::floor(end) || end < first)
+                    return false;
+                break;
+            default:
+                return false;
+        }
+        from = (int) first;
+        to = (int) std::max(first, end);
+        return true;
+    }
+
+    bool Interpreter::stable(parser::ASTIdentifierNode *identifierNode, const interpreter::Value *v) {
+        if(identifierNode -> slot >= 0)
+            return true;
+        auto entry = variableTable.find(identifierNode -> identifier);
+        return variableTable.found(entry) && &entry -> second.latestValue == v;
+    }
+
+    bool Interpreter::comparison(parser::ASTExprNode *exprNode, const interpreter::Value *variable, lexer::OPERATOR &op,
+                                 parser::ASTExprNode *&limit, const interpreter::Value *&bound) {
+        auto isVariable = [this, variable](parser::ASTExprNode* exprNode){
+            auto identifierNode = plain(exprNode);
+            return identifierNode != nullptr && locate(identifierNode) == variable;
+        };
+        auto condition = dynamic_cast<parser::ASTBinaryNode*>(exprNode);
+        if(condition == nullptr)
+            return false;
+        op = condition -> kind;
+        if(op != lexer::OP_LT && op != lexer::OP_GT && op != lexer::OP_LE && op != lexer::OP_GE && op != lexer::OP_NE)
+            return false;
+        if(isVariable(condition -> left.get())){
+            limit = condition -> right.get();
+        }else if(isVariable(condition -> right.get())){
+            limit = condition -> left.get();
+            op = op == lexer::OP_LT ? lexer::OP_GT : op == lexer::OP_GT ? lexer::OP_LT
+               : op == lexer::OP_LE ? lexer::OP_GE : op == lexer::OP_GE ? lexer::OP_LE : op;
+        }else{
+            return false;
+        }
+        bound = nullptr;
+        auto boundNode = plain(limit);
+        if(boundNode != nullptr){
+            bound = locate(boundNode);
+            if(bound == nullptr || bound == variable || bound -> tag() != variable -> tag() || !stable(boundNode, bound))
+                return false;
+        }
+        return true;
+    }
+
+    bool Interpreter::step(parser::ASTAssignmentNode *assignmentNode, const interpreter::Value *variable, parser::ASTExprNode *&by, bool &down) {
+        auto isVariable = [this, variable](parser::ASTExprNode* exprNode){
+            auto identifierNode = plain(exprNode);
+            return identifierNode != nullptr && locate(identifierNode) == variable;
+        };
+        if(!isVariable(assignmentNode -> identifier.get()))
+            return false;
+        auto stepNode = dynamic_cast<parser::ASTBinaryNode*>(assignmentNode -> exprNode.get());
+        if(stepNode == nullptr || (stepNode -> kind != lexer::OP_ADD && stepNode -> kind != lexer::OP_SUB))
+            return false;
+        if(isVariable(stepNode -> left.get()))
+            by = stepNode -> right.get();
+        else if(stepNode -> kind == lexer::OP_ADD && isVariable(stepNode -> right.get()))
+            by = stepNode -> left.get();
+        else
+            return false;
+        down = stepNode -> kind == lexer::OP_SUB;
+        return true;
+    }
+
+    bool Interpreter::counted(parser::ASTForNode *forNode) {
+        if(forNode -> declaration == nullptr || forNode -> assignment == nullptr)
+            return false;
+        // The loop variable, it stays where it is for as long as the loop runs
+        auto declared = variableTable.find(forNode -> declaration -> identifier -> getID());
+        if(!variableTable.found(declared))
+            return false;
+        auto variable = &declared -> second.latestValue;
+        auto tag = variable -> tag();
+        if(tag != interpreter::Value::INT && tag != interpreter::Value::FLOAT)
+            return false;
+
+        // i op bound (or bound op i), the bound is a literal or a variable that is read in place
+        // i = i + step, i = step + i or i = i - step
+        lexer::OPERATOR op;
+        parser::ASTExprNode* limit;
+        const interpreter::Value* bound;
+        parser::ASTExprNode* by;
+        bool down;
+        if(!comparison(forNode -> condition.get(), variable, op, limit, bound) || !step(forNode -> assignment.get(), variable, by, down))
+            return false;
+
+        if(tag == interpreter::Value::INT){
+            int last = 0, increment = 0;
+            if((bound == nullptr && !literal(limit, last)) || !literal(by, increment))
+                return false;
+            count<int>(forNode, *variable, op, bound, last, down, increment);
+        }else{
+            float last = 0, increment = 0;
+            if((bound == nullptr && !literal(limit, last)) || !literal(by, increment))
+                return false;
+            count<float>(forNode, *variable, op, bound, last, down, increment);
+        }
+        return true;
+    }
+
+    template <typename T>
+    void Interpreter::count(parser::ASTForNode *forNode, interpreter::Value &variable, lexer::OPERATOR op, const interpreter::Value *bound,
+                            T limit, bool down, T step) {
+        // a loop over the elements of arrays runs as one kernel
+        int from, to;
+        if(!down && step == 1 && forNode -> loopBlock -> statements.size() == 1
+           && range(std::get<T>(variable), op, bound != nullptr ? std::get<T>(*bound) : limit, from, to)
+           && vectorized(forNode -> loopBlock -> statements.front().get(), &variable, bound, from, to)){
+            std::get<T>(variable) = (T) to;
+            return;
+        }
+        auto holds = [&](){
+            T i = std::get<T>(variable);
+            T b = bound != nullptr ? std::get<T>(*bound) : limit;
+            switch (op) {
+                case lexer::OP_LT: return i < b;
+                case lexer::OP_GT: return i > b;
+                case lexer::OP_LE: return i <= b;
+                case lexer::OP_GE: return i >= b;
+                default: return i != b;
+            }
+        };
+        while(holds()){
+            forNode -> loopBlock -> accept(this);
+            if(returning) break;
+            T& i = std::get<T>(variable);
+            i = down ? i - step : i + step;
+        }
+    }
+
+    bool Interpreter::counted(parser::ASTWhileNode *whileNode) {
+        // while(i op bound){ statement; i = i + 1; }, i was declared before the loop and is left where the loop leaves it
+        const auto& statements = whileNode -> loopBlock -> statements;
+        if(statements.size() != 2)
+            return false;
+        auto increment = dynamic_cast<parser::ASTAssignmentNode*>(statements.back().get());
+        auto name = increment != nullptr ? plain(increment -> identifier.get()) : nullptr;
+        auto variable = name != nullptr ? locate(name) : nullptr;
+        if(variable == nullptr || !stable(name, variable))
+            return false;
+        lexer::OPERATOR op;
+        parser::ASTExprNode* limit;
+        const interpreter::Value* bound;
+        parser::ASTExprNode* by;
+        bool down;
+        if(!comparison(whileNode -> condition.get(), variable, op, limit, bound) || !step(increment, variable, by, down) || down)
+            return false;
+
+        int from, to;
+        if(variable -> tag() == interpreter::Value::INT){
+            int last = 0, one = 0;
+            if((bound == nullptr && !literal(limit, last)) || !literal(by, one) || one != 1
+               || !range(std::get<int>(*variable), op, bound != nullptr ? std::get<int>(*bound) : last, from, to)
+               || !vectorized(statements.front().get(), variable, bound, from, to))
+                return false;
+            *variable = to;
+        }else if(variable -> tag() == interpreter::Value::FLOAT){
+            float last = 0, one = 0;
+            if((bound == nullptr && !literal(limit, last)) || !literal(by, one) || one != 1
+               || !range(std::get<float>(*variable), op, bound != nullptr ? std::get<float>(*bound) : last, from, to)
+               || !vectorized(statements.front().get(), variable, bound, from, to))
+                return false;
+            *variable = (float) to;
+        }else{
+            return false;
+        }
+        return true;
+    }
+
+    interpreter::Value* Interpreter::element(parser::ASTExprNode *exprNode, const interpreter::Value *variable) {
+        auto identifierNode = dynamic_cast<parser::ASTIdentifierNode*>(exprNode);
+        if(identifierNode == nullptr || identifierNode -> ilocExprNode == nullptr
+           || (identifierNode -> getChild() != nullptr && !identifierNode -> getChild() -> isEmpty()))
+            return nullptr;
+        auto index = plain(identifierNode -> ilocExprNode.get());
+        if(index == nullptr || locate(index) != variable)
+            return nullptr;
+        auto array = locate(identifierNode);
+        if(array == nullptr || (array -> tag() != interpreter::Value::INT_ARRAY && array -> tag() != interpreter::Value::FLOAT_ARRAY))
+            return nullptr;
+        return array;
+    }
+
+    bool Interpreter::vectorized(parser::ASTStatementNode *statement, const interpreter::Value *variable, const interpreter::Value *bound,
+                                 int from, int to) {
+        auto size = (std::size_t) (to - from);
+        // every element the loop goes through has to be there, the interpreter fails on the first one that is not
+        auto fits = [from, to, size](const interpreter::Value* array){
+            auto elements = array -> tag() == interpreter::Value::INT_ARRAY ? std::get<interpreter::Array<int>>(*array).size()
+                                                                           : std::get<interpreter::Array<float>>(*array).size();
+            return size == 0 || (from >= 0 && (std::size_t) to <= elements);
+        };
+
+        if(auto ifNode = dynamic_cast<parser::ASTIfNode*>(statement)){
+            // if(a[i] op best){ best = a[i]; } (or best op a[i]) with no else
+            auto condition = dynamic_cast<parser::ASTBinaryNode*>(ifNode -> condition.get());
+            if(condition == nullptr || ifNode -> elseBlock != nullptr || ifNode -> ifBlock -> statements.size() != 1)
+                return false;
+            auto set = dynamic_cast<parser::ASTAssignmentNode*>(ifNode -> ifBlock -> statements.front().get());
+            auto bestNode = set != nullptr ? plain(set -> identifier.get()) : nullptr;
+            auto best = bestNode != nullptr ? locate(bestNode) : nullptr;
+            auto array = set != nullptr ? element(set -> exprNode.get(), variable) : nullptr;
+            if(best == nullptr || best == variable || best == bound || array == nullptr || !fits(array))
+                return false;
+            auto isBest = [this, best](parser::ASTExprNode* exprNode){
+                auto identifierNode = plain(exprNode);
+                return identifierNode != nullptr && locate(identifierNode) == best;
+            };
+            auto op = condition -> kind;
+            if(op != lexer::OP_LT && op != lexer::OP_GT && op != lexer::OP_LE && op != lexer::OP_GE)
+                return false;
+            if(!(element(condition -> left.get(), variable) == array && isBest(condition -> right.get()))){
+                if(!(isBest(condition -> left.get()) && element(condition -> right.get(), variable) == array))
+                    return false;
+                op = op == lexer::OP_LT ? lexer::OP_GT : op == lexer::OP_GT ? lexer::OP_LT : op == lexer::OP_LE ? lexer::OP_GE : lexer::OP_LE;
+            }
+            auto run = [&](auto zero){
+                using T = decltype(zero);
+                const T* elements = std::get<interpreter::Array<T>>(*array).read().data() + from;
+                auto index = simd::select(op, elements, size, std::get<T>(*best));
+                if(index < size)
+                    *best = elements[index];
+                return true;
+            };
+            if(best -> tag() == interpreter::Value::INT && array -> tag() == interpreter::Value::INT_ARRAY)
+                return run(0);
+            if(best -> tag() == interpreter::Value::FLOAT && array -> tag() == interpreter::Value::FLOAT_ARRAY)
+                return run(0.0f);
+            return false;
+        }
+
+        auto assignmentNode = dynamic_cast<parser::ASTAssignmentNode*>(statement);
+        auto expression = assignmentNode != nullptr ? dynamic_cast<parser::ASTBinaryNode*>(assignmentNode -> exprNode.get()) : nullptr;
+        if(expression == nullptr)
+            return false;
+
+        if(auto totalNode = plain(assignmentNode -> identifier.get())){
+            // total = total + a[i] (or a[i] + total)
+            auto total = locate(totalNode);
+            if(total == nullptr || total == variable || total == bound || expression -> kind != lexer::OP_ADD)
+                return false;
+            auto isTotal = [this, total](parser::ASTExprNode* exprNode){
+                auto identifierNode = plain(exprNode);
+                return identifierNode != nullptr && locate(identifierNode) == total;
+            };
+            const interpreter::Value* array = nullptr;
+            if(isTotal(expression -> left.get()))
+                array = element(expression -> right.get(), variable);
+            else if(isTotal(expression -> right.get()))
+                array = element(expression -> left.get(), variable);
+            if(array == nullptr || !fits(array))
+                return false;
+            if(total -> tag() == interpreter::Value::INT && array -> tag() == interpreter::Value::INT_ARRAY)
+                *total = simd::sum(std::get<interpreter::Array<int>>(*array).read().data() + from, size, std::get<int>(*total));
+            else if(total -> tag() == interpreter::Value::FLOAT && array -> tag() == interpreter::Value::FLOAT_ARRAY)
+                *total = simd::sum(std::get<interpreter::Array<float>>(*array).read().data() + from, size, std::get<float>(*total), relaxed);
+            else
+                return false;
+            return true;
+        }
+
+        // a[i] = left op right, each operand is an element of an array (b[i]) or a scalar
+        auto out = element(assignmentNode -> identifier.get(), variable);
+        if(out == nullptr || !fits(out))
+            return false;
+        auto op = expression -> kind;
+        bool floats = out -> tag() == interpreter::Value::FLOAT_ARRAY;
+        if(op != lexer::OP_ADD && op != lexer::OP_SUB && op != lexer::OP_MUL && !(floats && op == lexer::OP_DIV))
+            return false;
+        auto run = [&](auto zero){
+            using T = decltype(zero);
+            auto tag = floats ? interpreter::Value::FLOAT : interpreter::Value::INT;
+            // the arrays are only read once the elements of out are its own
+            const interpreter::Value* arrays[2] = {nullptr, nullptr};
+            simd::Operand<T> operands[2] = {{nullptr, zero}, {nullptr, zero}};
+            parser::ASTExprNode* nodes[2] = {expression -> left.get(), expression -> right.get()};
+            for(int k = 0; k < 2; ++k){
+                if((arrays[k] = element(nodes[k], variable)) != nullptr){
+                    if(arrays[k] -> tag() != out -> tag() || !fits(arrays[k]))
+                        return false;
+                }else if(!literal(nodes[k], operands[k].scalar)){
+                    auto scalarNode = plain(nodes[k]);
+                    auto scalar = scalarNode != nullptr ? locate(scalarNode) : nullptr;
+                    if(scalar == nullptr || scalar == variable || scalar -> tag() != tag)
+                        return false;
+                    operands[k].scalar = std::get<T>(*scalar);
+                }
+            }
+            if(size == 0)
+                return true;
+            T* elements = std::get<interpreter::Array<T>>(*out).write().data() + from;
+            for(int k = 0; k < 2; ++k)
+                if(arrays[k] != nullptr)
+                    operands[k].elements = std::get<interpreter::Array<T>>(*arrays[k]).read().data() + from;
+            simd::map(op, elements, operands[0], operands[1], size);
+            return true;
+        };
+        return floats ? run(0.0f) : run(0);
     }
 
     void Interpreter::visit(parser::ASTWhileNode *whileNode) {
+        if(counted(whileNode))
+            return;
         // Get the condition
         whileNode -> condition -> accept(this);
 
-        while(boolTable.get(currentID).latestValue){
+        while(std::get<bool>(current)){
             // do the loop block
             whileNode -> loopBlock -> accept(this);
+            if(returning) break;
 
             // Get the condition again
             whileNode -> condition -> accept(this);
         }
     }
-
     void Interpreter::visit(parser::ASTFunctionDeclarationNode *functionDeclarationNode) {
         // We dont visit the identifier as this would produce an error as the interpreter expects
         // a variable with identifier as provided to exist
         // instead we directly assign the variable when the interpreter::Variable is created
         // functionDeclarationNode -> identifier -> accept(this);
-        // Split the params into two vectors
+        // Get the param types
 
         std::vector<std::string> paramTypes;
-        std::vector<std::string> paramIDs;
-        for (auto & parameter : functionDeclarationNode->parameters){
+        for (auto & parameter : functionDeclarationNode->parameters)
             paramTypes.emplace_back(parameter.second);
-            paramIDs.emplace_back(parameter.first);
-        }
 
         // Insert the new function
         insert (
                 interpreter::Function(functionDeclarationNode->type,
-                                      structID + functionDeclarationNode -> identifier -> getID(),
-                                      paramTypes, paramIDs,functionDeclarationNode->functionBlock,
+                                      functionDeclarationNode -> identifier -> getID(),
+                                      paramTypes, functionDeclarationNode,
                                       functionDeclarationNode -> lineNumber)
         );
     }
 
     void Interpreter::visit(parser::ASTReturnNode *returnNode) {
+        // A call to a function (not to a method of another instance) in tail position is run by the enclosing call
+        // once this one is over, so that recursing through it does not nest
+        auto callNode = depth > 0 ? dynamic_cast<parser::ASTFunctionCallNode*>(returnNode -> exprNode.get()) : nullptr;
+        if(callNode != nullptr && (callNode -> identifier -> getChild() == nullptr || callNode -> identifier -> getChild() -> isEmpty())){
+            for (const auto& param : callNode -> parameters){
+                param -> accept(this);
+                frames.emplace_back(std::move(current));
+            }
+            tail = callNode;
+            returning = true;
+            return;
+        }
         // Update current expression
         returnNode -> exprNode -> accept(this);
-        // make sure to not pop_back the returns value
-        auto save = interpreter::Popable(currentType, currentID, array);
-        // Save the return
-        std::vector<interpreter::Popable> struct_saves;
-        if(save.type == "int"){
-            if(!save.array){
-                auto returnVariable = intTable.get(save.id);
-                pop();
-                intTable.pop_back(save.id);
-                intTable.insert(returnVariable);
-            }else{
-                auto returnVariable = intArrayTable.get(save.id);
-                pop();
-                intArrayTable.pop_back(save.id);
-                intArrayTable.insert(returnVariable);
-            }
-        }else if(save.type == "float"){
-            if(!save.array) {
-                auto returnVariable = floatTable.get(save.id);
-                pop();
-                floatTable.pop_back(save.id);
-                floatTable.insert(returnVariable);
-            }else{
-                auto returnVariable = floatArrayTable.get(save.id);
-                pop();
-                floatArrayTable.pop_back(save.id);
-                floatArrayTable.insert(returnVariable);
-            }
-        }else if(save.type == "bool"){
-            if(!save.array){
-                auto returnVariable = boolTable.get(save.id);
-                pop();
-                boolTable.pop_back(save.id);
-                boolTable.insert(returnVariable);
-            }else{
-                auto returnVariable = boolArrayTable.get(save.id);
-                pop();
-                boolArrayTable.pop_back(save.id);
-                boolArrayTable.insert(returnVariable);
-            }
-        }else if(save.type == "string"){
-            if(!save.array){
-                auto returnVariable = stringTable.get(save.id);
-                pop();
-                stringTable.pop_back(save.id);
-                stringTable.insert(returnVariable);
-            }else{
-                auto returnVariable = stringArrayTable.get(save.id);
-                pop();
-                stringArrayTable.pop_back(save.id);
-                stringArrayTable.insert(returnVariable);
-            }
-        }else if(save.type == "char"){
-            if(!save.array){
-                auto returnVariable = charTable.get(save.id);
-                pop();
-                charTable.pop_back(save.id);
-                charTable.insert(returnVariable);
-            }else{
-                auto returnVariable = charArrayTable.get(save.id);
-                pop();
-                charArrayTable.pop_back(save.id);
-                charArrayTable.insert(returnVariable);
-            }
-        }else if(lexer::isStruct(save.type)){
-            // match begin of toPop with save.id + "."
-            bool ok_so_far = false;
-            bool _struct = false;
-            bool fullstop = false;
-            bool unique = true;
-            if(structID.empty() || structID == "self") structID = currentID;
-            // get struct variables
-            for (auto & it : toPop) {
-                for (int i = 0; i < it.id.size(); ++i) {
-                    if (!_struct) {
-                        ok_so_far = (structID.at(i) == it.id.at(i));
-                        _struct = (i == structID.size() - 1);
-                    }
-                    fullstop = '.' == it.id.at(i);
-                    if (fullstop) break;
-                }
-                if (ok_so_far && _struct && fullstop) { // found
-                    // check if has already been placed in struct_saves
-                    for(auto & struct_save : struct_saves){
-                        if(struct_save.id == it.id){
-                            unique = false;
-                            break;
-                        }
-                    }
-                    if(unique){
-                        struct_saves.emplace_back(it);
-                    }
-                    unique = true;
-                }
-                _struct = false;
-            }
-            // now re insert the saved states
-            for(auto & struct_save : struct_saves){
-                if(struct_save.type == "int"){
-                    if(!struct_save.array){
-                        auto returnVariable = intTable.get(struct_save.id);
-                        pop();
-                        intTable.pop_back(struct_save.id);
-                        intTable.insert(returnVariable);
-                    }else{
-                        auto returnVariable = intArrayTable.get(struct_save.id);
-                        pop();
-                        intArrayTable.pop_back(struct_save.id);
-                        intArrayTable.insert(returnVariable);
-                    }
-                }else if(struct_save.type == "float"){
-                    if(!struct_save.array) {
-                        auto returnVariable = floatTable.get(struct_save.id);
-                        pop();
-                        floatTable.pop_back(struct_save.id);
-                        floatTable.insert(returnVariable);
-                    }else{
-                        auto returnVariable = floatArrayTable.get(struct_save.id);
-                        pop();
-                        floatArrayTable.pop_back(struct_save.id);
-                        floatArrayTable.insert(returnVariable);
-                    }
-                }else if(struct_save.type == "bool"){
-                    if(!struct_save.array){
-                        auto returnVariable = boolTable.get(struct_save.id);
-                        pop();
-                        boolTable.pop_back(struct_save.id);
-                        boolTable.insert(returnVariable);
-                    }else{
-                        auto returnVariable = boolArrayTable.get(struct_save.id);
-                        pop();
-                        boolArrayTable.pop_back(struct_save.id);
-                        boolArrayTable.insert(returnVariable);
-                    }
+        // the enclosing blocks and loops stop until the call is over
+        returning = true;
+        // The value is held in current so it outlives the parameters and locals popped once the call is over
+        // an indexed array is returned as its element
+        currentID = "";
+        array = current.isArray();
+        iloc = -1;
+    }
+
+    void Interpreter::visit(parser::ASTStructNode *structNode) {
+        // The layout is built once for every instance
+        interpreter::Struct s(structNode);
+        structTable.insert(std::make_pair(s.id, std::move(s)));
+    }
+
+    interpreter::Value Interpreter::instantiate(interpreter::Struct &layout) {
+        if(layout.prototype == nullptr || !layout.constant){
+            // The initial values of the fields, evaluated in declaration order for the first instance (every instance
+            // unless they are constant), an initial value can refer to the fields declared before it
+            interpreter::Value prototype = interpreter::Record(&layout);
+            auto _self = self;
+            auto _byName = byName;
+            self = &prototype;
+            byName = true;
+            for(std::size_t i = 0; i < layout.fields.size(); ++i){
+                auto declarationNode = layout.fields.at(i);
+                auto& field = std::get<interpreter::Record>(prototype).fields.at(i);
+                currentType = declarationNode -> type;
+                if(declarationNode -> exprNode != nullptr){
+                    declarationNode -> exprNode -> accept(this);
+                    field = std::move(current);
+                }else if(declarationNode -> identifier -> ilocExprNode != nullptr){
+                    int elements = index(declarationNode -> identifier.get());
+                    // nothing is stored for arrays of structs
+                    if(!lexer::isStruct(declarationNode -> type))
+                        field = interpreter::Value::array(declarationNode -> type, elements);
+                }else if(declarationNode -> type != layout.id){
+                    field = instantiate(structTable.find(declarationNode -> type) -> second);
                 }
             }
+            self = _self;
+            byName = _byName;
+            if(!layout.constant)
+                return prototype;
+            layout.prototype = std::make_shared<interpreter::Value>(std::move(prototype));
         }
-        pop();
+        return *layout.prototype;
     }
 
-    void Interpreter::visit(parser::ASTStructNode *structNode) {
-        // visit the block to define the functions
-        structTable.insert(std::pair<std::string, interpreter::Struct>
-                (std::make_pair(structNode->identifier->getID(), interpreter::Struct(structNode->identifier->getID(), structNode->structBlock))));
-    }
-
-    void Interpreter::pop() {
-        // the function has completed its run now we pop back the variables we added
-        for (const auto& pair : toPop){
-            /*
-             * Now we pop the variables
-            */
-            if(pair.type == "int"){
-                pair.array ? intArrayTable.pop_back(pair.id) : intTable.pop_back(pair.id);
-            }else if(pair.type == "float"){
-                pair.array ? floatArrayTable.pop_back(pair.id) : floatTable.pop_back(pair.id);
-            }else if(pair.type == "bool"){
-                pair.array ? boolArrayTable.pop_back(pair.id) : boolTable.pop_back(pair.id);
-            }else if(pair.type == "string"){
-                pair.array ? stringArrayTable.pop_back(pair.id) : stringTable.pop_back(pair.id);
-            }else if(pair.type == "char"){
-                pair.array ? charArrayTable.pop_back(pair.id) : charTable.pop_back(pair.id);
-            }
+    void Interpreter::pop(std::size_t mark) {
+        // pop back the variables declared after mark, newest first
+        while (toPop.size() > mark){
+            variableTable.pop_back(toPop.back().id);
+            toPop.pop_back();
         }
-        toPop = std::vector<interpreter::Popable>();
     }
     // Statements
-}
\ No newline at end of file
+}
@@ -7,68 +7,246 @@
 
 #include "Visitor.h"
 #include "Semantic_Visitor.h"
+#include "../JIT/JIT.h"
+#include <algorithm>
+#include <array>
 #include <utility>
 #include <vector>
 #include <map>
 #include <memory>
 #include <iostream>
+#include <string>
+#include <deque>
+#include <functional>
+#include <type_traits>
+#include <variant>
 
 namespace interpreter{
+    // Array storage shared between copies, the elements are only copied when a shared array is written to
+    // so passing or assigning an array is O(1) and filling one in place never copies it
+    template <typename T>
+    class Array {
+    public:
+        explicit Array(std::size_t size = 0) :
+                elements(std::make_shared<std::vector<T>>(size))
+        {};
+
+        explicit Array(std::vector<T> elements) :
+                elements(std::make_shared<std::vector<T>>(std::move(elements)))
+        {};
+
+        ~Array() = default;
+
+        [[nodiscard]] std::size_t size() const { return elements -> size(); }
+        [[nodiscard]] T at(std::size_t i) const { return elements -> at(i); }
+        // The elements for reading, only valid until the array is written to
+        [[nodiscard]] const std::vector<T>& read() const { return *elements; }
+        // The elements for writing, copied first if another array shares them
+        std::vector<T>& write(){
+            if(elements.use_count() > 1)
+                elements = std::make_shared<std::vector<T>>(*elements);
+            return *elements;
+        }
+
+    private:
+        std::shared_ptr<std::vector<T>> elements;
+    };
+
+    class Value;
+    class Struct;
+
+    // Instance of a tlstruct, its fields are held in one block in the order of its layout (see Struct)
+    // copying an instance copies the block as a whole
+    class Record {
+    public:
+        explicit Record(const Struct* layout);
+
+        const Struct* layout;
+        std::vector<Value> fields;
+    };
+
+    class Job;
+
+    // What spawn gives, copies of a handle refer to the same task
+    class Handle {
+    public:
+        std::shared_ptr<Job> job;
+        // task<T> where T is the type of the result
+        std::string type;
+    };
+
+    typedef std::variant<int, float, bool, char, std::string,
+            Array<int>, Array<float>, Array<bool>, Array<char>, Array<std::string>, Record, Handle> ValueVariant;
+
+    // Runtime value, the alternative held is its tag
+    // Python equivalent of:
+    // value = int | float | bool | char | str | [int] | [float] | [bool] | [char] | [str] | [fields] | task
+    class Value : public ValueVariant {
+    public:
+        // Same order as the alternatives of ValueVariant
+        enum TAG {INT, FLOAT, BOOL, CHAR, STRING, INT_ARRAY, FLOAT_ARRAY, BOOL_ARRAY, CHAR_ARRAY, STRING_ARRAY, RECORD, HANDLE};
+
+        using ValueVariant::ValueVariant;
+
+        [[nodiscard]] TAG tag() const { return (TAG) index(); }
+        [[nodiscard]] bool isArray() const { return index() >= INT_ARRAY && index() <= STRING_ARRAY; }
+        // TeaLang type of the value (of the elements for arrays)
+        [[nodiscard]] std::string type() const;
+
+        // Array access
+        [[nodiscard]] Value at(int i) const;
+        void set(int i, const Value& element);
+        void push_back(const Value& element);
+
+        // Array of size default initialised elements of the given TeaLang type
+        static Value array(const std::string& type, int size);
+    };
+
+    std::ostream& operator<<(std::ostream& os, const Value& value);
+
+    // Operator kernels, kernels[op][tag] computes op for two operands holding tag (OP_NEGATE ignores the right one)
+    // The table is generated at compile time from the operators each type defines and is null everywhere else
+    // so every engine dispatches an operation with a single indexed call
+    typedef Value (*Kernel)(const Value& left, const Value& right);
+
+    namespace kernel {
+        template <lexer::OPERATOR op, typename T>
+        constexpr bool defined() {
+            constexpr bool comparison = op >= lexer::OP_LT && op <= lexer::OP_NE;
+            constexpr bool equality = op == lexer::OP_EQ || op == lexer::OP_NE;
+            if constexpr (std::is_same_v<T, int> || std::is_same_v<T, float>)
+                return op <= lexer::OP_NE || op == lexer::OP_NEGATE;
+            else if constexpr (std::is_same_v<T, bool>)
+                return comparison || op == lexer::OP_AND || op == lexer::OP_OR || op == lexer::OP_NEGATE;
+            else if constexpr (std::is_same_v<T, std::string>)
+                return equality || op == lexer::OP_ADD;
+            else if constexpr (std::is_same_v<T, char>)
+                return equality;
+            else
+                return false;
+        }
+
+        template <lexer::OPERATOR op, typename T>
+        Value compute(const Value& left, const Value& right) {
+            const T& l = std::get<T>(left);
+            if constexpr (op == lexer::OP_NEGATE) {
+                if constexpr (std::is_same_v<T, bool>)
+                    return !l;
+                else
+                    return l * -1;
+            } else {
+                const T& r = std::get<T>(right);
+                if constexpr (op == lexer::OP_ADD) return l + r;
+                else if constexpr (op == lexer::OP_SUB) return l - r;
+                else if constexpr (op == lexer::OP_MUL) return l * r;
+                // if divide by 0 happens, gcc will raise its own error, no need to change the structure to accomodate for this
+                else if constexpr (op == lexer::OP_DIV) return l / r;
+                else if constexpr (op == lexer::OP_LT) return l < r;
+                else if constexpr (op == lexer::OP_GT) return l > r;
+                else if constexpr (op == lexer::OP_LE) return l <= r;
+                else if constexpr (op == lexer::OP_GE) return l >= r;
+                else if constexpr (op == lexer::OP_EQ) return l == r;
+                else if constexpr (op == lexer::OP_NE) return l != r;
+                else if constexpr (op == lexer::OP_AND) return l && r;
+                else return l || r;
+            }
+        }
+
+        template <lexer::OPERATOR op, std::size_t... tags>
+        constexpr std::array<Kernel, sizeof...(tags)> row(std::index_sequence<tags...>) {
+            return {[]() -> Kernel {
+                if constexpr (defined<op, std::variant_alternative_t<tags, ValueVariant>>())
+                    return &compute<op, std::variant_alternative_t<tags, ValueVariant>>;
+                else
+                    return nullptr;
+            }()...};
+        }
+
+        template <std::size_t... ops>
+        constexpr auto table(std::index_sequence<ops...>) {
+            return std::array{row<(lexer::OPERATOR) ops>(std::make_index_sequence<std::variant_size_v<ValueVariant>>())...};
+        }
+    }
+
+    inline constexpr auto kernels = kernel::table(std::make_index_sequence<lexer::OP_INVALID + 1>());
+
+    // Thrown when an operator is not defined for its operands, should never happen because of the semantic pass
+    [[noreturn]] void incorrect(lexer::OPERATOR op, const Value& operand, unsigned int lineNumber);
+
+    // Result of left op right, both operands have the same tag (guaranteed by the semantic pass)
+    inline Value apply(lexer::OPERATOR op, const Value& left, const Value& right, unsigned int lineNumber) {
+        Kernel kernel = left.tag() == right.tag() ? kernels[op][left.tag()] : nullptr;
+        if(kernel == nullptr)
+            incorrect(op, left, lineNumber);
+        return kernel(left, right);
+    }
+
+    // Result of the unary operator (- for int and float, not for bool)
+    inline Value negate(const Value& value, unsigned int lineNumber) {
+        Kernel kernel = kernels[lexer::OP_NEGATE][value.tag()];
+        if(kernel == nullptr)
+            incorrect(lexer::OP_NEGATE, value, lineNumber);
+        return kernel(value, value);
+    }
+
+    // Run f on a thread of its own with a native stack of size bytes, what it throws is rethrown here
+    void onStack(const std::function<void()>& f, std::size_t size);
+    // Bytes of native stack the calling thread may still use, 0 once it is almost used up
+    std::size_t available();
+
+    // A variable only holds the value it currently has
+    // Declaring a variable that already exists (function parameters, locals with the same name as a global)
+    // shadows it, the shadowed values are kept in a stack and are restored when the declaration goes out of scope
     template <typename T>
     class Variable : public semantic::Variable{
     public:
         Variable(const std::string& type, const std::string& identifier, bool array, T value, unsigned int lineNumber) :
                 semantic::Variable(type, identifier, array, lineNumber),
-                latestValue(value),
-                size(0)
-                {
-                    values.emplace_back(value);
-                };
+                latestValue(std::move(value))
+                {};
 
         explicit Variable(const std::string& identifier) :
-                semantic::Variable(identifier),
-                size(0)
+                semantic::Variable(identifier)
         {};
 
         Variable(Variable const &v) :
                 semantic::Variable(v.type, v.identifier, v.array, v.lineNumber),
                 latestValue(v.latestValue),
-                values(v.values),
-                size(v.size)
+                values(v.values)
         {};
 
         ~Variable() = default;
         T latestValue;
+        // shadowed values, the last one is restored on pop_back
         std::vector<T> values;
-        int size;
     };
 
     class Function : public semantic::Function{
     public:
         Function(const std::string& type, const std::string& identifier, const std::vector<std::string>& paramTypes,
-                 std::vector<std::string>  paramIDs,
-                 std::shared_ptr<parser::ASTBlockNode> blockNode, unsigned int lineNumber)
+                 parser::ASTFunctionDeclarationNode* declaration, unsigned int lineNumber)
                  :
                  semantic::Function(type, identifier, paramTypes, lineNumber),
-                 paramIDs(std::move(paramIDs)),
-                 blockNode(std::move(blockNode))
+                 declaration(declaration)
                  {};
 
         explicit Function(const std::string& identifier, const std::vector<std::string>& paramTypes) :
-                semantic::Function(identifier, paramTypes)
+                semantic::Function(identifier, paramTypes),
+                declaration(nullptr)
         {};
 
         Function(Function const &f) :
                 semantic::Function(f.type, f.identifier, f.paramTypes, f.lineNumber),
-                paramIDs(f.paramIDs),
-                blockNode(f.blockNode)
+                declaration(f.declaration)
         {};
 
         ~Function() = default;
-        std::vector<std::string> paramIDs;
-        std::shared_ptr<parser::ASTBlockNode> blockNode;
+        // the program owns the declaration
+        parser::ASTFunctionDeclarationNode* declaration;
     };
 
+    // All updates happen in place, the map nodes are only created on the first declaration
+    // and removed when the last declaration goes out of scope
     template <typename Key, typename Value>
     class Table {
     public:
@@ -80,18 +258,29 @@ namespace interpreter{
         std::map<Key, Value> self;
 
 
-        auto find(Value v);
+        auto find(const Value& v);
+        auto find(const std::string& identifier);
+        // Declare v, shadowing the variable with the same identifier (if any)
         bool insert(Value v);
+        // Overwrite the current value of v, declares it if it does not exist
+        void assign(Value v);
         bool found(std::_Rb_tree_iterator<std::pair<const std::basic_string<char, std::char_traits<char>, std::allocator<char>>, Value>> result);
+        // Undo the last declaration of identifier
         void pop_back(const std::string& identifier);
-        Value get(const std::string& identifier = "0CurrentVariable");
+        // The variable itself (not a copy) so that its value can be read or updated in place
+        Value& get(const std::string& identifier);
     };
 
     template<typename Key, typename Value>
-    auto Table<Key, Value>::find(Value v) {
+    auto Table<Key, Value>::find(const Value& v) {
         return self.find(v.identifier);
     }
 
+    template<typename Key, typename Value>
+    auto Table<Key, Value>::find(const std::string& identifier) {
+        return self.find(identifier);
+    }
+
     template<typename Key, typename Value>
     bool Table<Key, Value>::insert(Value v) {
         if(v.type.empty()){
@@ -99,25 +288,28 @@ namespace interpreter{
         }
         auto result = find(v);
         if(found(result)){
-            // Copy the result variable
-            Value cpy(result -> second);
-            // add the new value
-            cpy.values.emplace_back(v.latestValue);
-            ++cpy.size;
-            cpy.latestValue = v.latestValue;
-            // remove the result
-            self.erase(result);
-            // insert the copy
-            insert(cpy);
+            // shadow the current value
+            result -> second.values.emplace_back(std::move(result -> second.latestValue));
+            result -> second.latestValue = std::move(v.latestValue);
             return false;
         }else{
             // The variable doesnt exist so we add a new one
-            v.size = v.values.size();
-            auto ret = self.insert(std::pair<Key, Value>(v.identifier, v) );
+            v.values.clear();
+            auto ret = self.insert(std::pair<Key, Value>(v.identifier, std::move(v)));
             return ret.second;
         }
     }
 
+    template<typename Key, typename Value>
+    void Table<Key, Value>::assign(Value v) {
+        auto result = find(v);
+        if(found(result)){
+            result -> second.latestValue = std::move(v.latestValue);
+        }else{
+            insert(std::move(v));
+        }
+    }
+
     template<typename Key, typename Value>
     bool Table<Key, Value>::found(
             std::_Rb_tree_iterator<std::pair<const std::basic_string<char, std::char_traits<char>, std::allocator<char>>, Value>> result) {
@@ -126,88 +318,84 @@ namespace interpreter{
 
     template<typename Key, typename Value>
     void Table<Key, Value>::pop_back(const std::string &identifier) {
-        auto result = find(Value(identifier));
+        auto result = self.find(identifier);
         if(!found(result)){
             throw std::runtime_error("Failed to find variable with identifier " + identifier);
         }
-        // Copy the result variable
-        Value cpy (result -> second);
-        // pop the value from the copy
-        --cpy.size;
-        if(cpy.size == -1){
-            cpy.size = 0;
+        if(result -> second.values.empty()){
+            // nothing is shadowed, the variable is gone
+            self.erase(result);
         }else{
-            cpy.values.erase(cpy.values.begin() + cpy.size);
+            // restore the shadowed value
+            result -> second.latestValue = std::move(result -> second.values.back());
+            result -> second.values.pop_back();
         }
-        if(cpy.size != 0){
-            cpy.latestValue = cpy.values.back();
-        }
-        // remove the result=
-        self.erase(result);
-        // insert the copy
-        insert(cpy);
     }
 
     template<typename Key, typename Value>
-    Value Table<Key, Value>::get(const std::string &identifier) {
-        auto result = find(Value(identifier));
+    Value& Table<Key, Value>::get(const std::string &identifier) {
+        auto result = self.find(identifier);
         if(!found(result)){
             throw std::runtime_error("Failed to find variable with identifier " + identifier);
         }
-        auto ret = result -> second;
-        // pop_back case
-        if(identifier == "0CurrentVariable") {
-            pop_back("0CurrentVariable");
-        }
-        // return the popped value
-        return ret;
+        return result -> second;
     }
 
 
+    // The layout shared by every instance of a tlstruct, built once when the struct is declared
     class Struct{
     public:
         Struct(std::string id, std::shared_ptr<parser::ASTBlockNode> structNode) :
                 id(std::move(id)),
-                structNode(structNode)
+                structNode(std::move(structNode)),
+                constant(false)
         {};
+        // The layout of a declared struct
+        explicit Struct(parser::ASTStructNode* structNode);
 
         ~Struct() = default;
 
         std::string id;
         std::shared_ptr<parser::ASTBlockNode> structNode;
+        // The declarations of the fields in declaration order (self is not stored)
+        std::vector<parser::ASTDeclarationNode*> fields;
+        // Python equivalent of:
+        // offsets = {identifier: index into the fields of an instance}
+        std::map<std::string, std::size_t> offsets;
+        // Python equivalent of:
+        // methods = {{identifier, [ARGUMENT_TYPES,]}: functionDeclarationNode}
+        std::map<std::pair<std::string, std::vector<std::string>>, parser::ASTFunctionDeclarationNode*> methods;
+        // Are the initial values of the fields (and the sizes of the array fields) made of literals only?
+        // Only then does every instance start out the same, otherwise the initial values are evaluated for each instance
+        // as they may call functions or read globals
+        bool constant;
+        // An instance with its fields initialised, evaluated for the first instance and copied for the rest when constant
+        std::shared_ptr<Value> prototype;
     };
 
     class Popable{
     public:
-        Popable(std::string type, std::string id, bool array) :
+        Popable(std::string type, std::string id) :
             type(std::move(type)),
-            id(std::move(id)),
-            array(array)
+            id(std::move(id))
         {};
 
         ~Popable() = default;
 
         std::string type;
         std::string id;
-        bool array;
     };
 }
 
 namespace visitor {
+    // One execution of a program, everything that changes while it runs is kept here.
+    // The program (its AST once the semantic pass is done) is only read, so any number of
+    // interpreters may run the same program at the same time, each on its own thread.
     class Interpreter : public Visitor {
     private:
         // Python equivalent of:
         // variableTable = {identifier: {TYPE, identifier, val, values, lineNumber}}
-        interpreter::Table<std::string, interpreter::Variable<int>>                         intTable;
-        interpreter::Table<std::string, interpreter::Variable<float>>                       floatTable;
-        interpreter::Table<std::string, interpreter::Variable<bool>>                        boolTable;
-        interpreter::Table<std::string, interpreter::Variable<std::string>>                 stringTable;
-        interpreter::Table<std::string, interpreter::Variable<char>>                        charTable;
-        interpreter::Table<std::string, interpreter::Variable<std::vector<int>>>            intArrayTable;
-        interpreter::Table<std::string, interpreter::Variable<std::vector<float>>>          floatArrayTable;
-        interpreter::Table<std::string, interpreter::Variable<std::vector<bool>>>           boolArrayTable;
-        interpreter::Table<std::string, interpreter::Variable<std::vector<std::string>>>    stringArrayTable;
-        interpreter::Table<std::string, interpreter::Variable<std::vector<char>>>           charArrayTable;
+        interpreter::Table<std::string, interpreter::Variable<interpreter::Value>> variableTable;
         // Python equivalent of:
         // functionTable = {{identifier, [ARGUMENT_TYPES,]}: {TYPE, identifier, [ARGUMENT_TYPES,], lineNumber}}
         std::map<std::pair<std::string, std::vector<std::string>>, interpreter::Function> functionTable;
@@ -215,53 +403,134 @@ namespace visitor {
         // type, identifier
         std::string currentType;
         std::string currentID;
-        std::string structID;
         std::map<std::string, interpreter::Struct> structTable;
-        // variable name, struct name
-        std::map<std::string, std::string> struct_variable;
-        std::vector<std::string> listOfStructs;
-        // function block
-        bool function;
         // array flag
         bool array;
         //iloc
         int iloc;
-        //                      Type, Identifier, array
+        // Declarations that are still in scope, innermost last
+        //                      Type, Identifier
         std::vector<interpreter::Popable> toPop;
+        // Call frames, the parameters of every active call in call order
+        // the parameters of the current call start at base
+        // a deque so that a parameter stays where it is while it is the receiver of a method
+        std::deque<interpreter::Value> frames;
+        std::size_t base;
+        // The instance the current method runs on, null outside of methods
+        interpreter::Value* self;
+        // the members of self are found by name, the method was not resolved by the semantic pass
+        bool byName;
+        // set by a return, the blocks and loops of the current call stop running until it is over
+        bool returning;
+        // A call in tail position, its arguments are pushed after the frame of the call it returns from
+        // which runs it in place of itself instead of nesting it
+        parser::ASTFunctionCallNode* tail;
+        // Calls nested at the moment and how many may be (calls in tail position do not nest)
+        // The frames above live on the heap but a call still runs its block through nested accept and visit calls,
+        // running calls off a heap stack alone would mean turning every visit into an explicit continuation.
+        // So the depth is bounded by a native stack sized for capacity calls instead (see run and frameBytes)
+        std::size_t depth;
+        std::size_t capacity;
+        // float sums of vectorized loops may add in a different order than the loop (see simd::sum)
+        bool relaxed;
+
+        // hot global functions that run as native code
+        jit::Cache jit;
+        // where print writes to
+        std::ostream& out;
+
+        // Value of the last visited expression, the element for an indexed array
+        // expressions hand their result over here instead of storing it in the variableTable
+        interpreter::Value current;
+        // Tasks spawned from here that may not have been awaited yet, in spawn order
+        // declared last so that they are over before anything they may still use is destroyed
+        std::vector<std::shared_ptr<interpreter::Job>> spawned;
     public:
-        Interpreter(){
-            // insert the interpreter variables these being the literal and 0CurrentVariable for each type
-            intTable.insert(interpreter::Variable<int>("int", "0CurrentVariable", false, 0, 0));
-            intTable.insert(interpreter::Variable<int> ("int", "0literal", false, 0, 0));
-            intArrayTable.insert(interpreter::Variable<std::vector<int>>("int", "0CurrentVariable", true, {0}, 0));
-            intArrayTable.insert(interpreter::Variable<std::vector<int>>("int", "0literal", true, {0}, 0));
-            floatTable.insert(interpreter::Variable<float>("float", "0CurrentVariable", false, 0.0, 0));
-            floatTable.insert(interpreter::Variable<float> ("float", "0literal", false, 0.0, 0));
-            floatArrayTable.insert(interpreter::Variable<std::vector<float>>("float", "0CurrentVariable", true, {0.0}, 0));
-            floatArrayTable.insert(interpreter::Variable<std::vector<float>>("float", "0literal", true, {0.0}, 0));
-            boolTable.insert(interpreter::Variable<bool>("bool", "0CurrentVariable", false, false, 0));
-            boolTable.insert(interpreter::Variable<bool> ("bool", "0literal", false, false, 0));
-            boolArrayTable.insert(interpreter::Variable<std::vector<bool>>("float", "0CurrentVariable", true, {false}, 0));
-            boolArrayTable.insert(interpreter::Variable<std::vector<bool>> ("float", "0literal", true, {false}, 0));
-            stringTable.insert(interpreter::Variable<std::string>("string", "0CurrentVariable", false, "", 0));
-            stringTable.insert(interpreter::Variable<std::string> ("string", "0literal", false, "", 0));
-            stringArrayTable.insert(interpreter::Variable<std::vector<std::string>>("string", "0CurrentVariable", true, {""}, 0));
-            stringArrayTable.insert(interpreter::Variable<std::vector<std::string>> ("string", "0literal", true, {""}, 0));
-            charTable.insert(interpreter::Variable<char>("char", "0CurrentVariable", false, ' ', 0));
-            charTable.insert(interpreter::Variable<char> ("char", "0literal", false, ' ', 0));
-            charArrayTable.insert(interpreter::Variable<std::vector<char>>("char", "0CurrentVariable", true, {' '}, 0));
-            charArrayTable.insert(interpreter::Variable<std::vector<char>> ("char", "0literal", true, {' '}, 0));
-            function = false;
+        // Nested calls allowed by default, the program runs on a thread whose native stack has frameBytes for each of them
+        // frameBytes is an estimate of what the visits of one call take, a call whose expressions nest deeper takes more
+        // so calls also stop with "Stack depth exceeded" once the native stack is almost used up (see interpreter::available)
+        static constexpr std::size_t defaultCapacity = 1 << 16;
+        static constexpr std::size_t frameBytes = 1 << 10;
+
+        explicit Interpreter(std::size_t capacity = defaultCapacity, bool relaxed = false, std::ostream& out = std::cout) :
+                out(out)
+        {
             array = false;
             iloc = -1;
-            structID = "";
+            base = 0;
+            self = nullptr;
+            byName = false;
+            returning = false;
+            tail = nullptr;
+            depth = 0;
+            this -> capacity = capacity;
+            this -> relaxed = relaxed;
         };
         ~Interpreter() = default;
         auto find(const interpreter::Function& f);
         bool insert(const interpreter::Function& f);
         bool found(std::_Rb_tree_iterator<std::pair<const std::pair<std::basic_string<char, std::char_traits<char>, std::allocator<char>>, std::vector<std::basic_string<char, std::char_traits<char>, std::allocator<char>>>>, interpreter::Function>> result);
 
-        void pop();
+        // Undo every declaration made after toPop had size mark
+        void pop(std::size_t mark);
+        // The value between the [] of an identifier as an index
+        int index(parser::ASTIdentifierNode* identifierNode);
+        // The variable, parameter or field an identifier refers to, up to (not including) last
+        // null if nothing is stored for it, iloc is set to the index of the element (-1 if none)
+        interpreter::Value* locate(parser::ASTIdentifierNode* identifierNode, parser::ASTIdentifierNode* last = nullptr);
+        // A new instance of the struct, a copy of its prototype
+        interpreter::Value instantiate(interpreter::Struct& layout);
+        // The function a call runs with its arguments in the frame from frame, looked up by name when it was not resolved
+        // methods are looked up in the layout of the receiver (null for a global function), unless it is the struct cached at the call site
+        parser::ASTFunctionDeclarationNode* resolve(parser::ASTIdentifierNode* identifier, parser::ASTIdentifierNode* name, std::size_t frame,
+                                                    parser::ASTFunctionDeclarationNode* callee, interpreter::Value*& receiver,
+                                                    std::atomic<parser::ASTFunctionDeclarationNode*>& method, unsigned int lineNumber);
+        // Whether a variable stays where it is while a loop runs (a parameter or a variable of the table)
+        bool stable(parser::ASTIdentifierNode* identifierNode, const interpreter::Value* v);
+        // variable op bound (or bound op variable, op is flipped) where the bound is a literal (limit) or a variable that stays where it is
+        bool comparison(parser::ASTExprNode* exprNode, const interpreter::Value* variable, lexer::OPERATOR& op,
+                        parser::ASTExprNode*& limit, const interpreter::Value*& bound);
+        // variable = variable + by, variable = by + variable or variable = variable - by (down)
+        bool step(parser::ASTAssignmentNode* assignmentNode, const interpreter::Value* variable, parser::ASTExprNode*& by, bool& down);
+        // Run a for loop of the form for(let i : T = start; i op bound; i = i +/- step) with T int or float
+        // with i compared and stepped in place, false (nothing run) if the loop is not of that form
+        bool counted(parser::ASTForNode* forNode);
+        template <typename T>
+        void count(parser::ASTForNode* forNode, interpreter::Value& variable, lexer::OPERATOR op, const interpreter::Value* bound, T limit,
+                   bool down, T step);
+        // Run a while loop of the form while(i op bound){ statement; i = i + 1; } when its statement is vectorized
+        bool counted(parser::ASTWhileNode* whileNode);
+        // The int or float array of an element indexed by the loop variable alone (a[i]), null otherwise
+        interpreter::Value* element(parser::ASTExprNode* exprNode, const interpreter::Value* variable);
+        // Run the statement of a loop over the elements [from, to) as one SIMD kernel when it is a reduction (total = total + a[i]
+        // or if(a[i] op best){ best = a[i]; } for a minimum or maximum) or a map (a[i] = left op right, each operand an element b[i]
+        // or a scalar), false (nothing run) otherwise. Those leave no iteration depending on another, large ones run across the pool
+        bool vectorized(parser::ASTStatementNode* statement, const interpreter::Value* variable, const interpreter::Value* bound, int from, int to);
+        // Evaluate the arguments into a new frame and run the callee, then any call it returns in tail position in the same frame
+        void call(const std::shared_ptr<parser::ASTIdentifierNode>& identifier, const std::vector<std::shared_ptr<parser::ASTExprNode>>& parameters,
+                  parser::ASTFunctionDeclarationNode* callee, std::atomic<parser::ASTFunctionDeclarationNode*>& method, unsigned int lineNumber);
+        // Run the callee on the arguments in the frame from frame (receiver is the instance of a method, null otherwise)
+        // then any call it returns in tail position in the same frame, the result is left in current
+        void enter(parser::ASTIdentifierNode* identifier, parser::ASTFunctionDeclarationNode* callee, std::size_t frame,
+                   interpreter::Value* receiver, unsigned int lineNumber);
+        // The result of the global function callee called with the count arguments (moved from), on the functions, structs and
+        // globals declared so far. The tasks the call spawns are over once it returns, a call that throws leaves nothing behind
+        interpreter::Value invoke(parser::ASTFunctionDeclarationNode* callee, interpreter::Value* arguments, std::size_t count);
+        // The global function identifier taking arguments of paramTypes, null if none has been declared
+        parser::ASTFunctionDeclarationNode* declaration(const std::string& identifier, const std::vector<std::string>& paramTypes);
+        // The value of the global variable identifier, null if none has been declared
+        [[nodiscard]] const interpreter::Value* global(const std::string& identifier) const;
+        // Wait for a spawned task and give its result, what the task printed is written to out by the first await of it
+        // rethrows what stopped the task
+        interpreter::Value await(interpreter::Job& job);
+        // Await every task spawned from here that is still pending, so that none outlives the run that spawned it
+        void settle();
+        // Point the records of a value to the layouts of this interpreter (the result of a task points to those of the task)
+        void adopt(interpreter::Value& value);
+
+        // Run the program with the values of globals in place of what the top level let of the same name would give
+        // (a value has to be of the type the variable is declared with)
+        void run(parser::ASTProgramNode* programNode, const std::map<std::string, interpreter::Value>& globals);
 
         void visit(parser::ASTProgramNode* programNode) override;
 
@@ -274,6 +543,8 @@ namespace visitor {
         void visit(parser::ASTBinaryNode* binaryNode) override;
         void visit(parser::ASTIdentifierNode* identifierNode) override;
         void visit(parser::ASTUnaryNode* unaryNode) override;
+        void visit(parser::ASTSpawnNode* spawnNode) override;
+        void visit(parser::ASTAwaitNode* awaitNode) override;
         void visit(parser::ASTFunctionCallNode* functionCallNode) override;
 
         void visit(parser::ASTSFunctionCallNode* sFunctionCallNode) override;
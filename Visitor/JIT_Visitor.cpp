@@ -0,0 +1,395 @@
+//
+// Stitches the stencils of a numeric function into machine code for the JIT.
+//
+
+#include "JIT_Visitor.h"
+#include "Interpreter_Visitor.h"
+#include <bit>
+#include <cstring>
+
+namespace visitor {
+    namespace {
+        bool numeric(const std::string& type) {
+            return type == "int" || type == "float" || type == "bool";
+        }
+
+        // The stencil of op for operands of type, null if there is none
+        const jit::Stencil* binary(lexer::OPERATOR op, const std::string& type) {
+            if(type == "int"){
+                switch (op) {
+                    case lexer::OP_ADD: return &jit::stencil::ADD_INT;
+                    case lexer::OP_SUB: return &jit::stencil::SUB_INT;
+                    case lexer::OP_MUL: return &jit::stencil::MUL_INT;
+                    case lexer::OP_DIV: return &jit::stencil::DIV_INT;
+                    case lexer::OP_LT: return &jit::stencil::LT_INT;
+                    case lexer::OP_GT: return &jit::stencil::GT_INT;
+                    case lexer::OP_LE: return &jit::stencil::LE_INT;
+                    case lexer::OP_GE: return &jit::stencil::GE_INT;
+                    case lexer::OP_EQ: return &jit::stencil::EQ_INT;
+                    case lexer::OP_NE: return &jit::stencil::NE_INT;
+                    default: return nullptr;
+                }
+            }
+            if(type == "float"){
+                switch (op) {
+                    case lexer::OP_ADD: return &jit::stencil::ADD_FLOAT;
+                    case lexer::OP_SUB: return &jit::stencil::SUB_FLOAT;
+                    case lexer::OP_MUL: return &jit::stencil::MUL_FLOAT;
+                    case lexer::OP_DIV: return &jit::stencil::DIV_FLOAT;
+                    case lexer::OP_LT: return &jit::stencil::LT_FLOAT;
+                    case lexer::OP_GT: return &jit::stencil::GT_FLOAT;
+                    case lexer::OP_LE: return &jit::stencil::LE_FLOAT;
+                    case lexer::OP_GE: return &jit::stencil::GE_FLOAT;
+                    case lexer::OP_EQ: return &jit::stencil::EQ_FLOAT;
+                    case lexer::OP_NE: return &jit::stencil::NE_FLOAT;
+                    default: return nullptr;
+                }
+            }
+            if(type == "bool"){
+                // bools are 0 or 1 so they compare like ints
+                switch (op) {
+                    case lexer::OP_AND: return &jit::stencil::AND;
+                    case lexer::OP_OR: return &jit::stencil::OR;
+                    case lexer::OP_EQ: return &jit::stencil::EQ_INT;
+                    case lexer::OP_NE: return &jit::stencil::NE_INT;
+                    default: return nullptr;
+                }
+            }
+            return nullptr;
+        }
+
+        bool simple(parser::ASTIdentifierNode* identifierNode) {
+            return identifierNode->getChild() == nullptr || identifierNode->getChild()->isEmpty();
+        }
+
+        void condition(const std::string& type) {
+            if(type != "bool")
+                throw jit::UnsupportedException();
+        }
+    }
+
+    JIT::JIT(std::vector<int> shape) :
+            frame(0),
+            shape(std::move(shape)),
+            function(nullptr),
+            next(0)
+    {}
+
+    bool JIT::loops(parser::ASTBlockNode *blockNode) {
+        for(auto &s : blockNode->statements){
+            if(dynamic_cast<parser::ASTForNode*>(s.get()) != nullptr || dynamic_cast<parser::ASTWhileNode*>(s.get()) != nullptr)
+                return true;
+            if(auto ifNode = dynamic_cast<parser::ASTIfNode*>(s.get()))
+                if(loops(ifNode->ifBlock.get()) || (ifNode->elseBlock != nullptr && loops(ifNode->elseBlock.get())))
+                    return true;
+            if(auto block = dynamic_cast<parser::ASTBlockNode*>(s.get()))
+                if(loops(block))
+                    return true;
+        }
+        return false;
+    }
+
+    std::size_t JIT::put(const jit::Stencil &stencil, std::int32_t operand) {
+        auto start = code.size();
+        code.insert(code.end(), stencil.bytes, stencil.bytes + stencil.size);
+        if(stencil.hole < 0)
+            return start;
+        std::memcpy(&code[start + stencil.hole], &operand, sizeof(operand));
+        return start + stencil.hole;
+    }
+
+    void JIT::patch(std::size_t hole, std::size_t target) {
+        auto offset = (std::int32_t) ((std::int64_t) target - (std::int64_t) (hole + sizeof(std::int32_t)));
+        std::memcpy(&code[hole], &offset, sizeof(offset));
+    }
+
+    jit::Slot JIT::declare(const std::string &identifier, const std::string &type) {
+        if(!numeric(type))
+            throw jit::UnsupportedException();
+        jit::Slot slot(next++, type, false);
+        frame = std::max(frame, next);
+        scopes.back().insert_or_assign(identifier, slot);
+        return slot;
+    }
+
+    jit::Slot JIT::lookup(const std::string &identifier) {
+        for(auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope){
+            auto result = scope->find(identifier);
+            if(result != scope->end())
+                return result->second;
+        }
+        // globals, members and self are left to the interpreter
+        throw jit::UnsupportedException();
+    }
+
+    void JIT::visit(parser::ASTFunctionDeclarationNode *functionDeclarationNode) {
+        // the function being compiled, declarations inside it are not
+        if(function != nullptr)
+            throw jit::UnsupportedException();
+        function = functionDeclarationNode;
+        type = functionDeclarationNode->type;
+        if(type != "auto" && !numeric(type))
+            throw jit::UnsupportedException();
+        bails.emplace_back(put(jit::stencil::ENTER));
+        put(jit::stencil::DEPTH);
+
+        // The parameters are the first slots, in order
+        if(shape.size() != functionDeclarationNode->parameters.size())
+            throw jit::UnsupportedException();
+        scopes.emplace_back();
+        for(int i = 0; i < shape.size(); ++i){
+            const auto& parameter = functionDeclarationNode->parameters.at(i);
+            auto tag = (interpreter::Value::TAG) shape.at(i);
+            bool scalar = (tag == interpreter::Value::INT && parameter.second == "int") || (tag == interpreter::Value::FLOAT && parameter.second == "float")
+                          || (tag == interpreter::Value::BOOL && parameter.second == "bool");
+            bool array = (tag == interpreter::Value::INT_ARRAY && parameter.second == "int") || (tag == interpreter::Value::FLOAT_ARRAY && parameter.second == "float");
+            if(scalar){
+                declare(parameter.first, parameter.second);
+            }else if(array){
+                scopes.back().insert_or_assign(parameter.first, jit::Slot(next, parameter.second, true));
+                next += 2;
+                frame = next;
+            }else{
+                throw jit::UnsupportedException();
+            }
+        }
+        functionDeclarationNode->functionBlock->accept(this);
+        scopes.clear();
+        // a function that ends without a return is left to the interpreter
+        auto bail = code.size();
+        put(jit::stencil::BAIL);
+        for(auto hole : bails)
+            patch(hole, bail);
+        for(const auto& hole : framed){
+            std::int32_t bytes = frame * 8 + hole.second;
+            std::memcpy(&code[hole.first], &bytes, sizeof(bytes));
+        }
+        if(type == "auto" || frame > jit::Cache::slots)
+            throw jit::UnsupportedException();
+    }
+
+    // Expressions
+    // Every expression leaves its value in eax and sets currentType to its type
+    void JIT::visit(parser::ASTLiteralNode<int> *literalNode) {
+        put(jit::stencil::CONSTANT, literalNode->val);
+        currentType = "int";
+    }
+
+    void JIT::visit(parser::ASTLiteralNode<float> *literalNode) {
+        put(jit::stencil::CONSTANT, std::bit_cast<std::int32_t>(literalNode->val));
+        currentType = "float";
+    }
+
+    void JIT::visit(parser::ASTLiteralNode<bool> *literalNode) {
+        put(jit::stencil::CONSTANT, literalNode->val ? 1 : 0);
+        currentType = "bool";
+    }
+
+    void JIT::visit(parser::ASTLiteralNode<char> *literalNode) {
+        throw jit::UnsupportedException();
+    }
+
+    void JIT::visit(parser::ASTLiteralNode<std::string> *literalNode) {
+        throw jit::UnsupportedException();
+    }
+
+    void JIT::visit(parser::ASTArrayLiteralNode *arrayLiteralNode) {
+        throw jit::UnsupportedException();
+    }
+
+    void JIT::visit(parser::ASTBinaryNode *binaryNode) {
+        binaryNode->left->accept(this);
+        auto left = currentType;
+        put(jit::stencil::PUSH);
+        binaryNode->right->accept(this);
+        put(jit::stencil::OPERANDS);
+        auto op = binaryNode->kind;
+        auto stencil = left == currentType ? binary(op, left) : nullptr;
+        if(stencil == nullptr)
+            throw jit::UnsupportedException();
+        if(stencil == &jit::stencil::DIV_INT)
+            bails.emplace_back(put(jit::stencil::DIVISOR));
+        put(*stencil);
+        bool comparison = op != lexer::OP_ADD && op != lexer::OP_SUB && op != lexer::OP_MUL && op != lexer::OP_DIV;
+        currentType = comparison ? "bool" : left;
+    }
+
+    void JIT::visit(parser::ASTIdentifierNode *identifierNode) {
+        if(!simple(identifierNode))
+            throw jit::UnsupportedException();
+        auto slot = lookup(identifierNode->identifier);
+        if(identifierNode->ilocExprNode == nullptr){
+            // arrays are only read an element at a time
+            if(slot.array)
+                throw jit::UnsupportedException();
+            put(jit::stencil::LOAD, slot.slot * 8);
+            currentType = slot.type;
+            return;
+        }
+        if(!slot.array)
+            throw jit::UnsupportedException();
+        identifierNode->ilocExprNode->accept(this);
+        if(currentType == "float")
+            put(jit::stencil::TO_INDEX);
+        else if(currentType != "int")
+            throw jit::UnsupportedException();
+        put(jit::stencil::BOUNDS, (slot.slot + 1) * 8);
+        bails.emplace_back(put(jit::stencil::JUMP_IF_ABOVE_EQUAL));
+        put(jit::stencil::ELEMENT, slot.slot * 8);
+        currentType = slot.type;
+    }
+
+    void JIT::visit(parser::ASTUnaryNode *unaryNode) {
+        unaryNode->exprNode->accept(this);
+        if(currentType == "int")
+            put(jit::stencil::NEG_INT);
+        else if(currentType == "float")
+            put(jit::stencil::NEG_FLOAT);
+        else if(currentType == "bool")
+            put(jit::stencil::NOT);
+        else
+            throw jit::UnsupportedException();
+    }
+
+    // A function that spawns or awaits tasks stays with the interpreter
+    void JIT::visit(parser::ASTSpawnNode *spawnNode) {
+        throw jit::UnsupportedException();
+    }
+
+    void JIT::visit(parser::ASTAwaitNode *awaitNode) {
+        throw jit::UnsupportedException();
+    }
+
+    void JIT::visit(parser::ASTFunctionCallNode *functionCallNode) {
+        // Only calls of the function itself with the same kind of arguments, the result type has to be known
+        if(functionCallNode->callee != function || type == "auto")
+            throw jit::UnsupportedException();
+        auto count = (std::int32_t) functionCallNode->parameters.size();
+        for(int i = 0; i < count; ++i){
+            functionCallNode->parameters.at(i)->accept(this);
+            auto tag = (interpreter::Value::TAG) shape.at(i);
+            if(tag != interpreter::Value::INT && tag != interpreter::Value::FLOAT && tag != interpreter::Value::BOOL)
+                throw jit::UnsupportedException();
+            if(currentType != function->parameters.at(i).second)
+                throw jit::UnsupportedException();
+            put(jit::stencil::PUSH);
+        }
+        // the new frame is below the saved rdi and rsi, the arguments are above them
+        framed.emplace_back(put(jit::stencil::SAVE), 0);
+        for(int i = 0; i < count; ++i){
+            framed.emplace_back(put(jit::stencil::ARGUMENT), 16 + (count - 1 - i) * 8);
+            put(jit::stencil::PARAMETER, i * 8);
+        }
+        patch(put(jit::stencil::CALL), 0);
+        framed.emplace_back(put(jit::stencil::RESTORE), 0);
+        put(jit::stencil::DROP, count * 8);
+        bails.emplace_back(put(jit::stencil::JUMP_IF_BAILED));
+        put(jit::stencil::RESULT);
+        currentType = type;
+    }
+    // Expressions
+
+    // Statements
+    void JIT::visit(parser::ASTSFunctionCallNode *sFunctionCallNode) {
+        throw jit::UnsupportedException();
+    }
+
+    void JIT::visit(parser::ASTDeclarationNode *declarationNode) {
+        if(declarationNode->exprNode == nullptr || declarationNode->identifier->ilocExprNode != nullptr)
+            throw jit::UnsupportedException();
+        declarationNode->exprNode->accept(this);
+        auto declared = declarationNode->type == "auto" ? currentType : declarationNode->type;
+        if(declared != currentType)
+            throw jit::UnsupportedException();
+        auto slot = declare(declarationNode->identifier->getID(), declared);
+        put(jit::stencil::STORE, slot.slot * 8);
+    }
+
+    void JIT::visit(parser::ASTAssignmentNode *assignmentNode) {
+        auto identifierNode = assignmentNode->identifier.get();
+        if(!simple(identifierNode) || identifierNode->ilocExprNode != nullptr)
+            throw jit::UnsupportedException();
+        assignmentNode->exprNode->accept(this);
+        auto slot = lookup(identifierNode->identifier);
+        if(slot.array || slot.type != currentType)
+            throw jit::UnsupportedException();
+        put(jit::stencil::STORE, slot.slot * 8);
+    }
+
+    void JIT::visit(parser::ASTPrintNode *printNode) {
+        throw jit::UnsupportedException();
+    }
+
+    void JIT::visit(parser::ASTBlockNode *blockNode) {
+        // the slots of the block's declarations are reused once it is over
+        scopes.emplace_back();
+        int _next = next;
+        for(auto &s : blockNode->statements)
+            s->accept(this);
+        next = _next;
+        scopes.pop_back();
+    }
+
+    void JIT::visit(parser::ASTIfNode *ifNode) {
+        ifNode->condition->accept(this);
+        condition(currentType);
+        auto otherwise = put(jit::stencil::JUMP_IF_FALSE);
+        ifNode->ifBlock->accept(this);
+        if(ifNode->elseBlock != nullptr){
+            auto end = put(jit::stencil::JUMP);
+            patch(otherwise, code.size());
+            ifNode->elseBlock->accept(this);
+            patch(end, code.size());
+        }else{
+            patch(otherwise, code.size());
+        }
+    }
+
+    void JIT::visit(parser::ASTForNode *forNode) {
+        // the loop variable only lives as long as the loop
+        scopes.emplace_back();
+        int _next = next;
+        if(forNode->declaration != nullptr)
+            forNode->declaration->accept(this);
+        auto loop = code.size();
+        forNode->condition->accept(this);
+        condition(currentType);
+        auto exit = put(jit::stencil::JUMP_IF_FALSE);
+        forNode->loopBlock->accept(this);
+        if(forNode->assignment != nullptr)
+            forNode->assignment->accept(this);
+        patch(put(jit::stencil::JUMP), loop);
+        patch(exit, code.size());
+        next = _next;
+        scopes.pop_back();
+    }
+
+    void JIT::visit(parser::ASTWhileNode *whileNode) {
+        auto loop = code.size();
+        whileNode->condition->accept(this);
+        condition(currentType);
+        auto exit = put(jit::stencil::JUMP_IF_FALSE);
+        whileNode->loopBlock->accept(this);
+        patch(put(jit::stencil::JUMP), loop);
+        patch(exit, code.size());
+    }
+
+    void JIT::visit(parser::ASTReturnNode *returnNode) {
+        returnNode->exprNode->accept(this);
+        // auto functions have the type of their first return
+        if(type == "auto" && numeric(currentType))
+            type = currentType;
+        if(currentType != type)
+            throw jit::UnsupportedException();
+        put(jit::stencil::RETURN);
+    }
+
+    void JIT::visit(parser::ASTProgramNode *programNode) {
+        throw jit::UnsupportedException();
+    }
+
+    void JIT::visit(parser::ASTStructNode *structNode) {
+        throw jit::UnsupportedException();
+    }
+    // Statements
+}
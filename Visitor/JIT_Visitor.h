@@ -0,0 +1,101 @@
+//
+// Stitches the stencils of a numeric function into machine code for the JIT.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_JIT_VISITOR_H
+#define TEALANG_COMPILER_CPP20_JIT_VISITOR_H
+
+#include "Visitor.h"
+#include "../JIT/JIT.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jit {
+    // A variable of the compiled function, an array parameter takes two slots
+    // (the address of its first element then its size)
+    class Slot {
+    public:
+        Slot(int slot, std::string type, bool array) :
+                slot(slot),
+                type(std::move(type)),
+                array(array)
+        {};
+
+        int slot;
+        std::string type;
+        bool array;
+    };
+}
+
+namespace visitor {
+    // Only functions whose variables are int, float or bool (and parameters that are arrays of int or float)
+    // and that only call themselves are compiled, anything else throws jit::UnsupportedException
+    class JIT : public Visitor {
+    public:
+        // shape holds the tags of the arguments the function is compiled for
+        explicit JIT(std::vector<int> shape);
+        ~JIT() = default;
+
+        std::vector<std::uint8_t> code;
+        // the return type and the slots used by a call
+        std::string type;
+        int frame;
+
+        // Whether a block has a loop (a function with a loop is worth compiling on its first call)
+        static bool loops(parser::ASTBlockNode* blockNode);
+
+        void visit(parser::ASTProgramNode* programNode) override;
+
+        void visit(parser::ASTLiteralNode<int>* literalNode) override;
+        void visit(parser::ASTLiteralNode<float>* literalNode) override;
+        void visit(parser::ASTLiteralNode<bool>* literalNode) override;
+        void visit(parser::ASTLiteralNode<char>* literalNode) override;
+        void visit(parser::ASTLiteralNode<std::string>* literalNode) override;
+        void visit(parser::ASTArrayLiteralNode* arrayLiteralNode) override;
+        void visit(parser::ASTBinaryNode* binaryNode) override;
+        void visit(parser::ASTIdentifierNode* identifierNode) override;
+        void visit(parser::ASTUnaryNode* unaryNode) override;
+        void visit(parser::ASTSpawnNode* spawnNode) override;
+        void visit(parser::ASTAwaitNode* awaitNode) override;
+        void visit(parser::ASTFunctionCallNode* functionCallNode) override;
+
+        void visit(parser::ASTSFunctionCallNode* sFunctionCallNode) override;
+        void visit(parser::ASTDeclarationNode* declarationNode) override;
+        void visit(parser::ASTAssignmentNode* assignmentNode) override;
+        void visit(parser::ASTPrintNode* printNode) override;
+        void visit(parser::ASTBlockNode* blockNode) override;
+        void visit(parser::ASTIfNode* ifNode) override;
+        void visit(parser::ASTForNode* forNode) override;
+        void visit(parser::ASTWhileNode* whileNode) override;
+        void visit(parser::ASTFunctionDeclarationNode* functionDeclarationNode) override;
+        void visit(parser::ASTReturnNode* returnNode) override;
+        void visit(parser::ASTStructNode* structNode) override;
+
+    private:
+        std::vector<int> shape;
+        parser::ASTFunctionDeclarationNode* function;
+        // type of the last expression, its value is in eax
+        std::string currentType;
+
+        // The block scopes of the function, innermost last
+        std::vector<std::map<std::string, jit::Slot>> scopes;
+        int next;
+        // The holes of the jumps to the bail out code
+        std::vector<std::size_t> bails;
+        // The holes that depend on the size of the frame, {hole: bytes added to the frame}
+        std::vector<std::pair<std::size_t, std::int32_t>> framed;
+
+        // Copy a stencil to the end of the code with its operand patched in, returns the offset of its hole
+        std::size_t put(const jit::Stencil& stencil, std::int32_t operand = 0);
+        // Point the jump whose hole is at hole to target
+        void patch(std::size_t hole, std::size_t target);
+        // A numeric (int, float or bool) slot for a new variable in the innermost scope
+        jit::Slot declare(const std::string& identifier, const std::string& type);
+        jit::Slot lookup(const std::string& identifier);
+    };
+}
+
+#endif //TEALANG_COMPILER_CPP20_JIT_VISITOR_H
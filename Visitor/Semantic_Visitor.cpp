@@ -103,7 +103,80 @@ namespace semantic{
             return false;
         }
     }
+
+    std::string Scope::describe(const Variable& v){
+        auto result = find(v);
+        if(!found(result)) return "";
+        return result->second.type + (result->second.array ? "[]" : "");
+    }
+
+    std::string Scope::describe(const Function& f){
+        auto result = find(f);
+        if(!found(result)) return "";
+        return result->second.type;
+    }
+
+    std::string Scope::describe(const Struct& s){
+        auto result = find(s);
+        if(!found(result)) return "";
+        // a struct is described by its members
+        std::string description = "tlstruct{";
+        for(const auto& variable : result->second.variables)
+            description += variable.identifier + ":" + variable.type + ";";
+        for(const auto& function : result->second.functions){
+            description += function.identifier + "(";
+            for(const auto& type : function.paramTypes)
+                description += type + ",";
+            description += "):" + function.type + ";";
+        }
+        return description + "}";
+    }
     // Semantic Scope
+
+    // Dependency
+    bool Dependency::holds(Scope& scope) const {
+        switch (kind) {
+            case VARIABLE:
+                return scope.describe(Variable(identifier)) == answer;
+            case FUNCTION:
+                return scope.describe(Function(identifier, paramTypes)) == answer;
+            case STRUCT:
+                return scope.describe(Struct(identifier)) == answer;
+        }
+        return false;
+    }
+
+    std::string Dependency::key() const {
+        std::string k = std::to_string(kind) + identifier;
+        for(const auto& type : paramTypes)
+            k += "," + type;
+        return k;
+    }
+    // Dependency
+
+    // Summary
+    void Summary::depend(const Dependency& d) {
+        // Only the first answer counts, later lookups may see what the statement itself declared
+        dependencies.insert(std::make_pair(d.key(), d));
+    }
+
+    bool Summary::holds(Scope& scope) const {
+        for(const auto& dependency : dependencies){
+            if(!dependency.second.holds(scope))
+                return false;
+        }
+        return true;
+    }
+
+    void Summary::apply(Scope& scope) const {
+        for(const auto& variable : variables)
+            scope.insert(variable);
+        for(const auto& function : functions)
+            scope.insert(function);
+        for(const auto& s : structs)
+            scope.insert(s);
+    }
+    // Summary
 }
 
 namespace visitor{
@@ -112,11 +185,145 @@ namespace visitor{
 
     // Program
     void SemanticAnalyser::visit(parser::ASTProgramNode *programNode) {
-        scopes.emplace_back(std::make_shared<semantic::Scope>(true));
-        // For each statement, accept
-        for(auto &statement : programNode -> statements)
-            statement -> accept(this);
-        scopes.pop_back();
+        auto global = std::make_shared<semantic::Scope>(true);
+        scopes.emplace_back(global);
+        // Errors are stored against the index of the top level statement they were found in
+        // so that the reported order never depends on which thread finished first
+        std::vector<std::pair<std::size_t, std::string>> diagnostics;
+        // Statements from the first error onwards are not checked
+        std::size_t limit = programNode -> statements.size();
+
+        // Phase 1
+        // Collect the signatures of the typed functions so that their blocks can be checked independently
+        std::vector<std::size_t> deferred;
+        declarations = std::make_shared<std::map<std::pair<std::string, std::vector<std::string>>, parser::ASTFunctionDeclarationNode*>>();
+        for(std::size_t i = 0; i < limit; ++i){
+            auto functionDeclarationNode = dynamic_cast<parser::ASTFunctionDeclarationNode*>(programNode -> statements.at(i).get());
+            if(functionDeclarationNode != nullptr){
+                std::vector<std::string> paramTypes;
+                for(const auto& param : functionDeclarationNode -> parameters)
+                    paramTypes.emplace_back(param.second);
+                declarations -> insert(std::make_pair(std::make_pair(functionDeclarationNode -> identifier -> getID(), paramTypes), functionDeclarationNode));
+            }
+            // auto functions only get their type from their block so they are checked in order with the rest
+            if(functionDeclarationNode == nullptr || functionDeclarationNode -> type == "auto")
+                continue;
+            try{
+                declare(functionDeclarationNode, global);
+                deferred.emplace_back(i);
+            }catch(const std::exception& e){
+                diagnostics.emplace_back(i, e.what());
+                limit = i;
+            }
+        }
+        // Go over the remaining statements in order, this fills in the globals, structs and auto functions
+        // A statement is only checked again if its content or anything it looked up in the global scope changed
+        std::map<std::uint64_t, semantic::Summary> next;
+        auto positions = std::make_shared<std::map<std::string, std::size_t>>();
+        auto place = [&](const semantic::Summary& summary, std::size_t i){
+            for(const auto& variable : summary.variables)
+                positions -> emplace(semantic::Dependency(semantic::Dependency::VARIABLE, variable.identifier, {}, "").key(), i);
+            for(const auto& f : summary.functions)
+                positions -> emplace(semantic::Dependency(semantic::Dependency::FUNCTION, f.identifier, f.paramTypes, "").key(), i);
+            for(const auto& s : summary.structs)
+                positions -> emplace(semantic::Dependency(semantic::Dependency::STRUCT, s.identifier, {}, "").key(), i);
+        };
+        checked = 0;
+        reused = 0;
+        HashVisitor hashVisitor;
+        for(std::size_t i = 0; i < limit; ++i){
+            if(std::binary_search(deferred.begin(), deferred.end(), i))
+                continue;
+            auto statement = programNode -> statements.at(i).get();
+            auto hash = hashVisitor.hash(statement);
+            auto previous = summaries.find(hash);
+            if(previous != summaries.end() && previous -> second.holds(*global)){
+                previous -> second.apply(*global);
+                place(previous -> second, i);
+                next.insert(*previous);
+                ++reused;
+                continue;
+            }
+            ++checked;
+            semantic::Summary summary;
+            recording = &summary;
+            try{
+                statement -> accept(this);
+                recording = nullptr;
+                summarise(statement, summary);
+                place(summary, i);
+                next.insert(std::make_pair(hash, summary));
+            }catch(const std::exception& e){
+                recording = nullptr;
+                diagnostics.emplace_back(i, e.what());
+                limit = i;
+            }
+        }
+
+        // Phase 2
+        // The global scope is complete and only read from here on
+        // Each function block is checked by its own analyser (and scopes) on the thread pool
+        // Globals added after a function are hidden from its block as if it had been checked in program order
+        while(!deferred.empty() && deferred.back() >= limit)
+            deferred.pop_back();
+        std::vector<std::string> errors(deferred.size());
+        std::vector<std::uint64_t> hashes(deferred.size());
+        // null when the previous summary was reused
+        std::vector<std::unique_ptr<semantic::Summary>> fresh(deferred.size());
+        concurrency::parallelFor(0, deferred.size(), 1, [&](std::size_t j){
+            auto functionDeclarationNode = dynamic_cast<parser::ASTFunctionDeclarationNode*>(programNode -> statements.at(deferred.at(j)).get());
+            SemanticAnalyser analyser;
+            analyser.scopes.emplace_back(global);
+            analyser.declarations = declarations;
+            analyser.positions = positions;
+            analyser.horizon = deferred.at(j);
+            hashes.at(j) = HashVisitor().hash(functionDeclarationNode);
+            auto previous = summaries.find(hashes.at(j));
+            // the globals it found must still come before the function
+            if(previous != summaries.end() && previous -> second.holds(*global)
+               && std::all_of(previous -> second.dependencies.begin(), previous -> second.dependencies.end(),
+                              [&](const auto& dependency){ return analyser.visible(dependency.second); }))
+                return;
+            auto summary = std::make_unique<semantic::Summary>();
+            analyser.recording = summary.get();
+            try{
+                analyser.check(functionDeclarationNode, global);
+                fresh.at(j) = std::move(summary);
+            }catch(const std::exception& e){
+                errors.at(j) = e.what();
+            }
+        });
+        for(std::size_t j = 0; j < deferred.size(); ++j){
+            if(!errors.at(j).empty()){
+                diagnostics.emplace_back(deferred.at(j), errors.at(j));
+                ++checked;
+            }else if(fresh.at(j) != nullptr){
+                next.insert(std::make_pair(hashes.at(j), *fresh.at(j)));
+                ++checked;
+            }else{
+                next.insert(*summaries.find(hashes.at(j)));
+                ++reused;
+            }
+        }
+        // Keep the summaries of this version of the program only
+        summaries = std::move(next);
+        // a failed statement may have left its scopes behind
+        scopes.clear();
+        function = nullptr;
+        frame = nullptr;
+        members = nullptr;
+
+        // Merge the diagnostics in program order
+        if(!diagnostics.empty()){
+            std::stable_sort(diagnostics.begin(), diagnostics.end(),
+                             [](const auto& a, const auto& b){ return a.first < b.first; });
+            std::string message;
+            for(const auto& diagnostic : diagnostics){
+                if(!message.empty()) message += "\n";
+                message += diagnostic.second;
+            }
+            throw std::runtime_error(message);
+        }
     }
     // Program
 
@@ -248,16 +455,28 @@ namespace visitor{
         // There are 2 cases here
         // one where this is a normal variable (i.e. no '.')
         // the other when the identifier is referencing another variable
+        // Check the index, the identifiers inside it are resolved as well
+        if(identifierNode->ilocExprNode != nullptr){
+            auto _cType = currentType;
+            identifierNode->ilocExprNode->accept(this);
+            currentType = _cType;
+        }
         auto parent = parser::ASTIdentifierNode(identifierNode->identifier, identifierNode->getChild(), identifierNode->ilocExprNode, identifierNode->lineNumber);
         auto child = identifierNode->getChild();
         bool found = false;
+        if(child != nullptr){
+            // the instance the members are read from
+            identifierNode->slot = resolve(identifierNode->identifier);
+            identifierNode->offset = member(identifierNode->identifier);
+        }
         while(child != nullptr){
             // we have found a child
             // this means that the identifier of identifierNode must be a struct
             for(const auto& scope : scopes) {
                 // First find the variable (remember identifierNode->identifier is a variable of a type)
+                depend(scope, semantic::Variable(parent.identifier));
                 auto result = scope->find(semantic::Variable(parent.identifier));
-                if(scope->found(result)) {
+                if(scope->found(result) && visible(scope, semantic::Variable(parent.identifier))) {
                     // we found it, now does it have a struct type?
                     if(!lexer::isStruct(result->second.type)){
                         throw std::runtime_error("Variable with identifier " + parent.identifier + " called on line "
@@ -266,17 +485,22 @@ namespace visitor{
                     }
                     // get the struct
                     for(const auto& _scope : scopes) {
+                        depend(_scope, semantic::Struct(result->second.type));
                         auto struct_result = _scope->find(semantic::Struct(result->second.type));
-                        if(_scope->found(struct_result)) {
+                        if(_scope->found(struct_result) && visible(_scope, semantic::Struct(result->second.type))) {
                             // found the struct
                             // go over its variables and verify child.identifier is there
-                            for(auto var : struct_result->second.variables){
+                            // self is not stored in the instance so it does not take up a field
+                            int offset = 0;
+                            for(const auto& var : struct_result->second.variables){
                                 if(var.identifier == child->identifier) {
                                     //found
                                     found = true;
                                     currentType = var.type;
+                                    child->offset = var.identifier == "self" ? -1 : offset;
                                     break;
                                 }
+                                if(var.identifier != "self") ++offset;
                             }
                             if(found) break;
                         }
@@ -298,12 +522,15 @@ namespace visitor{
         }
 
         // normal variable case
+        identifierNode->slot = resolve(identifierNode->identifier);
+        identifierNode->offset = member(identifierNode->identifier);
         // Build variable shell
         semantic::Variable v(identifierNode->getID());
         // Check that a variable with this identifier exists
         for(const auto& scope : scopes) {
+            depend(scope, v);
             auto result = scope->find(v);
-            if(scope->found(result)) {
+            if(scope->found(result) && visible(scope, v)) {
                 // if identifier has been found
                 // change current Type
                 currentType = result->second.type;
@@ -339,6 +566,26 @@ namespace visitor{
         }
     }
 
+    void SemanticAnalyser::visit(parser::ASTSpawnNode *spawnNode) {
+        // Check the call as any other
+        spawnNode->call->accept(this);
+        // A task runs on its own, a method would share its instance with the caller
+        if(spawnNode->call->callee == nullptr)
+            throw std::runtime_error("Function with identifier " + spawnNode->call->identifier->getID() + " spawned on line "
+                                     + std::to_string(spawnNode->lineNumber) + " is not a global function. Only global functions can be spawned.");
+        // the handle of a task is typed by its result
+        currentType = "task<" + currentType + ">";
+    }
+
+    void SemanticAnalyser::visit(parser::ASTAwaitNode *awaitNode) {
+        awaitNode->exprNode->accept(this);
+        if(currentType.size() < 6 || currentType.compare(0, 5, "task<") != 0 || currentType.back() != '>')
+            throw std::runtime_error("Expression awaited on line " + std::to_string(awaitNode->lineNumber) + " is of type "
+                                     + currentType + ". Only the handle of a spawned call can be awaited.");
+        // the type of the result
+        currentType = currentType.substr(5, currentType.size() - 6);
+    }
+
     void SemanticAnalyser::visit(parser::ASTFunctionCallNode *functionCallNode) {
         // Check parameters
         std::vector<std::string> paramTypes;
@@ -362,8 +609,9 @@ namespace visitor{
             // this means that the identifier of identifierNode must be a struct
             for(const auto& scope : scopes) {
                 // First find the variable (remember identifierNode->identifier is a variable of a type)
+                depend(scope, semantic::Variable(parent.identifier));
                 auto result = scope->find(semantic::Variable(parent.identifier));
-                if(scope->found(result)) {
+                if(scope->found(result) && visible(scope, semantic::Variable(parent.identifier))) {
                     // we found it, now does it have a struct type?
                     if(!lexer::isStruct(result->second.type)){
                         throw std::runtime_error("Variable with identifier " + parent.identifier + " called on line "
@@ -372,8 +620,9 @@ namespace visitor{
                     }
                     // get the struct
                     for(const auto& _scope : scopes) {
+                        depend(_scope, semantic::Struct(result->second.type));
                         auto struct_result = _scope->find(semantic::Struct(result->second.type));
-                        if(_scope->found(struct_result)) {
+                        if(_scope->found(struct_result) && visible(_scope, semantic::Struct(result->second.type))) {
                             // found the struct
                             // go over its functions and verify child.identifier is there
                             for(auto func : struct_result->second.functions){
@@ -408,8 +657,10 @@ namespace visitor{
         semantic::Function f(functionCallNode->identifier->getID(), paramTypes);
         // Now confirm this exists in the function table for any scope
         for(const auto& scope : scopes){
+            depend(scope, f);
             auto result = scope->find(f);
-            if(scope->found(result)) {
+            if(scope->found(result) && visible(scope, f)) {
+                functionCallNode->callee = resolve(scope, f);
                 // change current type to the function return type
                 currentType = result->second.type;
                 // start going over the parameters in the function
@@ -453,8 +704,9 @@ namespace visitor{
             // this means that the identifier of identifierNode must be a struct
             for(const auto& scope : scopes) {
                 // First find the variable (remember identifierNode->identifier is a variable of a type)
+                depend(scope, semantic::Variable(parent.identifier));
                 auto result = scope->find(semantic::Variable(parent.identifier));
-                if(scope->found(result)) {
+                if(scope->found(result) && visible(scope, semantic::Variable(parent.identifier))) {
                     // we found it, now does it have a struct type?
                     if(!lexer::isStruct(result->second.type)){
                         throw std::runtime_error("Variable with identifier " + parent.identifier + " called on line "
@@ -463,8 +715,9 @@ namespace visitor{
                     }
                     // get the struct
                     for(const auto& _scope : scopes) {
+                        depend(_scope, semantic::Struct(result->second.type));
                         auto struct_result = _scope->find(semantic::Struct(result->second.type));
-                        if(_scope->found(struct_result)) {
+                        if(_scope->found(struct_result) && visible(_scope, semantic::Struct(result->second.type))) {
                             // found the struct
                             // go over its functions and verify child.identifier is there
                             for(auto func : struct_result->second.functions){
@@ -499,8 +752,10 @@ namespace visitor{
         semantic::Function f(sFunctionCallNode->identifier->getID(), paramTypes);
         // Now confirm this exists in the function table for any scope
         for(const auto& scope : scopes){
+            depend(scope, f);
             auto result = scope->find(f);
-            if(scope->found(result)) {
+            if(scope->found(result) && visible(scope, f)) {
+                sFunctionCallNode->callee = resolve(scope, f);
                 // change current type to the function return type
                 currentType = result->second.type;
                 // start going over the parameters in the function
@@ -528,6 +783,7 @@ namespace visitor{
         // Check current scope
         auto scope = scopes.back();
         // Try to insert v
+        depend(scope, v);
         auto result = scope->find(v);
         // compare the found key and the actual key
         // if identical than the variable is already declared
@@ -537,6 +793,9 @@ namespace visitor{
                                      + std::to_string(declarationNode->lineNumber) + " already declared on line "
                                      + std::to_string(result->second.lineNumber));
         }
+        // Check the size of an array, the identifiers inside it are resolved as well
+        if(declarationNode->identifier->ilocExprNode != nullptr)
+            declarationNode->identifier->ilocExprNode->accept(this);
         // by changing the current type we help to init an array literal
         // if not an array this will be overwritten by the visit
         // if not visited then this should be auto or struct
@@ -664,27 +923,26 @@ namespace visitor{
     }
 
     void SemanticAnalyser::visit(parser::ASTFunctionDeclarationNode *functionDeclarationNode) {
-        // If current scope is not global then do not allow declaration
         auto scope = scopes.back();
+        declare(functionDeclarationNode, scope);
+        check(functionDeclarationNode, scope);
+    }
+
+    void SemanticAnalyser::declare(parser::ASTFunctionDeclarationNode *functionDeclarationNode, const std::shared_ptr<semantic::Scope>& scope) {
+        // If current scope is not global then do not allow declaration
         if (!scope->isFunctionDeclarable()){
             throw std::runtime_error("Tried declaring function with identifier " + functionDeclarationNode->identifier->getID()
                                      + " in a non-global scope.");
         }
-        // Create new scope for function params
-        // This allows the creation of a new variables when they are params
-        scopes.emplace_back(std::make_shared<semantic::Scope>());
         // Generate Function
         // First get the param types vector
         std::vector<std::string> paramTypes;
-        for (const auto& param : functionDeclarationNode->parameters){
+        for (const auto& param : functionDeclarationNode->parameters)
             paramTypes.emplace_back(param.second);
-            // While going over the types add these to the new scope // arrau or not here it is irrelevant
-            scopes.back()->insert(semantic::Variable(param.second, param.first, true, functionDeclarationNode->lineNumber));
-        }
-        // NOTE: The scope variable is still viewing the global scope
         // now generate the function object
         semantic::Function f(functionDeclarationNode->type, functionDeclarationNode->identifier->getID(), paramTypes, functionDeclarationNode->lineNumber);
         // Try to insert f
+        depend(scope, f);
         auto result = scope->find(f);
         // compare the found key and the actual key
         // if identical than the function is already declared
@@ -696,9 +954,31 @@ namespace visitor{
         }
         // insert function to the function table, this allows for recursion to happen
         scope->insert(f);
+    }
+
+    void SemanticAnalyser::check(parser::ASTFunctionDeclarationNode *functionDeclarationNode, const std::shared_ptr<semantic::Scope>& scope) {
+        // Create new scope for function params
+        // This allows the creation of a new variables when they are params
+        scopes.emplace_back(std::make_shared<semantic::Scope>());
+        std::vector<std::string> paramTypes;
+        for (const auto& param : functionDeclarationNode->parameters){
+            paramTypes.emplace_back(param.second);
+            // While going over the types add these to the new scope // arrau or not here it is irrelevant
+            scopes.back()->insert(semantic::Variable(param.second, param.first, true, functionDeclarationNode->lineNumber));
+        }
+        // NOTE: The scope variable is still viewing the global scope
+        semantic::Function f(functionDeclarationNode->type, functionDeclarationNode->identifier->getID(), paramTypes, functionDeclarationNode->lineNumber);
+        // the parameters used in the block are resolved to their slot in the call frame
+        auto _function = function;
+        auto _frame = frame;
+        function = functionDeclarationNode;
+        frame = scopes.back();
         // Go check the block node
         returns = false;
         functionDeclarationNode->functionBlock->accept(this);
+        function = _function;
+        frame = _frame;
+        functionDeclarationNode->resolved = true;
         // confirm function has a return and that the return type is as defined in the declaration node
         if(!returns){
             throw std::runtime_error("Function with identifier " + functionDeclarationNode->identifier->getID() + " declared on line "
@@ -733,6 +1013,114 @@ namespace visitor{
         scopes.pop_back();
     }
 
+    parser::ASTFunctionDeclarationNode* SemanticAnalyser::resolve(const std::shared_ptr<semantic::Scope>& scope, const semantic::Function& f) {
+        // only global functions have a single declaration, struct methods are registered per instance
+        if(declarations == nullptr || scope != scopes.front())
+            return nullptr;
+        auto result = declarations->find(std::make_pair(f.identifier, f.paramTypes));
+        return result != declarations->end() ? result->second : nullptr;
+    }
+
+    int SemanticAnalyser::resolve(const std::string& identifier) {
+        if(frame == nullptr)
+            return -1;
+        // Unlike the type checks, the innermost declaration is the one that is used at runtime
+        semantic::Variable v(identifier);
+        for(auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope){
+            auto result = (*scope)->find(v);
+            if((*scope)->found(result)){
+                if(*scope != frame)
+                    return -1;
+                for(int i = 0; i < function->parameters.size(); ++i)
+                    if(function->parameters.at(i).first == v.identifier)
+                        return i;
+                return -1;
+            }
+            // the scopes outside the function are not part of the frame
+            if(*scope == frame)
+                return -1;
+        }
+        return -1;
+    }
+
+    int SemanticAnalyser::member(const std::string& identifier) {
+        if(members == nullptr || identifier == "self")
+            return -1;
+        // a member unless a declaration inside the methods shadows it
+        semantic::Variable v(identifier);
+        for(auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope){
+            if((*scope)->found((*scope)->find(v))){
+                if(*scope != members)
+                    return -1;
+                // the fields of the instance are the members in declaration order without self
+                auto s = structScope->find(semantic::Struct(structID));
+                int offset = 0;
+                for(const auto& var : s->second.variables){
+                    if(var.identifier == identifier)
+                        return offset;
+                    if(var.identifier != "self") ++offset;
+                }
+                return -1;
+            }
+        }
+        return -1;
+    }
+
+    void SemanticAnalyser::depend(const std::shared_ptr<semantic::Scope>& scope, const semantic::Variable& v) {
+        if(recording != nullptr && scope == scopes.front())
+            recording->depend(semantic::Dependency(semantic::Dependency::VARIABLE, v.identifier, {}, scope->describe(v)));
+    }
+
+    void SemanticAnalyser::depend(const std::shared_ptr<semantic::Scope>& scope, const semantic::Function& f) {
+        if(recording != nullptr && scope == scopes.front())
+            recording->depend(semantic::Dependency(semantic::Dependency::FUNCTION, f.identifier, f.paramTypes, scope->describe(f)));
+    }
+
+    void SemanticAnalyser::depend(const std::shared_ptr<semantic::Scope>& scope, const semantic::Struct& s) {
+        if(recording != nullptr && scope == scopes.front())
+            recording->depend(semantic::Dependency(semantic::Dependency::STRUCT, s.identifier, {}, scope->describe(s)));
+    }
+
+    bool SemanticAnalyser::visible(const std::shared_ptr<semantic::Scope>& scope, const semantic::Variable& v) {
+        return scope != scopes.front() || visible(semantic::Dependency(semantic::Dependency::VARIABLE, v.identifier, {}, ""));
+    }
+
+    bool SemanticAnalyser::visible(const std::shared_ptr<semantic::Scope>& scope, const semantic::Function& f) {
+        return scope != scopes.front() || visible(semantic::Dependency(semantic::Dependency::FUNCTION, f.identifier, f.paramTypes, ""));
+    }
+
+    bool SemanticAnalyser::visible(const std::shared_ptr<semantic::Scope>& scope, const semantic::Struct& s) {
+        return scope != scopes.front() || visible(semantic::Dependency(semantic::Dependency::STRUCT, s.identifier, {}, ""));
+    }
+
+    bool SemanticAnalyser::visible(const semantic::Dependency& d) {
+        if(positions == nullptr)
+            return true;
+        auto position = positions -> find(d.key());
+        return position == positions -> end() || position -> second < horizon;
+    }
+
+    void SemanticAnalyser::summarise(parser::ASTStatementNode *statement, semantic::Summary &summary) {
+        // Copy whatever the statement added to the global scope
+        auto global = scopes.front();
+        if(auto declarationNode = dynamic_cast<parser::ASTDeclarationNode*>(statement)){
+            auto result = global->find(semantic::Variable(declarationNode->identifier->getID()));
+            if(global->found(result))
+                summary.variables.emplace_back(result->second);
+        }else if(auto structNode = dynamic_cast<parser::ASTStructNode*>(statement)){
+            auto result = global->find(semantic::Struct(structNode->identifier->getID()));
+            if(global->found(result))
+                summary.structs.emplace_back(result->second);
+        }else if(auto functionDeclarationNode = dynamic_cast<parser::ASTFunctionDeclarationNode*>(statement)){
+            std::vector<std::string> paramTypes;
+            for (const auto& param : functionDeclarationNode->parameters)
+                paramTypes.emplace_back(param.second);
+            auto result = global->find(semantic::Function(functionDeclarationNode->identifier->getID(), paramTypes));
+            if(global->found(result))
+                summary.functions.emplace_back(result->second);
+        }
+    }
+
     void SemanticAnalyser::visit(parser::ASTReturnNode *returnNode) {
         // Ensure returns is false
         if(returns){
@@ -750,6 +1138,7 @@ namespace visitor{
         // Generate a dummy struct object
         semantic::Struct s(structNode->identifier->getID());
         // Try to insert f
+        depend(scope, s);
         auto result = scope->find(s);
         // compare the found key and the actual key
         // if identical than the struct is already declared
@@ -767,12 +1156,14 @@ namespace visitor{
         structID = s.identifier;
         structScope = scope;
         scopes.emplace_back(std::make_shared<semantic::Scope>(true));
+        members = scopes.back();
         // Visit each statement in the block
         for(auto &statement : structNode->structBlock -> statements)
             statement -> accept(this);
         // Close scope
         structID = "";
         structScope = nullptr;
+        members = nullptr;
         scopes.pop_back();
     }
     // Statements
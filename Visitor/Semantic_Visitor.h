@@ -11,7 +11,10 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <algorithm>
 #include "../Lexer/Token.h"
+#include "../Concurrency/Thread_Pool.h"
+#include "Hash_Visitor.h"
 
 namespace semantic {
     class ReturnsException : public std::exception {
@@ -135,6 +138,58 @@ namespace semantic {
         bool found(std::_Rb_tree_iterator<std::pair<const std::basic_string<char, std::char_traits<char>, std::allocator<char>>, Struct>> result);
 
         bool erase(std::_Rb_tree_iterator<std::pair<const std::pair<std::basic_string<char, std::char_traits<char>, std::allocator<char>>, std::vector<std::basic_string<char, std::char_traits<char>, std::allocator<char>>>>, Function>> result);
+
+        // Describe what the scope holds for a variable, function or struct (empty if nothing)
+        // Two equal descriptions mean that a check depending on it would give the same result
+        std::string describe(const Variable& v);
+        std::string describe(const Function& f);
+        std::string describe(const Struct& s);
+    };
+
+    // A lookup that a top level statement made in the global scope and the answer it got
+    class Dependency {
+    public:
+        enum KIND {VARIABLE, FUNCTION, STRUCT};
+
+        Dependency(KIND kind, std::string identifier, std::vector<std::string> paramTypes, std::string answer) :
+                kind(kind),
+                identifier(std::move(identifier)),
+                paramTypes(std::move(paramTypes)),
+                answer(std::move(answer))
+        {};
+        ~Dependency() = default;
+
+        KIND kind;
+        std::string identifier;
+        std::vector<std::string> paramTypes;
+        std::string answer;
+
+        // Does the scope still give the same answer?
+        bool holds(Scope& scope) const;
+        // Lookups of the same variable, function or struct share a key
+        [[nodiscard]] std::string key() const;
+    };
+
+    // Outcome of successfully checking a top level statement
+    // Python equivalent of:
+    // summary = {dependencies: {key: Dependency}, variables: [], functions: [], structs: []}
+    class Summary {
+    public:
+        Summary() = default;
+        ~Summary() = default;
+
+        // The edges of the dependency graph, a statement depends on every global it looked up
+        std::map<std::string, Dependency> dependencies;
+        // What the statement added to the global scope
+        std::vector<Variable> variables;
+        std::vector<Function> functions;
+        std::vector<Struct> structs;
+
+        void depend(const Dependency& d);
+        // Is the summary still valid against the scope?
+        bool holds(Scope& scope) const;
+        // Add the variables, functions and structs to the scope without checking the statement again
+        void apply(Scope& scope) const;
     };
 }
 
@@ -148,6 +203,11 @@ namespace visitor {
             structID = std::string();
             returns = false;
             structScope = std::shared_ptr<semantic::Scope>();
+            recording = nullptr;
+            function = nullptr;
+            horizon = 0;
+            checked = 0;
+            reused = 0;
         };
         ~SemanticAnalyser() = default;
 
@@ -157,6 +217,13 @@ namespace visitor {
         std::shared_ptr<semantic::Scope> structScope;
         bool returns;
 
+        // Summaries of the statements checked in the previous run keyed by their content hash
+        // Only statements whose hash or dependencies changed are checked again
+        std::map<std::uint64_t, semantic::Summary> summaries;
+        // Statements checked and reused by the last run
+        unsigned int checked;
+        unsigned int reused;
+
         void visit(parser::ASTProgramNode* programNode) override;
 
         void visit(parser::ASTLiteralNode<int>* literalNode) override;
@@ -168,6 +235,8 @@ namespace visitor {
         void visit(parser::ASTBinaryNode* binaryNode) override;
         void visit(parser::ASTIdentifierNode* identifierNode) override;
         void visit(parser::ASTUnaryNode* unaryNode) override;
+        void visit(parser::ASTSpawnNode* spawnNode) override;
+        void visit(parser::ASTAwaitNode* awaitNode) override;
         void visit(parser::ASTFunctionCallNode* functionCallNode) override;
 
         void visit(parser::ASTSFunctionCallNode* sFunctionCallNode) override;
@@ -181,6 +250,48 @@ namespace visitor {
         void visit(parser::ASTFunctionDeclarationNode* functionDeclarationNode) override;
         void visit(parser::ASTReturnNode* returnNode) override;
         void visit(parser::ASTStructNode* structNode) override;
+
+    private:
+        // summary of the statement being checked
+        semantic::Summary* recording;
+
+        // The top level function declarations of the program being checked, calls to them are resolved to the declaration
+        // Python equivalent of:
+        // declarations = {{identifier, [ARGUMENT_TYPES,]}: functionDeclarationNode}
+        std::shared_ptr<std::map<std::pair<std::string, std::vector<std::string>>, parser::ASTFunctionDeclarationNode*>> declarations;
+        // The index of the top level statement each global variable, struct and auto function was added by (keyed as
+        // Dependency::key) and the index of the function being checked. A function block is checked against the complete
+        // global scope but may only see what was declared before the function, null when checking in program order
+        std::shared_ptr<std::map<std::string, std::size_t>> positions;
+        std::size_t horizon;
+        // The function being checked and the scope of its parameters, identifiers found there are given their slot
+        parser::ASTFunctionDeclarationNode* function;
+        std::shared_ptr<semantic::Scope> frame;
+        // The scope of the members of the struct being checked
+        std::shared_ptr<semantic::Scope> members;
+
+        // Record a lookup made in scope into the summary being built, only lookups in the global scope are kept
+        void depend(const std::shared_ptr<semantic::Scope>& scope, const semantic::Variable& v);
+        void depend(const std::shared_ptr<semantic::Scope>& scope, const semantic::Function& f);
+        void depend(const std::shared_ptr<semantic::Scope>& scope, const semantic::Struct& s);
+        // Was what the lookup found in scope declared before the statement being checked?
+        bool visible(const std::shared_ptr<semantic::Scope>& scope, const semantic::Variable& v);
+        bool visible(const std::shared_ptr<semantic::Scope>& scope, const semantic::Function& f);
+        bool visible(const std::shared_ptr<semantic::Scope>& scope, const semantic::Struct& s);
+        bool visible(const semantic::Dependency& d);
+        // Fill in what a checked top level statement added to the global scope
+        void summarise(parser::ASTStatementNode* statement, semantic::Summary& summary);
+
+        // Registers the function signature in scope (the global scope for top level functions)
+        void declare(parser::ASTFunctionDeclarationNode* functionDeclarationNode, const std::shared_ptr<semantic::Scope>& scope);
+        // Checks the block of a declared function against its signature
+        void check(parser::ASTFunctionDeclarationNode* functionDeclarationNode, const std::shared_ptr<semantic::Scope>& scope);
+        // Resolve a call to the declaration of the global function it calls (if any)
+        parser::ASTFunctionDeclarationNode* resolve(const std::shared_ptr<semantic::Scope>& scope, const semantic::Function& f);
+        // The frame slot of the parameter an identifier refers to, -1 if it refers to something else
+        int resolve(const std::string& identifier);
+        // The field offset of the member of the struct being checked an identifier refers to, -1 if it refers to something else
+        int member(const std::string& identifier);
     };
 }
 
@@ -0,0 +1,653 @@
+//
+// Translates a checked program into a self-contained C++20 translation unit.
+//
+
+#include "Transpiler_Visitor.h"
+#include <algorithm>
+#include <charconv>
+
+namespace visitor {
+    namespace {
+        // the runtime is embedded by the build from Runtime/Runtime.h
+        const char* const runtime =
+#include "Runtime.inc"
+        ;
+
+        // The type of the elements of an array type
+        std::string element(const std::string& type) {
+            if(type.size() > 2 && type.compare(type.size() - 2, 2, "[]") == 0)
+                return type.substr(0, type.size() - 2);
+            return type;
+        }
+
+        std::string escape(const std::string& s) {
+            std::string result;
+            for(unsigned char c : s){
+                if(c == '\\' || c == '"'){
+                    result += '\\';
+                    result += (char) c;
+                }else if(c == '\n'){
+                    result += "\\n";
+                }else if(c < 0x20 || c >= 0x7f){
+                    // octal escapes always take three digits so the next character is never part of them
+                    char octal[5] = {'\\', (char) ('0' + (c >> 6)), (char) ('0' + ((c >> 3) & 7)), (char) ('0' + (c & 7)), 0};
+                    result += octal;
+                }else{
+                    result += (char) c;
+                }
+            }
+            return result;
+        }
+
+        bool comparison(const std::string& op) {
+            auto type = lexer::determineOperatorType(op);
+            return type == lexer::TOK_LESS_THAN || type == lexer::TOK_MORE_THAN || type == lexer::TOK_LESS_THAN_EQUAL_TO
+                   || type == lexer::TOK_MORE_THAN_EQUAL_TO || type == lexer::TOK_EQAUL_TO || type == lexer::TOK_NOT_EQAUL_TO
+                   || type == lexer::TOK_AND || type == lexer::TOK_OR;
+        }
+    }
+
+    Transpiler::Transpiler() :
+            calls(false),
+            out(&main),
+            indent(0),
+            function(nullptr),
+            structure(nullptr)
+    {}
+
+    std::string Transpiler::source() const {
+        std::stringstream s;
+        s << runtime << "\n";
+        s << forward.str() << "\n" << structures.str() << prototypes.str() << "\n";
+        for(const auto& global : globals){
+            if(global.second.empty())
+                continue;
+            s << cpp(global.second) << " " << name(global.first) << ";\n";
+        }
+        s << "\n" << definitions.str();
+        s << "int main() {\n" << main.str() << "    return 0;\n}\n";
+        return s.str();
+    }
+
+    std::string Transpiler::cpp(const std::string &type) {
+        if(type != element(type))
+            return "tl::Array<" + cpp(element(type)) + ">";
+        if(type == "string")
+            return "std::string";
+        if(type == "int" || type == "float" || type == "bool" || type == "char" || type == "auto")
+            return type;
+        return name(type);
+    }
+
+    std::string Transpiler::name(const std::string &identifier) {
+        return "tl_" + identifier;
+    }
+
+    std::string Transpiler::typeOf(parser::ASTDeclarationNode *declarationNode) {
+        if(declarationNode->identifier->ilocExprNode == nullptr)
+            return declarationNode->type;
+        // nothing is stored for arrays of structs
+        if(lexer::isStruct(declarationNode->type))
+            return "";
+        return declarationNode->type + "[]";
+    }
+
+    std::string Transpiler::field(const interpreter::Struct &layout, std::size_t offset) {
+        auto types = fields.find(layout.id);
+        if(types != fields.end() && offset < types->second.size())
+            return types->second.at(offset);
+        return typeOf(layout.fields.at(offset));
+    }
+
+    std::string Transpiler::lookup(const std::string &identifier) {
+        // the innermost declaration, then the members of the instance, then the globals
+        for(auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope){
+            auto result = scope->find(identifier);
+            if(result != scope->end())
+                return result->second;
+        }
+        if(structure != nullptr){
+            auto offset = structure->offsets.find(identifier);
+            if(offset != structure->offsets.end())
+                return field(*structure, offset->second);
+            if(identifier == "self")
+                return structure->id;
+        }
+        auto result = globals.find(identifier);
+        if(result != globals.end())
+            return result->second;
+        // Should never get here because of the semantic pass
+        throw std::runtime_error("Variable with identifier " + identifier + " has not been declared.");
+    }
+
+    std::stringstream &Transpiler::line() {
+        *out << std::string(indent * 4, ' ');
+        return *out;
+    }
+
+    void Transpiler::block(parser::ASTBlockNode *blockNode) {
+        *out << "{\n";
+        ++indent;
+        scopes.emplace_back();
+        for(auto &s : blockNode->statements)
+            s->accept(this);
+        scopes.pop_back();
+        --indent;
+        line() << "}";
+    }
+
+    std::string Transpiler::result(parser::ASTFunctionDeclarationNode *functionDeclarationNode) {
+        if(functionDeclarationNode->type != "auto")
+            return functionDeclarationNode->type;
+        auto type = types.find(functionDeclarationNode);
+        return type != types.end() ? type->second : std::string("auto");
+    }
+
+    void Transpiler::visit(parser::ASTProgramNode *programNode) {
+        // The layouts, functions and globals are known before any code is translated
+        // so that the functions can use the globals declared after them
+        for(auto &s : programNode->statements){
+            if(auto structNode = dynamic_cast<parser::ASTStructNode*>(s.get())){
+                structs.insert_or_assign(structNode->identifier->getID(), interpreter::Struct(structNode));
+            }else if(auto functionDeclarationNode = dynamic_cast<parser::ASTFunctionDeclarationNode*>(s.get())){
+                functions.insert(std::make_pair(functionDeclarationNode->identifier->getID(), functionDeclarationNode));
+            }else if(auto declarationNode = dynamic_cast<parser::ASTDeclarationNode*>(s.get())){
+                globals.insert_or_assign(declarationNode->identifier->getID(), typeOf(declarationNode));
+            }
+        }
+
+        // The structs then the functions, in program order
+        std::vector<parser::ASTFunctionDeclarationNode*> declarations;
+        for(auto &s : programNode->statements){
+            if(auto structNode = dynamic_cast<parser::ASTStructNode*>(s.get())){
+                construct(structs.at(structNode->identifier->getID()));
+            }else if(auto functionDeclarationNode = dynamic_cast<parser::ASTFunctionDeclarationNode*>(s.get())){
+                compile(functionDeclarationNode, nullptr);
+                declarations.emplace_back(functionDeclarationNode);
+            }
+        }
+        // the return types of auto functions are only known once they are translated
+        for(auto functionDeclarationNode : declarations)
+            prototypes << signature(functionDeclarationNode, "") << ";\n";
+
+        // The top level statements, the globals they declare are assigned
+        out = &main;
+        indent = 1;
+        for(auto &s : programNode->statements)
+            s->accept(this);
+        for(const auto& global : globals)
+            if(global.second == "auto")
+                throw std::runtime_error("The type of global variable " + global.first + " can not be determined.");
+    }
+
+    std::string Transpiler::signature(parser::ASTFunctionDeclarationNode *functionDeclarationNode, const std::string &owner) {
+        // a parameter may hold an array of its type
+        std::string parameters;
+        for(const auto& parameter : functionDeclarationNode->parameters){
+            if(!parameters.empty())
+                parameters += ", ";
+            parameters += "tl::Of<" + cpp(parameter.second) + "> auto " + name(parameter.first);
+        }
+        return cpp(result(functionDeclarationNode)) + " " + (owner.empty() ? "" : name(owner) + "::")
+               + name(functionDeclarationNode->identifier->getID()) + "(" + parameters + ")";
+    }
+
+    void Transpiler::compile(parser::ASTFunctionDeclarationNode *functionDeclarationNode, interpreter::Struct *owner) {
+        function = functionDeclarationNode;
+        structure = owner;
+        scopes.emplace_back();
+        for(const auto& parameter : functionDeclarationNode->parameters)
+            scopes.back().insert_or_assign(parameter.first, parameter.second);
+        // The block is a scope of its own, C++ does not allow it to redeclare a parameter
+        const auto& statements = functionDeclarationNode->functionBlock->statements;
+        bool shadows = std::any_of(statements.begin(), statements.end(), [functionDeclarationNode](const auto& s){
+            auto declarationNode = dynamic_cast<parser::ASTDeclarationNode*>(s.get());
+            return declarationNode != nullptr && std::any_of(functionDeclarationNode->parameters.begin(), functionDeclarationNode->parameters.end(),
+                                                             [declarationNode](const auto& parameter){ return parameter.first == declarationNode->identifier->getID(); });
+        });
+        std::stringstream body;
+        out = &body;
+        indent = shadows ? 1 : 0;
+        if(shadows)
+            line();
+        block(functionDeclarationNode->functionBlock.get());
+        if(shadows)
+            body << "\n";
+        scopes.clear();
+        function = nullptr;
+        structure = nullptr;
+
+        definitions << signature(functionDeclarationNode, owner != nullptr ? owner->id : "") << " ";
+        if(shadows)
+            definitions << "{\n" << body.str() << "}";
+        else
+            definitions << body.str();
+        definitions << "\n\n";
+    }
+
+    void Transpiler::construct(interpreter::Struct &layout) {
+        structure = &layout;
+        // The initial values of the fields in declaration order, they can refer to the fields declared before them
+        std::stringstream init;
+        out = &init;
+        indent = 1;
+        auto& fieldTypes = fields[layout.id];
+        for(auto declarationNode : layout.fields){
+            auto type = typeOf(declarationNode);
+            // the fields of a struct are not initialised
+            if(!type.empty() && element(type) == layout.id)
+                type = "";
+            fieldTypes.emplace_back(type);
+            if(declarationNode->exprNode != nullptr){
+                currentType = declarationNode->type;
+                declarationNode->exprNode->accept(this);
+                if(currentType.empty() || type.empty()){
+                    fieldTypes.back() = "";
+                    if(calls)
+                        line() << "static_cast<void>(" << code << ");\n";
+                    continue;
+                }
+                if(type == "auto")
+                    fieldTypes.back() = currentType;
+                line() << name(declarationNode->identifier->getID()) << " = " << code << ";\n";
+            }else if(declarationNode->identifier->ilocExprNode != nullptr){
+                declarationNode->identifier->ilocExprNode->accept(this);
+                if(type.empty()){
+                    if(calls)
+                        line() << "static_cast<void>(" << code << ");\n";
+                    continue;
+                }
+                line() << name(declarationNode->identifier->getID()) << " = " << cpp(type) << "(tl::index(" << code << "));\n";
+            }else if(!type.empty() && lexer::isStruct(type)){
+                line() << name(declarationNode->identifier->getID()) << " = " << cpp(type) << "::make();\n";
+            }
+        }
+        structure = nullptr;
+
+        // The fields then the methods, the methods are defined after every struct is complete
+        forward << "struct " << name(layout.id) << ";\n";
+        structures << "struct " << name(layout.id) << " {\n";
+        for(int i = 0; i < layout.fields.size(); ++i){
+            if(fieldTypes.at(i).empty())
+                continue;
+            structures << "    " << cpp(fieldTypes.at(i)) << " " << name(layout.fields.at(i)->identifier->getID()) << "{};\n";
+        }
+        structures << "\n    // a new instance with its fields initialised, a copy of the first one when the initial values are literals\n";
+        structures << "    static " << name(layout.id) << " make();\n";
+        structures << "    void init();\n";
+        for(const auto& method : layout.methods)
+            compile(method.second, &layout);
+        for(const auto& method : layout.methods)
+            structures << "    " << signature(method.second, "") << ";\n";
+        structures << "};\n\n";
+
+        // initial values that may call functions or read globals are evaluated for every instance
+        definitions << name(layout.id) << " " << name(layout.id) << "::make() {\n";
+        if(layout.constant){
+            definitions << "    static const " << name(layout.id) << " prototype = []{ " << name(layout.id) << " self; self.init(); return self; }();\n";
+            definitions << "    return prototype;\n}\n\n";
+        }else{
+            definitions << "    " << name(layout.id) << " self;\n    self.init();\n    return self;\n}\n\n";
+        }
+        definitions << "void " << name(layout.id) << "::init() {\n" << init.str() << "}\n\n";
+    }
+
+    std::string Transpiler::path(parser::ASTIdentifierNode *identifierNode, parser::ASTIdentifierNode *last, bool write) {
+        auto type = lookup(identifierNode->identifier);
+        std::string result = identifierNode->identifier == "self" && structure != nullptr && type == structure->id
+                             ? "(*this)" : name(identifierNode->identifier);
+        bool indexed = false;
+        for(auto node = identifierNode; !type.empty(); ){
+            auto child = node->getChild().get();
+            bool end = child == nullptr || child->isEmpty() || child == last;
+            if(node->ilocExprNode != nullptr){
+                node->ilocExprNode->accept(this);
+                result += std::string(write && end ? ".write(" : ".at(") + "tl::index(" + code + "))";
+                type = element(type);
+                indexed = true;
+            }
+            if(end)
+                break;
+            // nothing is stored for arrays of structs
+            if(indexed){
+                type = "";
+                break;
+            }
+            auto s = structs.find(type);
+            type = s == structs.end() ? "auto" : field(s->second, s->second.offsets.at(child->identifier));
+            result += "." + name(child->identifier);
+            node = child;
+        }
+        currentType = type;
+        return result;
+    }
+
+    // Expressions
+    // Every expression sets code to its C++ expression and currentType to its type
+    void Transpiler::visit(parser::ASTLiteralNode<int> *literalNode) {
+        code = std::to_string(literalNode->val);
+        currentType = "int";
+        calls = false;
+    }
+
+    void Transpiler::visit(parser::ASTLiteralNode<float> *literalNode) {
+        // the shortest representation that reads back as the same float
+        char buffer[64];
+        auto end = std::to_chars(buffer, buffer + sizeof(buffer), literalNode->val).ptr;
+        code = std::string(buffer, end);
+        if(code.find_first_of(".e") == std::string::npos)
+            code += ".0";
+        code += "f";
+        currentType = "float";
+        calls = false;
+    }
+
+    void Transpiler::visit(parser::ASTLiteralNode<bool> *literalNode) {
+        code = literalNode->val ? "true" : "false";
+        currentType = "bool";
+        calls = false;
+    }
+
+    void Transpiler::visit(parser::ASTLiteralNode<char> *literalNode) {
+        code = "char(" + std::to_string((int) literalNode->val) + ")";
+        currentType = "char";
+        calls = false;
+    }
+
+    void Transpiler::visit(parser::ASTLiteralNode<std::string> *literalNode) {
+        code = "std::string(\"" + escape(literalNode->val) + "\")";
+        currentType = "string";
+        calls = false;
+    }
+
+    void Transpiler::visit(parser::ASTArrayLiteralNode *arrayLiteralNode) {
+        // the type of the expression is the declared type of the elements
+        std::string type = currentType;
+        if(lexer::isStruct(type)){
+            // nothing is stored for arrays of structs, the elements are not evaluated
+            code = "0";
+            currentType = "";
+            calls = false;
+            return;
+        }
+        // the elements of a braced list are evaluated in order
+        std::string items;
+        bool c = false;
+        for(const auto& item : arrayLiteralNode->expressions){
+            item->accept(this);
+            items += (items.empty() ? "" : ", ") + code;
+            c = c || calls;
+        }
+        code = cpp(type + "[]") + "{" + items + "}";
+        currentType = type + "[]";
+        calls = c;
+    }
+
+    void Transpiler::visit(parser::ASTBinaryNode *binaryNode) {
+        binaryNode->left->accept(this);
+        auto left = code;
+        auto leftType = currentType;
+        bool leftCalls = calls;
+        binaryNode->right->accept(this);
+        auto right = code;
+        auto rightType = currentType;
+        bool rightCalls = calls;
+
+        auto op = lexer::determineOperatorType(binaryNode->op);
+        std::string symbol = op == lexer::TOK_AND ? "&&" : op == lexer::TOK_OR ? "||" : binaryNode->op;
+        if(rightCalls){
+            // The left operand is evaluated first and both operands of and/or are always evaluated
+            code = "[&]{ auto _left = " + left + "; auto _right = " + right + "; return _left " + symbol + " _right; }()";
+        }else{
+            code = "(" + left + " " + symbol + " " + right + ")";
+        }
+        currentType = comparison(binaryNode->op) ? "bool" : leftType == rightType ? leftType : "auto";
+        calls = leftCalls || rightCalls;
+    }
+
+    void Transpiler::visit(parser::ASTIdentifierNode *identifierNode) {
+        calls = false;
+        auto result = path(identifierNode, nullptr, false);
+        bool c = calls;
+        // nothing is stored for arrays of structs
+        code = currentType.empty() ? "0" : result;
+        calls = c;
+    }
+
+    void Transpiler::visit(parser::ASTUnaryNode *unaryNode) {
+        unaryNode->exprNode->accept(this);
+        code = "tl::negate(" + code + ")";
+    }
+
+    // Tasks need the interpreter's scheduler, there is nothing for them in the generated C++
+    void Transpiler::visit(parser::ASTSpawnNode *spawnNode) {
+        throw std::runtime_error("spawn on line " + std::to_string(spawnNode->lineNumber) + " is only supported by the interpreter.");
+    }
+
+    void Transpiler::visit(parser::ASTAwaitNode *awaitNode) {
+        throw std::runtime_error("await on line " + std::to_string(awaitNode->lineNumber) + " is only supported by the interpreter.");
+    }
+
+    void Transpiler::visit(parser::ASTFunctionCallNode *functionCallNode) {
+        call(functionCallNode->identifier, functionCallNode->parameters, functionCallNode->callee);
+    }
+    // Expressions
+
+    // Statements
+    // Every statement writes its lines to the current section
+    void Transpiler::visit(parser::ASTSFunctionCallNode *sFunctionCallNode) {
+        call(sFunctionCallNode->identifier, sFunctionCallNode->parameters, sFunctionCallNode->callee);
+        line() << code << ";\n";
+    }
+
+    void Transpiler::call(const std::shared_ptr<parser::ASTIdentifierNode>& identifier, const std::vector<std::shared_ptr<parser::ASTExprNode>>& parameters,
+                          parser::ASTFunctionDeclarationNode* callee) {
+        std::vector<std::string> arguments;
+        std::vector<std::string> paramTypes;
+        bool c = false;
+        for(const auto& param : parameters){
+            param->accept(this);
+            arguments.emplace_back(code);
+            paramTypes.emplace_back(element(currentType));
+            c = c || calls;
+        }
+
+        // C++ overload resolution picks the function or method by the types of the arguments
+        std::string target;
+        std::string type = "auto";
+        if(callee != nullptr){
+            target = "::" + name(callee->identifier->getID());
+            type = result(callee);
+        }else{
+            // A method, the instance it runs on is the identifier up to its last child (this for bare calls)
+            auto method = identifier.get();
+            while(method->getChild() != nullptr && !method->getChild()->isEmpty())
+                method = method->getChild().get();
+            const interpreter::Struct* layout = nullptr;
+            if(method != identifier.get()){
+                calls = false;
+                auto receiver = path(identifier.get(), method, false);
+                c = c || calls;
+                if(currentType.empty()){
+                    // nothing is stored for arrays of structs
+                    code = "0";
+                    calls = c;
+                    return;
+                }
+                auto s = structs.find(currentType);
+                if(s != structs.end())
+                    layout = &s->second;
+                target = receiver + "." + name(method->identifier);
+            }else if(structure != nullptr && std::any_of(structure->methods.begin(), structure->methods.end(),
+                                                         [method](const auto& m){ return m.first.first == method->identifier; })){
+                layout = structure;
+                target = "this->" + name(method->identifier);
+            }else{
+                // a global function that was not resolved by the semantic pass
+                target = "::" + name(method->identifier);
+                auto range = functions.equal_range(method->identifier);
+                for(auto f = range.first; f != range.second; ++f){
+                    if(f->second->parameters.size() == arguments.size()){
+                        type = result(f->second);
+                        break;
+                    }
+                }
+            }
+            if(layout != nullptr){
+                auto m = layout->methods.find(std::make_pair(method->identifier, paramTypes));
+                if(m != layout->methods.end())
+                    type = result(m->second);
+            }
+        }
+
+        std::string list;
+        if(c && arguments.size() > 1){
+            // The arguments are evaluated in order
+            std::string temporaries;
+            for(int i = 0; i < arguments.size(); ++i){
+                temporaries += "auto _" + std::to_string(i) + " = " + arguments.at(i) + "; ";
+                list += (i == 0 ? "_" : ", _") + std::to_string(i);
+            }
+            code = "[&]{ " + temporaries + "return " + target + "(" + list + "); }()";
+        }else{
+            for(const auto& argument : arguments)
+                list += (list.empty() ? "" : ", ") + argument;
+            code = target + "(" + list + ")";
+        }
+        currentType = type;
+        calls = true;
+    }
+
+    std::string Transpiler::declaration(parser::ASTDeclarationNode *declarationNode) {
+        auto id = declarationNode->identifier->getID();
+        auto type = typeOf(declarationNode);
+        std::string value;
+        if(declarationNode->exprNode != nullptr){
+            // by setting the type we help to init an array literal
+            currentType = declarationNode->type;
+            declarationNode->exprNode->accept(this);
+            value = code;
+            if(currentType.empty())
+                type = "";
+            else if(declarationNode->type == "auto")
+                type = currentType;
+        }else if(declarationNode->identifier->ilocExprNode != nullptr){
+            // array declaration case
+            declarationNode->identifier->ilocExprNode->accept(this);
+            value = type.empty() ? code : cpp(type) + "(tl::index(" + code + "))";
+        }else{
+            // struct case, a new instance with its fields initialised (see interpreter::Struct::constant)
+            value = cpp(type) + "::make()";
+            calls = false;
+        }
+
+        // a top level declaration assigns its global
+        bool global = scopes.empty();
+        if(global)
+            globals.insert_or_assign(id, type);
+        else
+            scopes.back().insert_or_assign(id, type);
+        // nothing is stored for arrays of structs
+        if(type.empty())
+            return calls ? "static_cast<void>(" + value + ")" : "";
+        if(global)
+            return name(id) + " = " + value;
+        return cpp(type) + " " + name(id) + " = " + value;
+    }
+
+    void Transpiler::visit(parser::ASTDeclarationNode *declarationNode) {
+        auto statement = declaration(declarationNode);
+        if(!statement.empty())
+            line() << statement << ";\n";
+    }
+
+    std::string Transpiler::assignment(parser::ASTAssignmentNode *assignmentNode) {
+        assignmentNode->exprNode->accept(this);
+        auto value = code;
+        bool c = calls;
+        // nothing is stored for arrays of structs
+        if(currentType.empty())
+            return c ? "static_cast<void>(" + value + ")" : "";
+        // the value is evaluated before the target of an assignment
+        calls = false;
+        auto target = path(assignmentNode->identifier.get(), nullptr, true);
+        if(currentType.empty())
+            return c || calls ? "static_cast<void>(" + value + ")" : "";
+        return target + " = " + value;
+    }
+
+    void Transpiler::visit(parser::ASTAssignmentNode *assignmentNode) {
+        auto statement = assignment(assignmentNode);
+        if(!statement.empty())
+            line() << statement << ";\n";
+    }
+
+    void Transpiler::visit(parser::ASTPrintNode *printNode) {
+        printNode->exprNode->accept(this);
+        // nothing is printed for arrays of structs
+        if(currentType.empty()){
+            if(calls)
+                line() << "static_cast<void>(" << code << ");\n";
+            return;
+        }
+        line() << "tl::print(" << code << ");\n";
+    }
+
+    void Transpiler::visit(parser::ASTBlockNode *blockNode) {
+        line();
+        block(blockNode);
+        *out << "\n";
+    }
+
+    void Transpiler::visit(parser::ASTIfNode *ifNode) {
+        ifNode->condition->accept(this);
+        line() << "if(" << code << ") ";
+        block(ifNode->ifBlock.get());
+        if(ifNode->elseBlock != nullptr){
+            *out << " else ";
+            block(ifNode->elseBlock.get());
+        }
+        *out << "\n";
+    }
+
+    void Transpiler::visit(parser::ASTForNode *forNode) {
+        // the loop variable only lives as long as the loop
+        scopes.emplace_back();
+        std::string declaration = forNode->declaration != nullptr ? this->declaration(forNode->declaration.get()) : "";
+        forNode->condition->accept(this);
+        auto condition = code;
+        std::string assignment = forNode->assignment != nullptr ? this->assignment(forNode->assignment.get()) : "";
+        line() << "for(" << declaration << "; " << condition << "; " << assignment << ") ";
+        block(forNode->loopBlock.get());
+        *out << "\n";
+        scopes.pop_back();
+    }
+
+    void Transpiler::visit(parser::ASTWhileNode *whileNode) {
+        whileNode->condition->accept(this);
+        line() << "while(" << code << ") ";
+        block(whileNode->loopBlock.get());
+        *out << "\n";
+    }
+
+    void Transpiler::visit(parser::ASTFunctionDeclarationNode *functionDeclarationNode) {
+        // translated on its own before the top level statements
+    }
+
+    void Transpiler::visit(parser::ASTReturnNode *returnNode) {
+        returnNode->exprNode->accept(this);
+        if(function == nullptr){
+            // a return outside of a function only evaluates its expression
+            line() << "static_cast<void>(" << code << ");\n";
+            return;
+        }
+        if(function->type == "auto" && !currentType.empty())
+            types.insert(std::make_pair(function, currentType));
+        line() << "return " << (currentType.empty() ? "{}" : code) << ";\n";
+    }
+
+    void Transpiler::visit(parser::ASTStructNode *structNode) {
+        // the layout was translated before the top level statements
+    }
+    // Statements
+}
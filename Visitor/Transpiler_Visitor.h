@@ -0,0 +1,121 @@
+//
+// Translates a checked program into a self-contained C++20 translation unit.
+//
+
+#ifndef TEALANG_COMPILER_CPP20_TRANSPILER_VISITOR_H
+#define TEALANG_COMPILER_CPP20_TRANSPILER_VISITOR_H
+
+#include "Visitor.h"
+#include "Interpreter_Visitor.h"
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace visitor {
+    // Every TeaLang identifier is prefixed with tl_ so that it never clashes with C++ keywords or the runtime
+    // Functions and methods are abbreviated templates whose parameters accept both T and tl::Array<T>
+    // because the declaration of a parameter does not say whether it is an array
+    class Transpiler : public Visitor {
+    public:
+        Transpiler();
+        ~Transpiler() = default;
+
+        // The translation unit, the runtime (Runtime/Runtime.h) comes first
+        [[nodiscard]] std::string source() const;
+
+        void visit(parser::ASTProgramNode* programNode) override;
+
+        void visit(parser::ASTLiteralNode<int>* literalNode) override;
+        void visit(parser::ASTLiteralNode<float>* literalNode) override;
+        void visit(parser::ASTLiteralNode<bool>* literalNode) override;
+        void visit(parser::ASTLiteralNode<char>* literalNode) override;
+        void visit(parser::ASTLiteralNode<std::string>* literalNode) override;
+        void visit(parser::ASTArrayLiteralNode* arrayLiteralNode) override;
+        void visit(parser::ASTBinaryNode* binaryNode) override;
+        void visit(parser::ASTIdentifierNode* identifierNode) override;
+        void visit(parser::ASTUnaryNode* unaryNode) override;
+        void visit(parser::ASTSpawnNode* spawnNode) override;
+        void visit(parser::ASTAwaitNode* awaitNode) override;
+        void visit(parser::ASTFunctionCallNode* functionCallNode) override;
+
+        void visit(parser::ASTSFunctionCallNode* sFunctionCallNode) override;
+        void visit(parser::ASTDeclarationNode* declarationNode) override;
+        void visit(parser::ASTAssignmentNode* assignmentNode) override;
+        void visit(parser::ASTPrintNode* printNode) override;
+        void visit(parser::ASTBlockNode* blockNode) override;
+        void visit(parser::ASTIfNode* ifNode) override;
+        void visit(parser::ASTForNode* forNode) override;
+        void visit(parser::ASTWhileNode* whileNode) override;
+        void visit(parser::ASTFunctionDeclarationNode* functionDeclarationNode) override;
+        void visit(parser::ASTReturnNode* returnNode) override;
+        void visit(parser::ASTStructNode* structNode) override;
+
+    private:
+        // The code of the last expression, its static type ("auto" if it is only known at runtime, empty if nothing
+        // is stored for it, arrays end in []) and whether it calls a function
+        std::string code;
+        std::string currentType;
+        bool calls;
+
+        // The sections of the translation unit, in the order they are written out
+        std::stringstream forward;
+        std::stringstream structures;
+        std::stringstream prototypes;
+        std::stringstream definitions;
+        std::stringstream main;
+        // the section statements are written to and their indentation
+        std::stringstream* out;
+        int indent;
+
+        // Python equivalent of:
+        // globals = {identifier: type}
+        std::map<std::string, std::string> globals;
+        // The block scopes of the function being compiled, innermost last
+        std::vector<std::map<std::string, std::string>> scopes;
+        // the function being compiled, null for the top level statements
+        parser::ASTFunctionDeclarationNode* function;
+        // the struct whose method or initialiser is being compiled, null otherwise
+        interpreter::Struct* structure;
+        // Python equivalent of:
+        // structs = {identifier: layout}
+        std::map<std::string, interpreter::Struct> structs;
+        // fields = {identifier: [FIELD_TYPES,]}, the types of auto fields are those of their initial values
+        std::map<std::string, std::vector<std::string>> fields;
+        // functions = {identifier: functionDeclarationNode} for every global function
+        std::multimap<std::string, parser::ASTFunctionDeclarationNode*> functions;
+        // types = {functionDeclarationNode: return type}, auto functions get the type of their first return
+        std::map<parser::ASTFunctionDeclarationNode*, std::string> types;
+
+        // C++ type of a TeaLang type
+        static std::string cpp(const std::string& type);
+        static std::string name(const std::string& identifier);
+        // The type of a variable, arrays end in [] and nothing is stored for arrays of structs
+        static std::string typeOf(parser::ASTDeclarationNode* declarationNode);
+        // The type of the field at offset of a struct
+        std::string field(const interpreter::Struct& layout, std::size_t offset);
+        std::string lookup(const std::string& identifier);
+        // Start a new line of the current section
+        std::stringstream& line();
+        // Write a block, the line it opens on is already started
+        void block(parser::ASTBlockNode* blockNode);
+        // The code of a declaration and an assignment, empty if nothing is stored
+        std::string declaration(parser::ASTDeclarationNode* declarationNode);
+        std::string assignment(parser::ASTAssignmentNode* assignmentNode);
+        // The return type of a function, auto functions have the type of their first return
+        std::string result(parser::ASTFunctionDeclarationNode* functionDeclarationNode);
+
+        // The signature of a function, qualified with the struct of a method when it is defined outside of it
+        std::string signature(parser::ASTFunctionDeclarationNode* functionDeclarationNode, const std::string& owner);
+        void compile(parser::ASTFunctionDeclarationNode* functionDeclarationNode, interpreter::Struct* owner);
+        // The fields, initialiser and methods of a struct
+        void construct(interpreter::Struct& layout);
+        // The code of an identifier up to (not including) last, the type of the referenced value is set to currentType
+        // write is set for the targets of assignments
+        std::string path(parser::ASTIdentifierNode* identifierNode, parser::ASTIdentifierNode* last, bool write);
+        void call(const std::shared_ptr<parser::ASTIdentifierNode>& identifier, const std::vector<std::shared_ptr<parser::ASTExprNode>>& parameters,
+                  parser::ASTFunctionDeclarationNode* callee);
+    };
+}
+
+#endif //TEALANG_COMPILER_CPP20_TRANSPILER_VISITOR_H
@@ -17,6 +17,8 @@ namespace parser {
     class ASTFunctionCallNode;
     class ASTIdentifierNode;
     class ASTUnaryNode;
+    class ASTSpawnNode;
+    class ASTAwaitNode;
 
     class ASTSFunctionCallNode;
     class ASTDeclarationNode;
@@ -48,6 +50,8 @@ namespace visitor {
         virtual void visit(parser::ASTFunctionCallNode*) = 0;
         virtual void visit(parser::ASTIdentifierNode*) = 0;
         virtual void visit(parser::ASTUnaryNode*) = 0;
+        virtual void visit(parser::ASTSpawnNode*) = 0;
+        virtual void visit(parser::ASTAwaitNode*) = 0;
 
         virtual void visit(parser::ASTSFunctionCallNode*) = 0;
         virtual void visit(parser::ASTDeclarationNode*) = 0;
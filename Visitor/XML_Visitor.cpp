@@ -155,6 +155,32 @@ namespace visitor {
         xmlfile << indentation() << "</unary>" << std::endl;
     }
 
+    void XMLVisitor::visit(parser::ASTSpawnNode *spawnNode) {
+        // Add initial <spawn> tag
+        xmlfile << indentation() << "<spawn>" << std::endl;
+        // Add indentation level
+        indentationLevel++;
+        // The call
+        spawnNode->call->accept(this);
+        // Remove indentation level
+        indentationLevel--;
+        // Add closing tag
+        xmlfile << indentation() << "</spawn>" << std::endl;
+    }
+
+    void XMLVisitor::visit(parser::ASTAwaitNode *awaitNode) {
+        // Add initial <await> tag
+        xmlfile << indentation() << "<await>" << std::endl;
+        // Add indentation level
+        indentationLevel++;
+        // The handle
+        awaitNode->exprNode->accept(this);
+        // Remove indentation level
+        indentationLevel--;
+        // Add closing tag
+        xmlfile << indentation() << "</await>" << std::endl;
+    }
+
     void XMLVisitor::visit(parser::ASTFunctionCallNode *functionCallNode) {
         // Add initial <functionEcall> tag
         xmlfile << indentation() << "<functionEcall>" << std::endl;
@@ -32,6 +32,8 @@ namespace visitor{
         void visit(parser::ASTBinaryNode* binaryNode) override;
         void visit(parser::ASTIdentifierNode* identifierNode) override;
         void visit(parser::ASTUnaryNode* unaryNode) override;
+        void visit(parser::ASTSpawnNode* spawnNode) override;
+        void visit(parser::ASTAwaitNode* awaitNode) override;
         void visit(parser::ASTFunctionCallNode* functionCallNode) override;
 
         void visit(parser::ASTSFunctionCallNode* sFunctionCallNode) override;
@@ -1,12 +1,46 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
+#include <thread>
 #include "Lexer/Lexer.h"
 #include "Parser/Parser.h"
 #include "Visitor/XML_Visitor.h"
 #include "Visitor/Semantic_Visitor.h"
 #include "Visitor/Interpreter_Visitor.h"
+#include "Visitor/Compiler_Visitor.h"
+#include "Visitor/Closure_Visitor.h"
+#include "Visitor/Transpiler_Visitor.h"
+#include "VM/VM.h"
+#include "Batch/Batch.h"
+#include "Program/Compiled_Program.h"
 
 int main(int argc, char **argv) {
 
+    if(argc >= 3 && std::string("--batch") == argv[1]){
+        // Interpret every script of a directory or list file in this process, $TEALANG_JOBS at a time (one per hardware thread by default)
+        // each prints to stdout in turn, how it went is reported on stderr
+        const char* jobs = std::getenv("TEALANG_JOBS");
+        const char* stack = std::getenv("TEALANG_STACK");
+        auto scripts = batch::scripts(argv[2]);
+        std::size_t failed = 0;
+        auto start = std::chrono::steady_clock::now();
+        batch::run(scripts, jobs != nullptr ? std::stoul(jobs) : 0,
+                   stack != nullptr ? std::stoul(stack) : visitor::Interpreter::defaultCapacity, std::getenv("TEALANG_RELAXED") != nullptr,
+                   [&failed](const batch::Result& result){
+            std::cout << result.output << std::flush;
+            if(result.status != 0){
+                ++failed;
+                std::cerr << result.error << std::endl;
+            }
+            std::cerr << result.path.string() << ": exit " << result.status << ", " << result.seconds * 1000 << "ms, "
+                      << (result.seconds > 0 ? (std::size_t) (result.tokens / result.seconds) : 0) << " tokens/s" << std::endl;
+        });
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::cerr << scripts.size() << " scripts, " << failed << " failed in " << elapsed.count() << "ms" << std::endl;
+        return failed == 0 ? 0 : 1;
+    }
+
     std::string _program_;
     if(argv[2] == std::string("-p")){
         std::ifstream file(argv[3]);
@@ -61,8 +95,16 @@ int main(int argc, char **argv) {
     }else if (std::string("-i") == argv[1]){
 //        std::cout << "TESTING Interpreter" <<  std::endl;
 
+        program::CompiledProgram compiled(_program_);
+
+        // $TEALANG_STACK sets how many calls may be nested, $TEALANG_RELAXED lets float sums be added in any order
+        const char* stack = std::getenv("TEALANG_STACK");
+        compiled.run({}, std::cout, stack != nullptr ? std::stoul(stack) : visitor::Interpreter::defaultCapacity,
+                     std::getenv("TEALANG_RELAXED") != nullptr);
+    }else if (std::string("-b") == argv[1]){
+        // Compile to bytecode and run it on the VM
         lexer::Lexer lexer;
-        lexer.extractLexemes(_program_); //argv[2]
+        lexer.extractLexemes(_program_);
 
         parser::Parser parser(lexer.tokens);
         auto programNode = std::shared_ptr<parser::ASTProgramNode>(parser.parseProgram());
@@ -71,10 +113,108 @@ int main(int argc, char **argv) {
         auto *programNode1 = new parser::ASTProgramNode(programNode);
         semanticAnalyser.visit(programNode1);
 
-        visitor::Interpreter interpreter;
-        interpreter.visit(programNode1);
+        visitor::Compiler compiler;
+        compiler.visit(programNode1);
+        vm::VM vm(compiler.program);
+        vm.run();
 
         delete programNode1;
+    }else if (std::string("-f") == argv[1]){
+        // Compile to a tree of closures and run it
+        lexer::Lexer lexer;
+        lexer.extractLexemes(_program_);
+
+        parser::Parser parser(lexer.tokens);
+        auto programNode = std::shared_ptr<parser::ASTProgramNode>(parser.parseProgram());
+
+        visitor::SemanticAnalyser semanticAnalyser;
+        auto *programNode1 = new parser::ASTProgramNode(programNode);
+        semanticAnalyser.visit(programNode1);
+
+        visitor::ClosureCompiler compiler;
+        compiler.visit(programNode1);
+        compiler.program.run();
+
+        delete programNode1;
+    }else if (std::string("-c") == argv[1]){
+        // Translate to C++ and build a native executable next to the program with the system compiler ($CXX)
+        lexer::Lexer lexer;
+        lexer.extractLexemes(_program_);
+
+        parser::Parser parser(lexer.tokens);
+        auto programNode = std::shared_ptr<parser::ASTProgramNode>(parser.parseProgram());
+
+        visitor::SemanticAnalyser semanticAnalyser;
+        auto *programNode1 = new parser::ASTProgramNode(programNode);
+        semanticAnalyser.visit(programNode1);
+
+        visitor::Transpiler transpiler;
+        transpiler.visit(programNode1);
+        delete programNode1;
+
+        auto executable = argv[2] == std::string("-p") ? std::filesystem::path(argv[3]).replace_extension() : std::filesystem::path("program");
+        auto source = std::filesystem::path(executable).replace_extension(".cpp");
+        std::ofstream file(source);
+        file << transpiler.source();
+        file.close();
+        if(!file)
+            throw std::runtime_error("Unable to write " + source.string() + "!");
+
+        const char* compiler = std::getenv("CXX");
+        // signed overflow wraps like it does in the interpreter
+        auto command = std::string(compiler != nullptr ? compiler : "c++") + " -std=c++20 -O2 -fwrapv -o \"" + executable.string()
+                       + "\" \"" + source.string() + "\"";
+        if(std::system(command.c_str()) != 0)
+            throw std::runtime_error("Unable to compile " + source.string() + "!");
+    }else if (std::string("--watch") == argv[1] && argv[2] == std::string("-p")){
+        // Re check and run the file every time it changes
+        // The analyser is kept between runs so that only the changed declarations are checked again
+        visitor::SemanticAnalyser semanticAnalyser;
+        std::filesystem::file_time_type lastWrite;
+        std::string lastProgram;
+        bool first = true;
+        while(true){
+            std::error_code error;
+            auto write = std::filesystem::last_write_time(argv[3], error);
+            if(!error && (first || write != lastWrite)){
+                lastWrite = write;
+                std::ifstream file(argv[3]);
+                std::stringstream ss;
+                ss << file.rdbuf();
+                // editors may touch the file without changing it
+                if(first || ss.str() != lastProgram){
+                    first = false;
+                    lastProgram = ss.str();
+                    try{
+                        auto start = std::chrono::steady_clock::now();
+                        lexer::Lexer lexer;
+                        lexer.extractLexemes(lastProgram);
+
+                        parser::Parser parser(lexer.tokens);
+                        auto programNode = std::shared_ptr<parser::ASTProgramNode>(parser.parseProgram());
+                        auto programNode1 = std::make_unique<parser::ASTProgramNode>(programNode);
+                        bool passed = true;
+                        try{
+                            semanticAnalyser.visit(programNode1.get());
+                        }catch(const std::exception& e){
+                            std::cerr << e.what() << std::endl;
+                            passed = false;
+                        }
+                        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+                        std::cerr << "checked " << semanticAnalyser.checked << ", reused " << semanticAnalyser.reused
+                                  << " declarations in " << elapsed.count() << "ms" << std::endl;
+
+                        if(passed){
+                            visitor::Interpreter interpreter;
+                            interpreter.visit(programNode1.get());
+                        }
+                    }catch(const std::exception& e){
+                        std::cerr << e.what() << std::endl;
+                    }
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
     }
     return 0;
 }
\ No newline at end of file